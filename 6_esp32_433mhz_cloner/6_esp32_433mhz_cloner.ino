@@ -1,28 +1,77 @@
 
 // Libraries
 #include <RCSwitch.h>
+#include <LittleFS.h>
+#include "RcSwitchReceiverAdapter.h"
+#include "TransmitQueue.h"
+#include "SignalStore.h"
+#include "SignalLog.h"
+#include "CommandParser.h"
+#include "EventOutput.h"
+#include "SignalDump.h"
+#include "TaskScheduler.h"
+#include "PacketNotifier.h"
+#include "LightSleep.h"
+#include "CodeLayout.h"
 
 // Pinout declaration
 int builtInLed = 2;  // Built-in LED pin (GPIO2)
-int rfReceiverPin = 21;
+const int rfReceiverPin = 21;
 int rfTransmitterPin = 22; 
 
 // Additional variables needed through the code
-unsigned long currentSecounds, previousSecoundsRecord;
-String receivedCommand;
-String commandToSend;
-
-unsigned long receivedCodes[100];
-int receivedProtocols[100];
-int receiverCounter = 0;
-bool canStoreCurrentCode = true;
-unsigned long previousMillisLed = 0;
-bool blinkLed = false;
-int ledCounter = 0;
+TaskScheduler scheduler; // Runs the tasks of loop(), none of them waits
+PacketNotifier packetNotifier; // Wakes loop() when the receiver has a code
+const unsigned long idleWaitMillis = 10; // Longest sleep while idle, serial input is polled
+bool lowPowerReceive = false; // 'sleep on': light sleep while idle, the decoder buffers edges until a sync pulse (see README)
+LightSleep lightSleep; // Woken by the receiver pin, serial input or the next due task
+const unsigned long lightSleepMaxMillis = 1000; // Longest light sleep, serial input wakes it up
+const bool storeMarginalSignals = false; // Captures with marginal timing are shown, but not stored
+CommandParser commandParser; // Text lines and binary frames, no heap use
+EventOutput eventOutput(Serial); // One write per event, no heap use
+unsigned long loopCount = 0;
+unsigned long loopMicrosTotal = 0;
+unsigned long loopMicrosMax = 0;
+unsigned long lastCommandByteMillis = 0;
+
+SignalStore signalStore; // Oldest unused signal is replaced when full
+HcsCodeLayout hcsCodeLayout;
+CodeLayouts codeLayouts; // Rolling codes are stored by their fixed ID
+FileSignalLogStorage signalLogStorage("/littlefs/signals.log");
+SignalLog signalLog(signalLogStorage); // Keeps the stored signals across resets
+bool signalLogReady = false;
+SignalDump signalDump(signalStore, eventOutput); // "refresh data" listing, a few signals per loop()
+int ledBlinks = 0; // Blinks left to show, one per 200 ms
+uint32_t sendAllAfterId = 0; // 'send all' queues the signals after this ID
+uint32_t sendAllLastId = 0; // up to this one, 0 while no 'send all' is running
+bool rawCapture = false; // 'raw on': RCSwitch receives and keeps the frames of unknown protocols
+uint32_t rawFrameHash = 0; // The latest raw frame reported
+uint16_t rawFrameHits = 0;
+RCSwitch::Waveform rawReplayWaveform; // The raw frame 'raw send' queued last
+const uint32_t rawReplayId = 0xFFFFFFFF; // Its ID in the transmit queue, no stored signal gets it
+bool ledOn = false;
 
 RCSwitch mySwitch = RCSwitch();
+RcSwitchReceiverAdapter<rfReceiverPin> rfReceiver;
+TransmitQueue transmitQueue(mySwitch);
+
+// Called by the receiver for a code: from its interrupt handler, or from
+// wake() in loop() for the buffered edges
+TEXT_ISR_ATTR_0 void notifyLoop() {
+  if (xPortInIsrContext()) {
+    packetNotifier.notifyFromIsr();
+  } else {
+    packetNotifier.notify();
+  }
+}
+
+// Called by the receiver's interrupt handler for a wake request
+TEXT_ISR_ATTR_0 void wakeLoop() {
+  packetNotifier.wakeFromIsr();
+}
 
 void setup() {
+  Serial.setTxBufferSize(1024); // Events are written without waiting for the UART
   Serial.begin(115200);
   delay(1000); // Give time for serial to initialize
   Serial.println("\n\n==========================================");
@@ -37,174 +86,501 @@ void setup() {
   Serial.println("\nAvailable Commands:");
   Serial.println("-------------------");
   Serial.println("1. 'refresh data' - Get all stored codes");
+  Serial.println("   'refresh since <id> [<limit>]' - Get the codes stored after #id");
   Serial.println("2. 'code|protocol' - Send a specific code");
   Serial.println("   Example: '12345|1'");
   Serial.println("3. 'clear signals' - Clear all stored signals");
+  Serial.println("4. 'send all' - Send all stored codes back-to-back");
+  Serial.println("5. 'tx stats' - Show transmit queue statistics");
+  Serial.println("6. 'sys stats' - Show heap, loop and task latency");
+  Serial.println("7. 'raw on' / 'raw off' - Capture frames of unknown protocols");
+  Serial.println("   'raw list' - List them, 'raw send <n>' - Replay frame #n");
+  Serial.println("8. 'sleep on' / 'sleep off' - Light sleep while idle, see 'sys stats'");
+  Serial.println("Binary frames are accepted as well, see CommandParser.h");
   Serial.println("\nWaiting for commands...");
   Serial.println("==========================================\n");
   
-  mySwitch.enableReceive(rfReceiverPin);
+  packetNotifier.attach();
+  rfReceiver.setAvailableCallback(notifyLoop);
+  rfReceiver.setWakeCallback(wakeLoop);
+  lightSleep.begin(rfReceiverPin);
+  codeLayouts.add(&hcsCodeLayout);
+  rfReceiver.enableReceive();
   mySwitch.enableTransmit(rfTransmitterPin);
+  loadStoredSignals();
+  transmitQueue.setJobDoneCallback(onTransmitJobDone);
+  transmitQueue.setWaveformSource(findStoredWaveform);
   pinMode(builtInLed, OUTPUT);
   digitalWrite(builtInLed, HIGH); // Turn on LED to show setup is complete
   delay(500);
   digitalWrite(builtInLed, LOW);
+
+  scheduler.add("serial rx", receiveSerialData);
+  scheduler.add("rf decode", decodeRfSignals);
+  scheduler.add("rf tx", runTransmitQueue);
+  scheduler.add("listing", runSignalDump);
+  scheduler.add("raw rx", runRawCapture);
+  scheduler.add("led", updateLed, 100);
+  scheduler.add("status", printStatus, 4000);
 }
 
 void loop() {
-  currentSecounds = millis() / 1000;
-  receiveSerialData();
-  decodeRfSignals();
-  checkLedState();
-  
-  if ((currentSecounds - previousSecoundsRecord) >= 4) {
-    previousSecoundsRecord = currentSecounds;
-    Serial.println("\n[System Status] Active and waiting for commands...\n");
+  unsigned long loopStartMicros = micros();
+  scheduler.run();
+
+  unsigned long loopMicros = micros() - loopStartMicros;
+  loopCount++;
+  loopMicrosTotal += loopMicros;
+  if (loopMicros > loopMicrosMax) {
+    loopMicrosMax = loopMicros;
   }
+
+  // Sleep until a code is received or a timed task is due
+  if (isIdle()) {
+    unsigned long waitMillis = scheduler.millisUntilDue(idleWaitMillis);
+    if (lowPowerReceive && !rawCapture) {
+      rfReceiver.sleep(); // Edges are only buffered until a sync pulse wakes us
+      Serial.flush(); // The UART stops in light sleep
+      if (lightSleep.sleep(scheduler.millisUntilDue(lightSleepMaxMillis))) {
+        waitMillis = 0; // Whatever woke us is handled right away
+      }
+    }
+    packetNotifier.wait(waitMillis);
+    rfReceiver.wake();
+  }
+}
+
+bool isIdle() {
+  return !rfReceiver.available() && transmitQueue.isIdle() && sendAllLastId == 0 && !signalDump.active()
+    && !Serial.available() && !commandParser.pending();
+}
+
+void runTransmitQueue() {
+  refillSendAll();
+  transmitQueue.run();
+}
+
+void runSignalDump() {
+  signalDump.run(Serial.availableForWrite());
+}
+
+void printStatus() {
+  eventOutput.printf("\n[System Status] Active and waiting for commands...\n\n");
 }
 
 void receiveSerialData() {
-  if (Serial.available()) {
-    receivedCommand = Serial.readStringUntil('\n');
-    receivedCommand.trim();
-    receivedCommand.toLowerCase();
-    
-    Serial.println("\n[Command Received] " + receivedCommand);
-    
-    if (receivedCommand == "refresh data") {
-      sendCurrentRfData();
-    } else if (receivedCommand == "clear signals") {
+  while (Serial.available()) {
+    lastCommandByteMillis = millis();
+    if (commandParser.feed(Serial.read())) {
+      executeCommand(commandParser.command());
+    }
+  }
+  // Same 1 s timeout as readStringUntil() for terminals without line ending
+  if (commandParser.pending() && (unsigned long)(millis() - lastCommandByteMillis) >= 1000) {
+    if (commandParser.timeout()) {
+      executeCommand(commandParser.command());
+    }
+  }
+}
+
+void executeCommand(const CommandParser::Command& command) {
+  Serial.print("\n[Command Received] ");
+  if (command.binary) {
+    Serial.print("frame, opcode ");
+    Serial.println((int)command.opcode);
+  } else {
+    Serial.println(commandParser.text());
+  }
+
+  // Binary clients get binary events
+  eventOutput.setBinary(command.binary);
+
+  uint8_t status = 0; // 0 done, 1 invalid, 2 failed
+  switch (command.opcode) {
+    case CommandParser::CMD_REFRESH:
+      signalDump.begin(command.sinceId, command.limit);
+      break;
+    case CommandParser::CMD_FIND:
+      signalDump.beginMatching(command.code, command.mask, command.bitLength);
+      break;
+    case CommandParser::CMD_CLEAR:
       clearAllSignals();
-    } else if (receivedCommand.indexOf("|") != -1) {
-      int codeForSend = receivedCommand.substring(0, receivedCommand.indexOf("|")).toInt();
-      int protocolForSend = receivedCommand.substring(receivedCommand.indexOf("|")+1).toInt();
+      break;
+    case CommandParser::CMD_SEND_ALL:
+      sendAllStoredCodes();
+      break;
+    case CommandParser::CMD_TX_STATS:
+      printTransmitStats();
+      break;
+    case CommandParser::CMD_SYS_STATS:
+      printSystemStats();
+      break;
+    case CommandParser::CMD_RAW_CAPTURE:
+      setRawCapture(command.code != 0);
+      break;
+    case CommandParser::CMD_LOW_POWER:
+      lowPowerReceive = command.code != 0;
+      eventOutput.printf("[Info] Light sleep while idle %s\n", lowPowerReceive ? "on, the first byte of a command is lost" : "off");
+      break;
+    case CommandParser::CMD_RAW_LIST:
+      listRawFrames();
+      break;
+    case CommandParser::CMD_RAW_SEND:
+      if (!sendRawFrame(command.code)) {
+        status = 2;
+      }
+      break;
+    case CommandParser::CMD_SEND_CODE:
       Serial.println("\n[Transmit]");
-      Serial.println("Code: " + String(codeForSend));
-      Serial.println("Protocol: " + String(protocolForSend));
-      sendCodeOverRfModule(codeForSend, protocolForSend);
-    }
+      Serial.print("Code: ");
+      Serial.println(command.code);
+      Serial.print("Protocol: ");
+      Serial.println((int)command.protocol);
+      if (!sendCodeOverRfModule(command.code, command.protocol, command.bitLength)) {
+        status = 2;
+      }
+      break;
+    default:
+      Serial.println("[Error] Unknown command");
+      status = 1;
+      break;
+  }
+
+  if (command.binary) {
+    uint8_t ack[6];
+    size_t ackLength = CommandParser::encodeFrame(CommandParser::CMD_ACK | command.opcode, &status, 1, ack);
+    Serial.write(ack, ackLength);
   }
 }
 
-void sendCurrentRfData() {
-  if (receiverCounter != 0) {
-    Serial.println("\n[Stored Codes]");
-    Serial.println("----------------");
-    for (int i=0; i<receiverCounter; i++) {
-      commandToSend = String(receivedCodes[i])+"|"+String(receivedProtocols[i]);
-      Serial.println("Signal #" + String(i+1) + ": " + commandToSend);
-      delay(200);
-    }
-    Serial.println("----------------");
-    Serial.println("Total signals: " + String(receiverCounter));
+bool sendCodeOverRfModule(unsigned long code, int protocol, int bitLength) {
+  ledBlinks = 2;
+
+  // Single codes jump ahead of a running 'send all' burst
+  bool queued;
+  SignalStore::Signal* signal = signalStore.find(code, protocol, bitLength);
+  if ((signal != NULL && !isReplayable(signal)) || bitLength > 32) {
+    Serial.println("[Error] Codes longer than 32 bits are not replayed");
+    return false;
+  }
+  if (signal != NULL) {
+    signalStore.touch(signal);
+    queued = transmitQueue.enqueueSignal(signal->id, 10, 1);
   } else {
+    queued = transmitQueue.enqueue(code, protocol, 10, 1, bitLength != 0 ? bitLength : 24);
+  }
+
+  if (!queued) {
+    Serial.println("[Error] Transmit queue full, code not sent");
+  }
+  return queued;
+}
+
+void sendAllStoredCodes() {
+  if (signalStore.size() == 0) {
     Serial.println("\n[Info] No codes stored in memory");
+    return;
+  }
+  // The store holds more signals than the queue, they are queued as it drains
+  sendAllAfterId = 0;
+  sendAllLastId = 0;
+  unsigned int replayable = 0;
+  for (unsigned int i=0; i<signalStore.capacity(); i++) {
+    SignalStore::Signal* signal = signalStore.at(i);
+    if (signal != NULL && isReplayable(signal)) {
+      replayable++;
+      if (signal->id > sendAllLastId) {
+        sendAllLastId = signal->id;
+      }
+    }
   }
+  refillSendAll();
+  eventOutput.printf("[Info] Sending %u signals, %u not replayable\n", replayable, signalStore.size() - replayable);
 }
 
-void sendCodeOverRfModule(int code, int protocol) {
-  // First blink
-  blinkLed = true;
-  while(blinkLed) {
-    checkLedState();
+// Called before each run of the transmit queue while 'send all' is running
+void refillSendAll() {
+  // Half of the queue is kept free for single codes, they jump ahead
+  while (sendAllLastId != 0 && transmitQueue.room() > TRANSMIT_QUEUE_CAPACITY / 2) {
+    SignalStore::Signal* signal = signalStore.nextById(sendAllAfterId);
+    if (signal == NULL || signal->id > sendAllLastId) {
+      sendAllLastId = 0;
+      break;
+    }
+    sendAllAfterId = signal->id;
+    if (isReplayable(signal)) {
+      transmitQueue.enqueueSignal(signal->id, 10, 0);
+    }
   }
-  delay(100);
-  
-  // Second blink
-  blinkLed = true;
-  while(blinkLed) {
-    checkLedState();
+}
+
+// Queued signals are looked up when they are sent, they may be gone by then
+const RCSwitch::Waveform* findStoredWaveform(uint32_t id) {
+  if (id == rawReplayId) {
+    return &rawReplayWaveform;
   }
-  
-  mySwitch.setProtocol(protocol);
-  mySwitch.send(code, 24);
+  SignalStore::Signal* signal = signalStore.findById(id);
+  return (signal != NULL && isReplayable(signal)) ? &signal->waveform : NULL;
+}
+
+void onTransmitJobDone(const TransmitQueue::Job& job) {
   Serial.println("[Success] Code transmitted successfully");
 }
 
-void decodeRfSignals() {
-  if (mySwitch.available()) {
-    blinkLed = true;
-    unsigned long receivedValue = mySwitch.getReceivedValue();
-    int receivedProtocol = mySwitch.getReceivedProtocol();
-    int receivedBitlength = mySwitch.getReceivedBitlength();
-    int receivedDelay = mySwitch.getReceivedDelay();
-    
-    Serial.println("\n[Signal Received]");
-    Serial.println("----------------");
-    Serial.println("Code: " + String(receivedValue));
-    Serial.println("Protocol: " + String(receivedProtocol));
-    Serial.println("Bit Length: " + String(receivedBitlength) + " bits");
-    Serial.println("Delay: " + String(receivedDelay) + " µs");
-    
-    // Add protocol description based on known protocols
-    String protocolDesc = "Unknown Protocol";
-    switch(receivedProtocol) {
-      case 1: protocolDesc = "PT2262"; break;
-      case 2: protocolDesc = "Standard"; break;
-      case 3: protocolDesc = "Standard"; break;
-      case 4: protocolDesc = "Standard"; break;
-      case 5: protocolDesc = "Standard"; break;
-      case 6: protocolDesc = "HT6P20B"; break;
-      case 7: protocolDesc = "HS2303-PT"; break;
-      case 8: protocolDesc = "Conrad RS-200 RX"; break;
-      case 9: protocolDesc = "Conrad RS-200 TX"; break;
-      case 10: protocolDesc = "1ByOne Doorbell"; break;
-      case 11: protocolDesc = "HT12E"; break;
-      case 12: protocolDesc = "SM5212"; break;
+void printTransmitStats() {
+  const TransmitQueue::Stats& stats = transmitQueue.stats();
+  eventOutput.printf(
+    "\n[Transmit Stats]\n"
+    "----------------\n"
+    "Codes sent: %lu\n"
+    "Frames sent: %lu\n"
+    "Dropped: %lu, rejected: %lu, cancelled: %lu\n"
+    "Pending: %u\n"
+    "Throughput: %.2f codes/s\n"
+    "Max gap: %lu µs\n"
+    "Self-echo edges ignored: %lu\n"
+    "----------------\n",
+    (unsigned long)stats.codesSent, (unsigned long)stats.framesSent, (unsigned long)stats.droppedJobs,
+    (unsigned long)stats.rejectedJobs, (unsigned long)stats.cancelledJobs, (unsigned int)transmitQueue.pending(), (double)transmitQueue.codesPerSecond(),
+    (unsigned long)stats.maxGapMicros, (unsigned long)rfReceiver.getSelfEchoCount());
+}
+
+void printSystemStats() {
+  const EventOutput::Stats& stats = eventOutput.stats();
+  const RcSwitch::EdgeCapture::Statistics& wakeStats = rfReceiver.getWakeStatistics();
+  const LightSleep::Stats& sleepStats = lightSleep.stats();
+  eventOutput.printf(
+    "\n[System Stats]\n"
+    "----------------\n"
+    "Free heap: %lu bytes\n"
+    "Lowest free heap: %lu bytes\n"
+    "Largest free block: %lu bytes\n"
+    "Loop time: %lu µs average, %lu µs max\n"
+    "Events: %lu, %lu bytes, %lu truncated\n"
+    "Longest event write: %lu µs\n"
+    "Packets notified: %lu\n"
+    "Receiver wakes: %lu, latency %lu µs last, %lu µs max, %lu packets missed\n"
+    "Light sleep %s: %lu sleeps, %lu ms asleep\n"
+    "Light sleep wakes: pin %lu (%lu with a packet), serial %lu, timer %lu (latency %lu µs last, %lu µs max)\n",
+    (unsigned long)ESP.getFreeHeap(), (unsigned long)ESP.getMinFreeHeap(), (unsigned long)ESP.getMaxAllocHeap(),
+    loopCount != 0 ? loopMicrosTotal / loopCount : 0, loopMicrosMax,
+    stats.events, stats.bytes, stats.truncated, stats.maxWriteMicros, packetNotifier.notifications(),
+    (unsigned long)wakeStats.wakeCount, (unsigned long)wakeStats.usecLastWakeLatency,
+    (unsigned long)wakeStats.usecMaxWakeLatency, (unsigned long)wakeStats.missedPackets,
+    lowPowerReceive ? "on" : "off", sleepStats.sleeps, sleepStats.millisAsleep,
+    sleepStats.pinWakes, sleepStats.pinWakesWithPacket, sleepStats.serialWakes, sleepStats.timerWakes,
+    sleepStats.usecLastTimerLatency, sleepStats.usecMaxTimerLatency);
+  for (unsigned int i=0; i<scheduler.size(); i++) {
+    const TaskScheduler::Task& task = scheduler.task(i);
+    eventOutput.printf("Task %-10s %8lu runs, %lu µs average, %lu µs max\n",
+      task.name, task.runs, task.runs != 0 ? task.totalMicros / task.runs : 0, task.maxMicros);
+  }
+  eventOutput.printf("----------------\n");
+  // Each report covers the time since the last one
+  loopCount = 0;
+  loopMicrosTotal = 0;
+  loopMicrosMax = 0;
+  scheduler.resetStats();
+  eventOutput.resetStats();
+}
+
+void loadStoredSignals() {
+  if (!LittleFS.begin(true)) {
+    Serial.println("[Error] Flash file system not mounted, signals are not saved");
+    return;
+  }
+  signalLogReady = signalLog.load(signalStore);
+  if (!signalLogReady) {
+    Serial.println("[Error] Signal library not readable, signals are not saved");
+    return;
+  }
+  for (unsigned int i=0; i<signalStore.capacity(); i++) {
+    SignalStore::Signal* signal = signalStore.at(i);
+    if (signal != NULL) {
+      compileStoredSignal(signal);
     }
-    Serial.println("Protocol Type: " + protocolDesc);
-    
-    // Add signal quality information
-    String signalQuality = "Good";
-    if (receivedDelay > 5000) {
-      signalQuality = "Poor (High Delay)";
-    } else if (receivedBitlength < 12) {
-      signalQuality = "Poor (Short Bit Length)";
+  }
+  if (signalLog.stats().droppedTail) {
+    Serial.println("[Info] Damaged end of the signal library dropped");
+  }
+  eventOutput.printf("[Info] Loaded %u signals from flash\n", signalStore.size());
+}
+
+// A rolling code is stored by its fixed ID with the length of the whole
+// frame, over 32 bits. Its waveform stays empty, it is not replayed.
+bool isReplayable(const SignalStore::Signal* signal) {
+  return signal->waveform.count != 0;
+}
+
+void compileStoredSignal(SignalStore::Signal* signal) {
+  // Replay with the timing of the remote, not the protocol's default
+  mySwitch.setProtocol(signal->protocol, signal->pulseLength);
+  mySwitch.compileWaveform(signal->code, signal->bitLength, signal->waveform);
+}
+
+void saveStoredSignal(SignalStore::Signal* signal) {
+  if (signalLogReady && !(signalLog.logAdd(*signal) && signalLog.compactIfNeeded(signalStore))) {
+    Serial.println("[Error] Signal not saved to flash");
+  }
+}
+
+void decodeRfSignals() {
+  if (rfReceiver.available()) {
+    lightSleep.packetReceived();
+    if (ledBlinks == 0) {
+      ledBlinks = 1;
     }
-    Serial.println("Signal Quality: " + signalQuality);
-    Serial.println("----------------");
-    
-    for (int i=0; i<receiverCounter; i++) {
-      if (receivedCodes[i] == receivedValue) {
-        canStoreCurrentCode = false;
-        break;
+    unsigned long receivedValue = rfReceiver.getReceivedValue();
+    int receivedProtocol = rfReceiver.getReceivedProtocol();
+    int receivedBitlength = rfReceiver.getReceivedBitlength();
+    int receivedDelay = rfReceiver.getReceivedDelay();
+
+    CodeLayout::Frame frame;
+    frame.code = receivedValue;
+    frame.overflow = rfReceiver.getReceivedOverflowValue();
+    frame.protocol = receivedProtocol;
+    frame.bitLength = receivedBitlength;
+    CodeLayout::Fields fields;
+    const CodeLayout* layout = codeLayouts.split(frame, fields);
+    // Every press of a rolling code remote is another code, but the same device
+    unsigned long storedValue = (layout != NULL) ? fields.fixedId : receivedValue;
+
+    EventOutput::SignalEvent event;
+    event.code = receivedValue;
+    event.protocol = receivedProtocol;
+    event.bitLength = receivedBitlength;
+    event.pulseLength = receivedDelay;
+    event.meanDeviation = rfReceiver.getReceivedMeanDeviation();
+    event.maxDeviation = rfReceiver.getReceivedMaxDeviation();
+    event.jitter = rfReceiver.getReceivedJitter();
+    event.maxDeviationPercent = rfReceiver.getReceivedMaxDeviationPercent();
+    event.jitterPercent = rfReceiver.getReceivedJitterPercent();
+    event.layout = (layout != NULL) ? layout->name() : NULL;
+    event.fixedId = (layout != NULL) ? fields.fixedId : 0;
+    event.varying = (layout != NULL) ? fields.varying : 0;
+
+    // A distorted capture would be replayed as a wrong code
+    event.id = 0;
+    event.storeResult = SignalStore::SIGNAL_NOT_STORED;
+    if (storeMarginalSignals || !EventOutput::isMarginal(event)) {
+      // A full store replaces its least recently used signal
+      SignalStore::Signal* signal = signalStore.leastRecentlyUsed();
+      uint32_t evictedId = (signalStore.size() == signalStore.capacity() && signal != NULL) ? signal->id : 0;
+      SignalStore::AddResult result = signalStore.add(storedValue, receivedProtocol, receivedBitlength, receivedDelay, signal);
+      if (result == SignalStore::SIGNAL_REPLACED) {
+        transmitQueue.cancel(evictedId);
+      }
+      if (result != SignalStore::SIGNAL_EXISTS) {
+        compileStoredSignal(signal);
+        saveStoredSignal(signal);
       }
+      event.id = signal->id;
+      event.storeResult = result;
     }
+    event.storedCount = signalStore.size();
+    eventOutput.signal(event);
 
-    if (canStoreCurrentCode) {
-      receivedCodes[receiverCounter] = receivedValue;
-      receivedProtocols[receiverCounter] = receivedProtocol;
-      receiverCounter++;
-      Serial.println("[Info] Signal stored successfully");
-      Serial.println("Total signals: " + String(receiverCounter));
-    } else {
-      Serial.println("[Info] Signal already exists in memory");
-    }
+    rfReceiver.resetAvailable();
+  }
+}
 
-    canStoreCurrentCode = true;
+// RcSwitchReceiver decodes the known protocols only, RCSwitch receives
+// instead while the raw capture is on
+void setRawCapture(bool on) {
+  if (on == rawCapture) {
+    return;
+  }
+  if (on) {
+    rfReceiver.disableReceive();
+    mySwitch.enableReceive(digitalPinToInterrupt(rfReceiverPin));
+    mySwitch.enableRawCapture(rfReceiverPin);
+  } else {
+    mySwitch.disableRawCapture();
+    mySwitch.disableReceive();
+    rfReceiver.enableReceive();
+  }
+  rawCapture = on;
+  eventOutput.printf("[Info] Raw capture %s\n", on ? "on, received codes are not stored" : "off");
+}
+
+// Reports the raw frames as they are captured or received again
+void runRawCapture() {
+  if (!rawCapture) {
+    return;
+  }
+  if (mySwitch.available()) {
+    eventOutput.printf("[Raw] Code %lu, protocol %u, not stored while raw capture is on\n",
+      mySwitch.getReceivedValue(), mySwitch.getReceivedProtocol());
     mySwitch.resetAvailable();
   }
+  RCSwitch::RawFrame frame;
+  if (mySwitch.getRawFrame(0, frame) && (frame.hash != rawFrameHash || frame.hits != rawFrameHits)) {
+    rawFrameHash = frame.hash;
+    rawFrameHits = frame.hits;
+    ledBlinks = 1;
+    eventOutput.printf("[Raw] Frame #0: %u durations, received %u times, see 'raw list'\n",
+      frame.waveform.count, frame.hits);
+  }
 }
 
-void checkLedState() {
-  unsigned long currentMillisLed = millis();  
-  if (blinkLed) {
-    if ((unsigned long)(currentMillisLed - previousMillisLed) >= 100) {
-      if (ledCounter == 0) {
-        digitalWrite(builtInLed, HIGH);
-        ledCounter = 1;
-      } else if (ledCounter == 1) {
-        digitalWrite(builtInLed, LOW);
-        ledCounter = 0;
-        blinkLed = false;
+void listRawFrames() {
+  const unsigned int count = mySwitch.getRawFrameCount();
+  eventOutput.printf("\n[Raw Frames]\n----------------\n");
+  RCSwitch::RawFrame frame;
+  for (unsigned int i=0; i<count && mySwitch.getRawFrame(i, frame); i++) {
+    eventOutput.printf("#%u: %u durations, received %u times, starts %s\n",
+      i, frame.waveform.count, frame.hits, frame.waveform.firstLevel ? "high" : "low");
+    // 12 durations per line, the last one is the sync gap
+    char line[12 * 7 + 2];
+    size_t length = 0;
+    for (unsigned int n=0; n<frame.waveform.count; n++) {
+      length += snprintf(line + length, sizeof(line) - length, " %u", frame.waveform.durations[n]);
+      if (n % 12 == 11 || n + 1 == frame.waveform.count) {
+        eventOutput.printf("%s\n", line);
+        length = 0;
       }
-      previousMillisLed = currentMillisLed;
     }
   }
+  eventOutput.printf("----------------\nTotal raw frames: %u\n", count);
+}
+
+bool sendRawFrame(unsigned int index) {
+  RCSwitch::RawFrame frame;
+  if (!mySwitch.getRawFrame(index, frame)) {
+    eventOutput.printf("[Error] No raw frame #%u\n", index);
+    return false;
+  }
+  ledBlinks = 2;
+  // A raw frame still queued would be sent with the new waveform
+  transmitQueue.cancel(rawReplayId);
+  rawReplayWaveform = frame.waveform;
+  if (!transmitQueue.enqueueSignal(rawReplayId, 10, 1)) {
+    Serial.println("[Error] Transmit queue full, frame not sent");
+    return false;
+  }
+  return true;
+}
+
+// Called every 100 ms: a blink is 100 ms on, 100 ms off
+void updateLed() {
+  if (ledOn) {
+    digitalWrite(builtInLed, LOW);
+    ledOn = false;
+    ledBlinks--;
+  } else if (ledBlinks > 0) {
+    digitalWrite(builtInLed, HIGH);
+    ledOn = true;
+  }
 }
 
 void clearAllSignals() {
-  receiverCounter = 0;
+  // Queued codes of the signals and the 'send all' burst go with them
+  transmitQueue.clear();
+  sendAllLastId = 0;
+  signalStore.clear();
+  if (signalLogReady && !signalLog.compact(signalStore)) {
+    Serial.println("[Error] Signals not cleared from flash");
+  }
   Serial.println("\n[Info] All signals cleared from memory");
   Serial.println("Total signals: 0");
 } 
\ No newline at end of file
@@ -0,0 +1,58 @@
+#include "CodeLayout.h"
+
+const char* HcsCodeLayout::name() const {
+  return "KeeLoq HCS";
+}
+
+/**
+ * The receiver puts the first received bit highest, KeeLoq sends the least
+ * significant bit first. The overflow holds frame bits 32 to 63, the two
+ * status bits are beyond it.
+ */
+bool HcsCodeLayout::split(const Frame& frame, Fields& fields) const {
+  if (frame.protocol != PROTOCOL || (frame.bitLength != FRAME_BITS && frame.bitLength != FRAME_BITS - 1)) {
+    return false;
+  }
+  fields.varying = reverseBits(frame.code);
+  fields.fixedId = reverseBits(frame.overflow);
+  return true;
+}
+
+uint32_t HcsCodeLayout::reverseBits(uint32_t value) {
+  value = ((value >> 1) & 0x55555555UL) | ((value & 0x55555555UL) << 1);
+  value = ((value >> 2) & 0x33333333UL) | ((value & 0x33333333UL) << 2);
+  value = ((value >> 4) & 0x0F0F0F0FUL) | ((value & 0x0F0F0F0FUL) << 4);
+  value = ((value >> 8) & 0x00FF00FFUL) | ((value & 0x00FF00FFUL) << 8);
+  return (value >> 16) | (value << 16);
+}
+
+CodeLayouts::CodeLayouts() {
+  this->nCount = 0;
+}
+
+/* @return false if all CODE_LAYOUTS_CAPACITY are in use */
+bool CodeLayouts::add(const CodeLayout* pLayout) {
+  if (this->nCount >= CODE_LAYOUTS_CAPACITY) {
+    return false;
+  }
+  this->layouts[this->nCount++] = pLayout;
+  return true;
+}
+
+/**
+ * Split 'frame' with the first layout that matches.
+ *
+ * @return the layout, NULL if none matches, then 'fields' are not set
+ */
+const CodeLayout* CodeLayouts::split(const CodeLayout::Frame& frame, CodeLayout::Fields& fields) const {
+  for (unsigned int i = 0; i < this->nCount; i++) {
+    if (this->layouts[i]->split(frame, fields)) {
+      return this->layouts[i];
+    }
+  }
+  return NULL;
+}
+
+unsigned int CodeLayouts::size() const {
+  return this->nCount;
+}
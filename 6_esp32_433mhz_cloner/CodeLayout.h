@@ -0,0 +1,84 @@
+#ifndef CODE_LAYOUT_H
+#define CODE_LAYOUT_H
+
+#include <Arduino.h>
+
+#define CODE_LAYOUTS_CAPACITY 4
+
+/**
+ * Post-processing of a decoded frame: splits it into the fields that are
+ * the same in every frame of a remote button, and those that change with
+ * every press, e.g. a counter or an encrypted hopping code.
+ *
+ * Frames are stored by their fixed ID, hence a rolling code remote takes
+ * one signal per button in the store instead of one per press.
+ */
+class CodeLayout {
+  public:
+    /* A frame as decoded by the receiver */
+    struct Frame {
+      /* The first 32 bits, the first received bit highest */
+      unsigned long code;
+      /* The bits after the first 32, the same way */
+      unsigned long overflow;
+      uint8_t protocol;
+      uint8_t bitLength;
+    };
+
+    struct Fields {
+      /* Same in every frame, e.g. serial number and buttons */
+      unsigned long fixedId;
+      /* Changes with every frame, e.g. a counter */
+      unsigned long varying;
+    };
+
+    virtual ~CodeLayout() {}
+
+    virtual const char* name() const = 0;
+    /* @return true if the frame has this layout, then 'fields' are set */
+    virtual bool split(const Frame& frame, Fields& fields) const = 0;
+};
+
+/**
+ * KeeLoq frame of the HCS200/HCS300/HCS301 encoders: 66 bits, sent least
+ * significant bit first. A 32 bit encrypted hopping code, then the fixed
+ * part of a 28 bit serial number and 4 button bits, then 2 status bits.
+ *
+ * The fixed ID is the serial number with the buttons in the highest 4
+ * bits. The varying field is the hopping code as received, it can't be
+ * decrypted without the manufacturer key.
+ *
+ * Only frames of the KeeLoq protocol of the receiver are split. The low
+ * pulse of the last bit merges into the guard time, hence the receiver
+ * loses the last status bit and reports 65 bits.
+ */
+class HcsCodeLayout : public CodeLayout {
+  public:
+    static const uint8_t FRAME_BITS = 66;
+    /* The protocol number of rcSwitchProtocolTable() */
+    static const uint8_t PROTOCOL = 13;
+
+    virtual const char* name() const;
+    virtual bool split(const Frame& frame, Fields& fields) const;
+
+    static uint32_t reverseBits(uint32_t value);
+};
+
+/**
+ * The layouts to try on every decoded frame, the first one that matches
+ * splits it. Fixed capacity, the layouts are owned by the caller.
+ */
+class CodeLayouts {
+  public:
+    CodeLayouts();
+
+    bool add(const CodeLayout* pLayout);
+    const CodeLayout* split(const CodeLayout::Frame& frame, CodeLayout::Fields& fields) const;
+    unsigned int size() const;
+
+  private:
+    const CodeLayout* layouts[CODE_LAYOUTS_CAPACITY];
+    unsigned int nCount;
+};
+
+#endif
@@ -0,0 +1,184 @@
+#include "CodeLayout_test.h"
+
+#if ENABLE_CODE_LAYOUT_TEST
+
+#include <assert.h>
+#include "SignalStore.h"
+#include "test/RcSwitch_test.hpp"
+
+/** Call CodeLayout_test::theTest.run() to execute tests. */
+CodeLayout_test CodeLayout_test::theTest;
+
+/* The bits of a KeeLoq frame in the order they are sent, least significant bit first */
+void CodeLayout_test::hcsBits(uint32_t hop, uint32_t serial, uint8_t buttons, bool* bits) {
+  for (int i = 0; i < 32; i++) {
+    bits[i] = (hop >> i) & 1;
+  }
+  for (int i = 0; i < 28; i++) {
+    bits[32 + i] = (serial >> i) & 1;
+  }
+  for (int i = 0; i < 4; i++) {
+    bits[60 + i] = (buttons >> i) & 1;
+  }
+  bits[64] = true;  // battery low
+  bits[65] = false; // repeat
+}
+
+/**
+ * A KeeLoq frame, packed bit by bit like the receiver: the first 32 bits
+ * into the code, the next 32 into the overflow.
+ */
+CodeLayout::Frame CodeLayout_test::hcsFrame(uint32_t hop, uint32_t serial, uint8_t buttons) {
+  bool bits[HcsCodeLayout::FRAME_BITS];
+  hcsBits(hop, serial, buttons, bits);
+
+  CodeLayout::Frame frame;
+  frame.code = 0;
+  frame.overflow = 0;
+  for (int i = 0; i < 32; i++) {
+    frame.code = (frame.code << 1) | bits[i];
+  }
+  for (int i = 32; i < 64; i++) {
+    frame.overflow = (frame.overflow << 1) | bits[i];
+  }
+  frame.protocol = HcsCodeLayout::PROTOCOL;
+  frame.bitLength = HcsCodeLayout::FRAME_BITS;
+  return frame;
+}
+
+void CodeLayout_test::testHcsSplit() const {
+  HcsCodeLayout layout;
+  CodeLayout::Fields fields;
+
+  assert(HcsCodeLayout::reverseBits(0x00000001UL) == 0x80000000UL);
+  assert(HcsCodeLayout::reverseBits(0x12345678UL) == 0x1E6A2C48UL);
+
+  CodeLayout::Frame frame = hcsFrame(0x89ABCDEFUL, 0x0123456UL, 0x5);
+  assert(layout.split(frame, fields));
+  assert(fields.varying == 0x89ABCDEFUL);
+  assert(fields.fixedId == 0x50123456UL);
+
+  // the receiver loses the last status bit
+  frame.bitLength = HcsCodeLayout::FRAME_BITS - 1;
+  assert(layout.split(frame, fields));
+  assert(fields.fixedId == 0x50123456UL);
+
+  // any other length or protocol is no KeeLoq frame
+  frame.bitLength = 24;
+  assert(!layout.split(frame, fields));
+  frame.bitLength = 32;
+  assert(!layout.split(frame, fields));
+  frame.bitLength = HcsCodeLayout::FRAME_BITS;
+  frame.protocol = 1;
+  assert(!layout.split(frame, fields));
+}
+
+/*
+ * Send a KeeLoq frame to the receiver of the sketch's protocols, like an
+ * HCS301 does it with TE = 400us: a preamble of 23 TE, a header of 10 TE
+ * low, 66 bits of 3 TE, a '1' is 1 TE high and 2 TE low, a '0' 2 TE high
+ * and 1 TE low, then a guard time of 39 TE low.
+ */
+void CodeLayout_test::receiveHcsFrame(RcSwitch::Receiver& receiver, void* context) {
+  static const uint32_t TE = 400;
+  uint32_t usec = 100000;
+  int level = 1;
+  // the level changes at the end of each pulse
+  auto pulse = [&](uint32_t duration) {
+    usec += duration;
+    level = !level;
+    RcSwitch::RcSwitch_test::handleInterrupt(receiver, level, usec);
+  };
+
+  bool bits[HcsCodeLayout::FRAME_BITS];
+  hcsBits(0x89ABCDEFUL, 0x0123456UL, 0x5, bits);
+  RcSwitch::RcSwitch_test::handleInterrupt(receiver, level, usec);
+  for (int i = 0; i < 11; i++) {
+    pulse(TE);
+    pulse(TE);
+  }
+  pulse(TE);
+  pulse(10 * TE);
+  for (int i = 0; i < HcsCodeLayout::FRAME_BITS; i++) {
+    const uint32_t low = bits[i] ? 2 * TE : TE;
+    pulse(bits[i] ? TE : 2 * TE);
+    pulse(i + 1 < HcsCodeLayout::FRAME_BITS ? low : low + 39 * TE);
+  }
+
+  CodeLayout::Frame& frame = *(CodeLayout::Frame*)context;
+  frame.bitLength = 0;
+  if (receiver.available()) {
+    frame.code = receiver.receivedValue();
+    frame.overflow = receiver.receivedOverflowValue();
+    frame.protocol = receiver.bestProtocol();
+    frame.bitLength = receiver.receivedBitsCount();
+  }
+}
+
+/* A KeeLoq remote is received as protocol 13 and split by the layout */
+void CodeLayout_test::testReceivedHcsFrame() const {
+  CodeLayout::Frame frame;
+  RcSwitch::RcSwitch_test::withReceiver(rcSwitchProtocolTable(), &receiveHcsFrame, &frame);
+  assert(frame.bitLength == HcsCodeLayout::FRAME_BITS - 1);
+  assert(frame.protocol == HcsCodeLayout::PROTOCOL);
+
+  HcsCodeLayout hcs;
+  CodeLayouts layouts;
+  layouts.add(&hcs);
+  CodeLayout::Fields fields;
+  assert(layouts.split(frame, fields) == &hcs);
+  assert(fields.varying == 0x89ABCDEFUL);
+  assert(fields.fixedId == 0x50123456UL);
+}
+
+void CodeLayout_test::testLayouts() const {
+  HcsCodeLayout hcs;
+  CodeLayouts layouts;
+  CodeLayout::Fields fields;
+  CodeLayout::Frame frame = hcsFrame(1, 2, 3);
+
+  assert(layouts.split(frame, fields) == NULL);
+  for (int i = 0; i < CODE_LAYOUTS_CAPACITY; i++) {
+    assert(layouts.add(&hcs));
+  }
+  assert(!layouts.add(&hcs));
+  assert(layouts.size() == CODE_LAYOUTS_CAPACITY);
+
+  assert(layouts.split(frame, fields) == &hcs);
+  assert(fields.fixedId == 0x30000002UL);
+  frame.bitLength = 24;
+  assert(layouts.split(frame, fields) == NULL);
+}
+
+/* A rolling code remote takes one signal per button, not one per press */
+void CodeLayout_test::testStoreByFixedId() const {
+  static SignalStore store;
+  store.clear();
+  HcsCodeLayout hcs;
+  CodeLayouts layouts;
+  layouts.add(&hcs);
+  SignalStore::Signal* pSignal;
+
+  uint32_t hop = 0x2545F491UL;
+  for (int nPress = 0; nPress < 3 * SIGNAL_STORE_CAPACITY; nPress++) {
+    hop = hop * 1664525UL + 1013904223UL; // the hopping code looks random
+    const uint8_t buttons = (nPress % 2) ? 0x2 : 0x4;
+    const CodeLayout::Frame frame = hcsFrame(hop, 0x0ABCDEFUL, buttons);
+    CodeLayout::Fields fields;
+    assert(layouts.split(frame, fields) != NULL);
+    const SignalStore::AddResult result = store.add(fields.fixedId, frame.protocol, frame.bitLength, 400, pSignal);
+    assert(result == (nPress < 2 ? SignalStore::SIGNAL_ADDED : SignalStore::SIGNAL_EXISTS));
+  }
+  assert(store.size() == 2);
+  assert(store.find(0x40ABCDEFUL, HcsCodeLayout::PROTOCOL, HcsCodeLayout::FRAME_BITS) != NULL);
+  assert(store.find(0x20ABCDEFUL, HcsCodeLayout::PROTOCOL, HcsCodeLayout::FRAME_BITS) != NULL);
+}
+
+void CodeLayout_test::run() const {
+  testHcsSplit();
+  testReceivedHcsFrame();
+  testLayouts();
+  testStoreByFixedId();
+}
+
+#endif
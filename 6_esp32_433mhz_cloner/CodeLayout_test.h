@@ -0,0 +1,36 @@
+#ifndef CODE_LAYOUT_TEST_H
+#define CODE_LAYOUT_TEST_H
+
+#if !defined(ENABLE_CODE_LAYOUT_TEST)
+#define ENABLE_CODE_LAYOUT_TEST true
+#endif
+
+#if ENABLE_CODE_LAYOUT_TEST
+
+#include "CodeLayout.h"
+#include "RcSwitchReceiverAdapter.h"
+
+/**
+ * Tests of the code layouts on frames packed like the receiver does, and
+ * on a frame decoded by the receiver. They run on a host as well.
+ */
+class CodeLayout_test {
+  public:
+    void run() const;
+
+    static CodeLayout_test theTest;
+
+  private:
+    static void hcsBits(uint32_t hop, uint32_t serial, uint8_t buttons, bool* bits);
+    static CodeLayout::Frame hcsFrame(uint32_t hop, uint32_t serial, uint8_t buttons);
+    static void receiveHcsFrame(RcSwitch::Receiver& receiver, void* context);
+
+    void testHcsSplit() const;
+    void testReceivedHcsFrame() const;
+    void testLayouts() const;
+    void testStoreByFixedId() const;
+};
+
+#endif
+
+#endif
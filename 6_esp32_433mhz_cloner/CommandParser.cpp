@@ -0,0 +1,410 @@
+#include "CommandParser.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+CommandParser::CommandParser() {
+  memset(&this->parserStats, 0, sizeof(this->parserStats));
+  this->reset();
+}
+
+/**
+ * Feed the next received byte.
+ *
+ * @return true, if it completed a command, see command()
+ */
+bool CommandParser::feed(uint8_t byte) {
+  if (byte == FRAME_START && (this->state == STATE_TEXT || this->state == STATE_TEXT_OVERRUN)) {
+    // a frame drops a partial line
+    this->nLineLength = 0;
+    this->state = STATE_LENGTH;
+    return false;
+  }
+
+  switch (this->state) {
+    case STATE_TEXT:
+      if (byte == '\n' || byte == '\r') {
+        return this->endLine();
+      }
+      if (this->nLineLength < COMMAND_PARSER_LINE_LENGTH) {
+        this->line[this->nLineLength++] = byte;
+      } else {
+        this->parserStats.overruns++;
+        this->state = STATE_TEXT_OVERRUN;
+      }
+      return false;
+
+    case STATE_TEXT_OVERRUN:
+      if (byte == '\n' || byte == '\r') {
+        this->nLineLength = 0;
+        this->state = STATE_TEXT;
+      }
+      return false;
+
+    case STATE_LENGTH:
+      if (byte > COMMAND_PARSER_MAX_PAYLOAD) {
+        this->parserStats.overruns++;
+        this->state = STATE_TEXT;
+        return false;
+      }
+      this->frame[0] = byte;
+      this->state = STATE_OPCODE;
+      return false;
+
+    case STATE_OPCODE:
+      this->frame[1] = byte;
+      this->nFrameLength = 0;
+      this->state = this->frame[0] == 0 ? STATE_CRC_LOW : STATE_PAYLOAD;
+      return false;
+
+    case STATE_PAYLOAD:
+      this->frame[2 + this->nFrameLength++] = byte;
+      if (this->nFrameLength == this->frame[0]) {
+        this->state = STATE_CRC_LOW;
+      }
+      return false;
+
+    case STATE_CRC_LOW:
+      this->nFrameCrc = byte;
+      this->state = STATE_CRC_HIGH;
+      return false;
+
+    case STATE_CRC_HIGH:
+      this->nFrameCrc |= (uint16_t)byte << 8;
+      this->state = STATE_TEXT;
+      return this->endFrame();
+  }
+  return false;
+}
+
+/* The last command, valid until feed() returns true again */
+const CommandParser::Command& CommandParser::command() const {
+  return this->parsedCommand;
+}
+
+/**
+ * The last text command, trimmed and in lower case. Empty for a binary
+ * one. Valid until the next feed().
+ */
+const char* CommandParser::text() const {
+  return this->parsedCommand.binary ? "" : this->line;
+}
+
+/* @return true while a line or frame is partially received */
+bool CommandParser::pending() const {
+  return this->state != STATE_TEXT || this->nLineLength != 0;
+}
+
+/**
+ * Call when the sender paused with pending() data. A partial line is taken
+ * as complete, like readStringUntil() did for a terminal sending no line
+ * ending. A partial frame is dropped.
+ *
+ * @return true, if the line was a command, see command()
+ */
+bool CommandParser::timeout() {
+  if (this->state == STATE_TEXT && this->nLineLength != 0) {
+    return this->endLine();
+  }
+  this->state = STATE_TEXT;
+  this->nLineLength = 0;
+  return false;
+}
+
+/* Drop a partially received line or frame and forget the last command */
+void CommandParser::reset() {
+  this->state = STATE_TEXT;
+  this->nLineLength = 0;
+  this->line[0] = '\0';
+  this->nFrameLength = 0;
+  this->nFrameCrc = 0;
+  memset(&this->parsedCommand, 0, sizeof(this->parsedCommand));
+}
+
+const CommandParser::Stats& CommandParser::stats() const {
+  return this->parserStats;
+}
+
+/**
+ * Write a frame into 'frame', which must hold length + 5 bytes.
+ *
+ * @return the size of the frame
+ */
+size_t CommandParser::encodeFrame(uint8_t opcode, const uint8_t* payload, uint8_t length, uint8_t* frame) {
+  frame[0] = FRAME_START;
+  frame[1] = length;
+  frame[2] = opcode;
+  if (length > 0) {
+    memcpy(frame + 3, payload, length);
+  }
+  const uint16_t crc = crc16(0xFFFF, frame + 1, 2 + length);
+  frame[3 + length] = crc;
+  frame[4 + length] = crc >> 8;
+  return 5 + length;
+}
+
+/* CRC-16/CCITT-FALSE, chained through 'crc', 0xFFFF to start */
+uint16_t CommandParser::crc16(uint16_t crc, const uint8_t* data, size_t length) {
+  while (length--) {
+    crc ^= (uint16_t)*data++ << 8;
+    for (int bit = 0; bit < 8; bit++) {
+      crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+    }
+  }
+  return crc;
+}
+
+bool CommandParser::endLine() {
+  // trim and lower case in place
+  char* start = this->line;
+  char* end = this->line + this->nLineLength;
+  this->nLineLength = 0;
+  while (start < end && (*start == ' ' || *start == '\t')) {
+    start++;
+  }
+  while (end > start && (end[-1] == ' ' || end[-1] == '\t')) {
+    end--;
+  }
+  if (start == end) {
+    // blank line, e.g. the '\n' of "\r\n", keeps the last command
+    return false;
+  }
+  *end = '\0';
+  memmove(this->line, start, end - start + 1);
+  for (char* p = this->line; *p != '\0'; p++) {
+    if (*p >= 'A' && *p <= 'Z') {
+      *p += 'a' - 'A';
+    }
+  }
+
+  Command& command = this->parsedCommand;
+  memset(&command, 0, sizeof(command));
+  this->parserStats.textCommands++;
+  if (strcmp(this->line, "refresh data") == 0) {
+    command.opcode = CMD_REFRESH;
+  } else if (strncmp(this->line, "refresh since ", 14) == 0) {
+    if (!parseRefresh(this->line + 14, command)) {
+      command.opcode = CMD_INVALID;
+    }
+  } else if (strncmp(this->line, "find ", 5) == 0) {
+    if (!parseFind(this->line + 5, command)) {
+      command.opcode = CMD_INVALID;
+    }
+  } else if (strncmp(this->line, "raw ", 4) == 0) {
+    if (!parseRaw(this->line + 4, command)) {
+      command.opcode = CMD_INVALID;
+    }
+  } else if (strcmp(this->line, "sleep on") == 0 || strcmp(this->line, "sleep off") == 0) {
+    command.opcode = CMD_LOW_POWER;
+    command.code = (this->line[7] == 'n') ? 1 : 0;
+  } else if (strcmp(this->line, "clear signals") == 0) {
+    command.opcode = CMD_CLEAR;
+  } else if (strcmp(this->line, "send all") == 0) {
+    command.opcode = CMD_SEND_ALL;
+  } else if (strcmp(this->line, "tx stats") == 0) {
+    command.opcode = CMD_TX_STATS;
+  } else if (strcmp(this->line, "sys stats") == 0) {
+    command.opcode = CMD_SYS_STATS;
+  } else if (!parseCode(this->line, command)) {
+    command.opcode = CMD_INVALID;
+  }
+  return true;
+}
+
+bool CommandParser::endFrame() {
+  const uint8_t length = this->frame[0];
+  if (crc16(0xFFFF, this->frame, 2 + length) != this->nFrameCrc) {
+    this->parserStats.crcErrors++;
+    return false;
+  }
+  this->parserStats.frames++;
+
+  Command& command = this->parsedCommand;
+  memset(&command, 0, sizeof(command));
+  command.binary = true;
+  command.opcode = this->frame[1];
+  const uint8_t* payload = this->frame + 2;
+  switch (command.opcode) {
+    case CMD_REFRESH:
+      if (length != 0 && length != 4 && length != 6) {
+        command.opcode = CMD_INVALID;
+        break;
+      }
+      if (length >= 4) {
+        command.sinceId = (uint32_t)payload[0] | ((uint32_t)payload[1] << 8)
+            | ((uint32_t)payload[2] << 16) | ((uint32_t)payload[3] << 24);
+      }
+      if (length == 6) {
+        command.limit = payload[4] | (payload[5] << 8);
+      }
+      break;
+    case CMD_CLEAR:
+    case CMD_SEND_ALL:
+    case CMD_TX_STATS:
+    case CMD_SYS_STATS:
+    case CMD_RAW_LIST:
+      if (length != 0) {
+        command.opcode = CMD_INVALID;
+      }
+      break;
+    case CMD_SEND_CODE:
+      if ((length != 5 && length != 6) || payload[4] == 0) {
+        command.opcode = CMD_INVALID;
+        break;
+      }
+      command.code = (unsigned long)payload[0] | ((unsigned long)payload[1] << 8)
+          | ((unsigned long)payload[2] << 16) | ((unsigned long)payload[3] << 24);
+      command.protocol = payload[4];
+      command.bitLength = length == 6 ? payload[5] : 0;
+      if (command.bitLength > 32) {
+        command.opcode = CMD_INVALID;
+      }
+      break;
+    case CMD_FIND:
+      if (length != 9 || payload[8] == 0 || payload[8] > 32 || payload[8] % 2 != 0) {
+        command.opcode = CMD_INVALID;
+        break;
+      }
+      command.code = (unsigned long)payload[0] | ((unsigned long)payload[1] << 8)
+          | ((unsigned long)payload[2] << 16) | ((unsigned long)payload[3] << 24);
+      command.mask = (unsigned long)payload[4] | ((unsigned long)payload[5] << 8)
+          | ((unsigned long)payload[6] << 16) | ((unsigned long)payload[7] << 24);
+      command.bitLength = payload[8];
+      break;
+    case CMD_RAW_CAPTURE:
+    case CMD_LOW_POWER:
+      if (length != 1 || payload[0] > 1) {
+        command.opcode = CMD_INVALID;
+        break;
+      }
+      command.code = payload[0];
+      break;
+    case CMD_RAW_SEND:
+      if (length != 1) {
+        command.opcode = CMD_INVALID;
+        break;
+      }
+      command.code = payload[0];
+      break;
+    default:
+      command.opcode = CMD_INVALID;
+      break;
+  }
+  return true;
+}
+
+/* "<id>" or "<id> <limit>", after "refresh since " */
+bool CommandParser::parseRefresh(const char* text, Command& command) {
+  unsigned long sinceId;
+  unsigned long limit = 0;
+  if (!parseNumber(text, 0xFFFFFFFFUL, sinceId)) {
+    return false;
+  }
+  if (*text == ' ' && !parseNumber(++text, 0xFFFF, limit)) {
+    return false;
+  }
+  if (*text != '\0') {
+    return false;
+  }
+  command.opcode = CMD_REFRESH;
+  command.sinceId = sinceId;
+  command.limit = limit;
+  return true;
+}
+
+/**
+ * Tri-state pattern after "find ", up to 16 symbols. Each symbol is two
+ * bits like RCSwitch::sendTriState() sends them, '?' matches any.
+ */
+bool CommandParser::parseFind(const char* text, Command& command) {
+  unsigned long code = 0;
+  unsigned long mask = 0;
+  uint8_t nSymbols = 0;
+  for (; *text != '\0'; text++) {
+    if (++nSymbols > 16) {
+      return false;
+    }
+    code <<= 2;
+    mask <<= 2;
+    switch (*text) {
+      case '0':
+        mask |= 3;
+        break;
+      case 'f':
+        code |= 1;
+        mask |= 3;
+        break;
+      case '1':
+        code |= 3;
+        mask |= 3;
+        break;
+      case '?':
+        break;
+      default:
+        return false;
+    }
+  }
+  if (nSymbols == 0) {
+    return false;
+  }
+  command.opcode = CMD_FIND;
+  command.code = code;
+  command.mask = mask;
+  command.bitLength = 2 * nSymbols;
+  return true;
+}
+
+/* "on", "off", "list" or "send <n>", after "raw " */
+bool CommandParser::parseRaw(const char* text, Command& command) {
+  if (strcmp(text, "on") == 0 || strcmp(text, "off") == 0) {
+    command.opcode = CMD_RAW_CAPTURE;
+    command.code = (text[1] == 'n') ? 1 : 0;
+    return true;
+  }
+  if (strcmp(text, "list") == 0) {
+    command.opcode = CMD_RAW_LIST;
+    return true;
+  }
+  unsigned long nFrame;
+  if (strncmp(text, "send ", 5) != 0) {
+    return false;
+  }
+  text += 5;
+  if (!parseNumber(text, 255, nFrame) || *text != '\0') {
+    return false;
+  }
+  command.opcode = CMD_RAW_SEND;
+  command.code = nFrame;
+  return true;
+}
+
+/* Decimal number up to nMax, 'text' is advanced past it */
+bool CommandParser::parseNumber(const char*& text, unsigned long nMax, unsigned long& value) {
+  if (*text < '0' || *text > '9') {
+    return false;
+  }
+  char* end;
+  errno = 0;
+  value = strtoul(text, &end, 10);
+  text = end;
+  return errno == 0 && value <= nMax;
+}
+
+/* "code|protocol", decimal, the code up to 2^32 - 1 */
+bool CommandParser::parseCode(const char* text, Command& command) {
+  unsigned long code;
+  unsigned long protocol;
+  if (!parseNumber(text, 0xFFFFFFFFUL, code) || *text != '|') {
+    return false;
+  }
+  if (!parseNumber(++text, 255, protocol) || *text != '\0' || protocol == 0) {
+    return false;
+  }
+
+  command.opcode = CMD_SEND_CODE;
+  command.code = code;
+  command.protocol = protocol;
+  command.bitLength = 0;
+  return true;
+}
@@ -0,0 +1,131 @@
+#ifndef COMMAND_PARSER_H
+#define COMMAND_PARSER_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Longest text command, longer lines are dropped
+#define COMMAND_PARSER_LINE_LENGTH 64
+// Largest payload of a binary frame
+#define COMMAND_PARSER_MAX_PAYLOAD 32
+
+/**
+ * Parser of the commands received over Serial, fed one byte at a time.
+ * It never allocates, all state is in the object.
+ *
+ * Two protocols share the stream:
+ *
+ * - Text, one command per line as typed into the serial monitor or sent by
+ *   the web UI: "refresh data", "clear signals", "send all", "tx stats",
+ *   "sys stats" or "code|protocol". Case and surrounding blanks are ignored.
+ *   "refresh since <id> [<limit>]" lists only the signals with a higher
+ *   ID, at most 'limit' of them. "find <pattern>" lists the signals that are
+ *   tri-state code words matching the pattern of '0', '1', 'F' and '?' for
+ *   any symbol, e.g. "find 0fff0fffff??" for switch 1 of group 1 of a
+ *   type B switch set. "raw on" and "raw off" turn the capture of frames
+ *   of unknown protocols on and off, "raw list" lists the captured frames
+ *   and "raw send <n>" replays frame n of the list. "sleep on" and
+ *   "sleep off" turn the light sleep of the low power receive on and off.
+ *
+ * - Binary frames: 0xA5, payload length, opcode, payload, CRC-16/CCITT
+ *   (little endian) of length, opcode and payload. A frame may start
+ *   anywhere, 0xA5 is never part of a text command. Replies are the text
+ *   output plus an acknowledge frame, see encodeFrame().
+ *
+ * SEND_CODE payload: code (uint32, little endian), protocol, and optionally
+ * the bit length, 0 or missing for any. REFRESH payload, optional: the ID
+ * to list from (uint32), optionally followed by the limit (uint16). FIND
+ * payload: code and mask (uint32 each) and bit length, see Command.
+ * RAW_CAPTURE and LOW_POWER payload: 1 for on, 0 for off. RAW_SEND
+ * payload: the number of the frame.
+ */
+class CommandParser {
+  public:
+    enum Opcode {
+      CMD_NONE = 0,
+      CMD_REFRESH = 1,
+      CMD_CLEAR = 2,
+      CMD_SEND_ALL = 3,
+      CMD_TX_STATS = 4,
+      CMD_SEND_CODE = 5,
+      CMD_SYS_STATS = 6,
+      CMD_FIND = 7,
+      CMD_RAW_CAPTURE = 8,
+      CMD_RAW_LIST = 9,
+      CMD_RAW_SEND = 10,
+      CMD_LOW_POWER = 11,
+      // text line or frame that is no valid command
+      CMD_INVALID = 0x7F,
+      // set in the opcode of an acknowledge frame
+      CMD_ACK = 0x80
+    };
+
+    static const uint8_t FRAME_START = 0xA5;
+
+    struct Command {
+      uint8_t opcode;
+      bool binary;
+      /* RAW_CAPTURE, LOW_POWER: 1 for on, 0 for off. RAW_SEND: the number of the frame */
+      unsigned long code;
+      uint8_t protocol;
+      uint8_t bitLength;
+      /* REFRESH: list signals with a higher ID, at most limit, 0 for all */
+      uint32_t sinceId;
+      uint16_t limit;
+      /* FIND: the bits of the pattern's symbols are in code, mask has those of all but '?' */
+      unsigned long mask;
+    };
+
+    struct Stats {
+      unsigned long textCommands;
+      unsigned long frames;
+      unsigned long crcErrors;
+      /* Frames too long or lines too long, dropped */
+      unsigned long overruns;
+    };
+
+    CommandParser();
+
+    bool feed(uint8_t byte);
+    const Command& command() const;
+    const char* text() const;
+    bool pending() const;
+    bool timeout();
+    void reset();
+    const Stats& stats() const;
+
+    static size_t encodeFrame(uint8_t opcode, const uint8_t* payload, uint8_t length, uint8_t* frame);
+    static uint16_t crc16(uint16_t crc, const uint8_t* data, size_t length);
+
+  private:
+    enum State {
+      STATE_TEXT,
+      STATE_TEXT_OVERRUN,
+      STATE_LENGTH,
+      STATE_OPCODE,
+      STATE_PAYLOAD,
+      STATE_CRC_LOW,
+      STATE_CRC_HIGH
+    };
+
+    bool endLine();
+    bool endFrame();
+    static bool parseCode(const char* text, Command& command);
+    static bool parseRefresh(const char* text, Command& command);
+    static bool parseFind(const char* text, Command& command);
+    static bool parseRaw(const char* text, Command& command);
+    static bool parseNumber(const char*& text, unsigned long nMax, unsigned long& value);
+
+    uint8_t state;
+    char line[COMMAND_PARSER_LINE_LENGTH + 1];
+    uint8_t nLineLength;
+
+    uint8_t frame[2 + COMMAND_PARSER_MAX_PAYLOAD];
+    uint8_t nFrameLength;
+    uint16_t nFrameCrc;
+
+    Command parsedCommand;
+    Stats parserStats;
+};
+
+#endif
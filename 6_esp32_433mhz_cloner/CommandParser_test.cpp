@@ -0,0 +1,369 @@
+#include "CommandParser_test.h"
+
+#if ENABLE_COMMAND_PARSER_TEST
+
+#include <Arduino.h>
+#include <assert.h>
+#include <string.h>
+
+/** Call CommandParser_test::theTest.run() to execute tests. */
+CommandParser_test CommandParser_test::theTest;
+
+/* @return the number of commands completed */
+int CommandParser_test::feed(CommandParser& parser, const uint8_t* data, size_t length) {
+  int nCommands = 0;
+  for (size_t i = 0; i < length; i++) {
+    if (parser.feed(data[i])) {
+      nCommands++;
+    }
+  }
+  return nCommands;
+}
+
+int CommandParser_test::feed(CommandParser& parser, const char* text) {
+  return feed(parser, (const uint8_t*)text, strlen(text));
+}
+
+/* Whatever state the parser is in, it is back to text afterwards */
+void CommandParser_test::resync(CommandParser& parser) {
+  for (int i = 0; i < 3 + COMMAND_PARSER_MAX_PAYLOAD + 2; i++) {
+    parser.feed('\n');
+  }
+  assert(!parser.pending());
+}
+
+void CommandParser_test::testText() const {
+  CommandParser parser;
+
+  assert(feed(parser, "refresh data\n") == 1);
+  assert(parser.command().opcode == CommandParser::CMD_REFRESH);
+  assert(!parser.command().binary);
+  assert(strcmp(parser.text(), "refresh data") == 0);
+  // the serial monitor may send "\r\n", blanks and capitals are ignored
+  assert(feed(parser, "  Clear Signals \r\n") == 1);
+  assert(parser.command().opcode == CommandParser::CMD_CLEAR);
+  assert(strcmp(parser.text(), "clear signals") == 0);
+  assert(feed(parser, "SEND ALL\n") == 1);
+  assert(parser.command().opcode == CommandParser::CMD_SEND_ALL);
+  assert(feed(parser, "tx stats\r") == 1);
+  assert(parser.command().opcode == CommandParser::CMD_TX_STATS);
+  assert(feed(parser, "Sys Stats\n") == 1);
+  assert(parser.command().opcode == CommandParser::CMD_SYS_STATS);
+  assert(feed(parser, "refresh since 17\n") == 1);
+  assert(parser.command().opcode == CommandParser::CMD_REFRESH);
+  assert(parser.command().sinceId == 17);
+  assert(parser.command().limit == 0);
+  assert(feed(parser, "Refresh Since 4294967295 10\n") == 1);
+  assert(parser.command().sinceId == 4294967295UL);
+  assert(parser.command().limit == 10);
+  assert(feed(parser, "refresh data\n") == 1);
+  assert(parser.command().sinceId == 0);
+  static const char* const invalidRefresh[] = {
+    "refresh since\n", "refresh since x\n", "refresh since 1 65536\n", "refresh since 1 2 3\n",
+    "refresh since -1\n", "refresh since 4294967296\n"
+  };
+  for (unsigned int i = 0; i < sizeof(invalidRefresh) / sizeof(invalidRefresh[0]); i++) {
+    assert(feed(parser, invalidRefresh[i]) == 1);
+    assert(parser.command().opcode == CommandParser::CMD_INVALID);
+  }
+  assert(feed(parser, "find 0FFF0FFFFF??\n") == 1);
+  assert(parser.command().opcode == CommandParser::CMD_FIND);
+  assert(parser.command().code == 0x151550UL);
+  assert(parser.command().mask == 0xFFFFF0UL);
+  assert(parser.command().bitLength == 24);
+  assert(feed(parser, "find 1111111111111111\n") == 1);
+  assert(parser.command().code == 0xFFFFFFFFUL);
+  assert(parser.command().mask == 0xFFFFFFFFUL);
+  assert(parser.command().bitLength == 32);
+  static const char* const invalidFind[] = {
+    "find\n", "find \n", "find 0f2\n", "find 0f 0\n", "find 11111111111111111\n"
+  };
+  for (unsigned int i = 0; i < sizeof(invalidFind) / sizeof(invalidFind[0]); i++) {
+    assert(feed(parser, invalidFind[i]) == 1);
+    assert(parser.command().opcode == CommandParser::CMD_INVALID);
+  }
+  assert(feed(parser, "Raw On\n") == 1);
+  assert(parser.command().opcode == CommandParser::CMD_RAW_CAPTURE);
+  assert(parser.command().code == 1);
+  assert(feed(parser, "raw off\n") == 1);
+  assert(parser.command().opcode == CommandParser::CMD_RAW_CAPTURE);
+  assert(parser.command().code == 0);
+  assert(feed(parser, "raw list\n") == 1);
+  assert(parser.command().opcode == CommandParser::CMD_RAW_LIST);
+  assert(feed(parser, "raw send 7\n") == 1);
+  assert(parser.command().opcode == CommandParser::CMD_RAW_SEND);
+  assert(parser.command().code == 7);
+  assert(feed(parser, "Sleep On\n") == 1);
+  assert(parser.command().opcode == CommandParser::CMD_LOW_POWER);
+  assert(parser.command().code == 1);
+  assert(feed(parser, "sleep off\n") == 1);
+  assert(parser.command().opcode == CommandParser::CMD_LOW_POWER);
+  assert(parser.command().code == 0);
+  assert(feed(parser, "sleep\n") == 1);
+  assert(parser.command().opcode == CommandParser::CMD_INVALID);
+  static const char* const invalidRaw[] = {
+    "raw\n", "raw \n", "raw of\n", "raw send\n", "raw send \n", "raw send 256\n", "raw send 1 2\n"
+  };
+  for (unsigned int i = 0; i < sizeof(invalidRaw) / sizeof(invalidRaw[0]); i++) {
+    assert(feed(parser, invalidRaw[i]) == 1);
+    assert(parser.command().opcode == CommandParser::CMD_INVALID);
+  }
+  assert(feed(parser, "\n\r\n   \n") == 0);
+  assert(feed(parser, "hello\n") == 1);
+  assert(parser.command().opcode == CommandParser::CMD_INVALID);
+
+  // no command before the end of the line, or before the sender pauses
+  assert(feed(parser, "send all") == 0);
+  assert(parser.pending());
+  assert(parser.timeout());
+  assert(parser.command().opcode == CommandParser::CMD_SEND_ALL);
+  assert(!parser.pending());
+  assert(!parser.timeout());
+  assert(feed(parser, "send all") == 0);
+  parser.reset();
+  assert(feed(parser, "\n") == 0);
+
+  // an overlong line is dropped as a whole
+  const unsigned long nOverruns = parser.stats().overruns;
+  for (int i = 0; i < COMMAND_PARSER_LINE_LENGTH; i++) {
+    assert(!parser.feed('1'));
+  }
+  assert(feed(parser, "|1\n") == 0);
+  assert(parser.stats().overruns == nOverruns + 1);
+  assert(feed(parser, "5393|1\n") == 1);
+  assert(parser.command().code == 5393);
+}
+
+void CommandParser_test::testCodes() const {
+  CommandParser parser;
+
+  assert(feed(parser, "5393|1\n") == 1);
+  assert(parser.command().opcode == CommandParser::CMD_SEND_CODE);
+  assert(parser.command().code == 5393);
+  assert(parser.command().protocol == 1);
+  assert(parser.command().bitLength == 0);
+
+  // above 2^31, where toInt() overflowed
+  assert(feed(parser, "3000000000|12\n") == 1);
+  assert(parser.command().opcode == CommandParser::CMD_SEND_CODE);
+  assert(parser.command().code == 3000000000UL);
+  assert(parser.command().protocol == 12);
+  assert(feed(parser, "4294967295|2\n") == 1);
+  assert(parser.command().code == 4294967295UL);
+
+  static const char* const invalid[] = {
+    "4294967296|1\n", "99999999999999999999999|1\n", "-1|1\n", "12|0\n", "12|256\n",
+    "12|\n", "|1\n", "12|1x\n", "12 |1\n", "0x12|1\n", "12|1|24\n"
+  };
+  for (unsigned int i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++) {
+    assert(feed(parser, invalid[i]) == 1);
+    assert(parser.command().opcode == CommandParser::CMD_INVALID);
+  }
+}
+
+void CommandParser_test::testFrames() const {
+  CommandParser parser;
+  uint8_t frame[5 + COMMAND_PARSER_MAX_PAYLOAD];
+
+  size_t nLength = CommandParser::encodeFrame(CommandParser::CMD_TX_STATS, NULL, 0, frame);
+  assert(nLength == 5);
+  assert(feed(parser, frame, nLength) == 1);
+  assert(parser.command().opcode == CommandParser::CMD_TX_STATS);
+  assert(parser.command().binary);
+  assert(strcmp(parser.text(), "") == 0);
+
+  static const uint8_t sendCode[] = { 0xFF, 0xFF, 0xFF, 0xFF, 7, 32 };
+  nLength = CommandParser::encodeFrame(CommandParser::CMD_SEND_CODE, sendCode, sizeof(sendCode), frame);
+  assert(feed(parser, frame, nLength) == 1);
+  assert(parser.command().opcode == CommandParser::CMD_SEND_CODE);
+  assert(parser.command().code == 0xFFFFFFFFUL);
+  assert(parser.command().protocol == 7);
+  assert(parser.command().bitLength == 32);
+  // the bit length is optional
+  nLength = CommandParser::encodeFrame(CommandParser::CMD_SEND_CODE, sendCode, 5, frame);
+  assert(feed(parser, frame, nLength) == 1);
+  assert(parser.command().bitLength == 0);
+
+  static const uint8_t refresh[] = { 0x11, 0, 0, 0, 10, 0 };
+  nLength = CommandParser::encodeFrame(CommandParser::CMD_REFRESH, refresh, sizeof(refresh), frame);
+  assert(feed(parser, frame, nLength) == 1);
+  assert(parser.command().opcode == CommandParser::CMD_REFRESH);
+  assert(parser.command().sinceId == 0x11);
+  assert(parser.command().limit == 10);
+  nLength = CommandParser::encodeFrame(CommandParser::CMD_REFRESH, refresh, 4, frame);
+  assert(feed(parser, frame, nLength) == 1);
+  assert(parser.command().sinceId == 0x11);
+  assert(parser.command().limit == 0);
+
+  static const uint8_t rawOn[] = { 1 };
+  nLength = CommandParser::encodeFrame(CommandParser::CMD_RAW_CAPTURE, rawOn, sizeof(rawOn), frame);
+  assert(feed(parser, frame, nLength) == 1);
+  assert(parser.command().opcode == CommandParser::CMD_RAW_CAPTURE);
+  assert(parser.command().code == 1);
+  static const uint8_t sleepOff[] = { 0 };
+  nLength = CommandParser::encodeFrame(CommandParser::CMD_LOW_POWER, sleepOff, sizeof(sleepOff), frame);
+  assert(feed(parser, frame, nLength) == 1);
+  assert(parser.command().opcode == CommandParser::CMD_LOW_POWER);
+  assert(parser.command().code == 0);
+  static const uint8_t rawSend[] = { 3 };
+  nLength = CommandParser::encodeFrame(CommandParser::CMD_RAW_SEND, rawSend, sizeof(rawSend), frame);
+  assert(feed(parser, frame, nLength) == 1);
+  assert(parser.command().opcode == CommandParser::CMD_RAW_SEND);
+  assert(parser.command().code == 3);
+  nLength = CommandParser::encodeFrame(CommandParser::CMD_RAW_SEND, NULL, 0, frame);
+  assert(feed(parser, frame, nLength) == 1);
+  assert(parser.command().opcode == CommandParser::CMD_INVALID);
+
+  static const uint8_t find[] = { 0x50, 0x15, 0x15, 0, 0xF0, 0xFF, 0xFF, 0, 24 };
+  nLength = CommandParser::encodeFrame(CommandParser::CMD_FIND, find, sizeof(find), frame);
+  assert(feed(parser, frame, nLength) == 1);
+  assert(parser.command().opcode == CommandParser::CMD_FIND);
+  assert(parser.command().code == 0x151550UL);
+  assert(parser.command().mask == 0xFFFFF0UL);
+  assert(parser.command().bitLength == 24);
+  nLength = CommandParser::encodeFrame(CommandParser::CMD_FIND, find, 8, frame);
+  assert(feed(parser, frame, nLength) == 1);
+  assert(parser.command().opcode == CommandParser::CMD_INVALID);
+
+  // a corrupt frame is no command
+  frame[4] ^= 0x10;
+  const unsigned long nCrcErrors = parser.stats().crcErrors;
+  assert(feed(parser, frame, nLength) == 0);
+  assert(parser.stats().crcErrors == nCrcErrors + 1);
+
+  // CRC fine, payload not
+  static const uint8_t noProtocol[] = { 1, 2, 3, 4, 0 };
+  nLength = CommandParser::encodeFrame(CommandParser::CMD_SEND_CODE, noProtocol, sizeof(noProtocol), frame);
+  assert(feed(parser, frame, nLength) == 1);
+  assert(parser.command().opcode == CommandParser::CMD_INVALID);
+  nLength = CommandParser::encodeFrame(CommandParser::CMD_TX_STATS, noProtocol, 1, frame);
+  assert(feed(parser, frame, nLength) == 1);
+  assert(parser.command().opcode == CommandParser::CMD_INVALID);
+  nLength = CommandParser::encodeFrame(CommandParser::CMD_ACK | CommandParser::CMD_REFRESH, NULL, 0, frame);
+  assert(feed(parser, frame, nLength) == 1);
+  assert(parser.command().opcode == CommandParser::CMD_INVALID);
+
+  // a length above the maximum ends the frame at once
+  static const uint8_t tooLong[] = { CommandParser::FRAME_START, COMMAND_PARSER_MAX_PAYLOAD + 1 };
+  assert(feed(parser, tooLong, sizeof(tooLong)) == 0);
+  assert(!parser.pending());
+
+  // a partial frame is dropped when the sender pauses
+  assert(feed(parser, frame, nLength - 1) == 0);
+  assert(parser.pending());
+  assert(!parser.timeout());
+  assert(!parser.pending());
+}
+
+void CommandParser_test::testMixed() const {
+  CommandParser parser;
+  uint8_t frame[5 + COMMAND_PARSER_MAX_PAYLOAD];
+
+  // a frame drops the partial line it interrupts
+  assert(feed(parser, "send a") == 0);
+  const size_t nLength = CommandParser::encodeFrame(CommandParser::CMD_REFRESH, NULL, 0, frame);
+  assert(feed(parser, frame, nLength) == 1);
+  assert(parser.command().opcode == CommandParser::CMD_REFRESH);
+  assert(feed(parser, "ll\n") == 1);
+  assert(parser.command().opcode == CommandParser::CMD_INVALID);
+
+  // frames and lines back to back
+  assert(feed(parser, frame, nLength) == 1);
+  assert(feed(parser, "tx stats\n") == 1);
+  assert(feed(parser, frame, nLength) == 1);
+  assert(parser.command().opcode == CommandParser::CMD_REFRESH);
+}
+
+void CommandParser_test::run() const {
+  testText();
+  testCodes();
+  testFrames();
+  testMixed();
+  fuzz(2000);
+}
+
+/**
+ * Random bytes, then random bit flips of valid frames. The parser must
+ * neither overrun nor accept a damaged frame, and must parse a valid
+ * command after resyncing.
+ */
+void CommandParser_test::fuzz(unsigned long nIterations, uint32_t nSeed) const {
+  CommandParser parser;
+  uint8_t frame[5 + COMMAND_PARSER_MAX_PAYLOAD];
+  uint8_t payload[6];
+  uint32_t nRandom = nSeed;
+
+  for (unsigned long n = 0; n < nIterations; n++) {
+    nRandom = nRandom * 1103515245UL + 12345UL;
+    const unsigned int nGarbage = (nRandom >> 16) % 100;
+    for (unsigned int i = 0; i < nGarbage; i++) {
+      nRandom = nRandom * 1103515245UL + 12345UL;
+      uint8_t byte = nRandom >> 16;
+      // make frame starts and line ends frequent
+      if ((nRandom >> 8) % 8 == 0) {
+        byte = (nRandom >> 12) % 2 ? CommandParser::FRAME_START : '\n';
+      }
+      if (parser.feed(byte)) {
+        assert(strlen(parser.text()) <= COMMAND_PARSER_LINE_LENGTH);
+        const uint8_t opcode = parser.command().opcode;
+        assert(opcode >= CommandParser::CMD_REFRESH && (opcode <= CommandParser::CMD_SYS_STATS || opcode == CommandParser::CMD_INVALID));
+      }
+    }
+    resync(parser);
+
+    nRandom = nRandom * 1103515245UL + 12345UL;
+    for (int i = 0; i < 4; i++) {
+      payload[i] = nRandom >> (8 * i);
+    }
+    payload[4] = 1 + n % 12;
+    payload[5] = 24;
+    const size_t nLength = CommandParser::encodeFrame(CommandParser::CMD_SEND_CODE, payload, sizeof(payload), frame);
+
+    // one flipped bit after the start byte
+    nRandom = nRandom * 1103515245UL + 12345UL;
+    const unsigned int nBit = 8 + (nRandom >> 16) % ((nLength - 1) * 8);
+    frame[nBit / 8] ^= 1 << (nBit % 8);
+    int nCommands = feed(parser, frame, nLength);
+    resync(parser);
+    assert(nCommands == 0 || parser.command().opcode == CommandParser::CMD_INVALID);
+    frame[nBit / 8] ^= 1 << (nBit % 8);
+
+    nCommands = feed(parser, frame, nLength);
+    assert(nCommands == 1);
+    assert(parser.command().opcode == CommandParser::CMD_SEND_CODE);
+    assert(parser.command().code == ((unsigned long)payload[0] | ((unsigned long)payload[1] << 8)
+        | ((unsigned long)payload[2] << 16) | ((unsigned long)payload[3] << 24)));
+    assert(parser.command().protocol == payload[4]);
+  }
+}
+
+/* Parse nCommands "code|protocol" lines, then as many frames */
+CommandParser_test::BenchmarkResult CommandParser_test::benchmark(unsigned long nCommands) const {
+  BenchmarkResult result;
+  CommandParser parser;
+  uint8_t frame[5 + COMMAND_PARSER_MAX_PAYLOAD];
+  static const char line[] = "3000000000|1\n";
+  result.commands = nCommands;
+
+  unsigned long nParsed = 0;
+  unsigned long nStartMicros = micros();
+  for (unsigned long n = 0; n < nCommands; n++) {
+    nParsed += feed(parser, (const uint8_t*)line, sizeof(line) - 1);
+  }
+  result.textMicros = (float)(micros() - nStartMicros) / nCommands;
+  assert(nParsed == nCommands);
+
+  static const uint8_t payload[] = { 0x00, 0x5E, 0xD0, 0xB2, 1 };
+  const size_t nLength = CommandParser::encodeFrame(CommandParser::CMD_SEND_CODE, payload, sizeof(payload), frame);
+  nParsed = 0;
+  nStartMicros = micros();
+  for (unsigned long n = 0; n < nCommands; n++) {
+    nParsed += feed(parser, frame, nLength);
+  }
+  result.binaryMicros = (float)(micros() - nStartMicros) / nCommands;
+  assert(nParsed == nCommands);
+  assert(parser.command().code == 3000000000UL);
+  return result;
+}
+
+#endif
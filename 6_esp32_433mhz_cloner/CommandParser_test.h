@@ -0,0 +1,44 @@
+#ifndef COMMAND_PARSER_TEST_H
+#define COMMAND_PARSER_TEST_H
+
+#if !defined(ENABLE_COMMAND_PARSER_TEST)
+#define ENABLE_COMMAND_PARSER_TEST true
+#endif
+
+#if ENABLE_COMMAND_PARSER_TEST
+
+#include "CommandParser.h"
+
+/**
+ * Tests, fuzzing and benchmark of the command parser. They only use the
+ * parser and micros(), hence they run on a host as well.
+ */
+class CommandParser_test {
+  public:
+    struct BenchmarkResult {
+      unsigned long commands;
+      /* Average microseconds per command */
+      float textMicros;
+      float binaryMicros;
+    };
+
+    void run() const;
+    void fuzz(unsigned long nIterations = 20000, uint32_t nSeed = 1) const;
+    BenchmarkResult benchmark(unsigned long nCommands = 10000) const;
+
+    static CommandParser_test theTest;
+
+  private:
+    static int feed(CommandParser& parser, const char* text);
+    static int feed(CommandParser& parser, const uint8_t* data, size_t length);
+    static void resync(CommandParser& parser);
+
+    void testText() const;
+    void testCodes() const;
+    void testFrames() const;
+    void testMixed() const;
+};
+
+#endif
+
+#endif
@@ -0,0 +1,260 @@
+#include "EventOutput.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include "CommandParser.h"
+#include "SignalStore.h"
+
+/* A decoded signal as text, followed by the rolling code, tri-state and store result lines */
+static const char signalEventFormat[] =
+    "\n[Signal Received]\n"
+    "----------------\n"
+    "Code: %lu\n"
+    "Protocol: %u\n"
+    "Bit Length: %u bits\n"
+    "Delay: %u µs\n"
+    "Timing: deviation %u µs, max %u µs, jitter %u µs\n"
+    "Protocol Type: %s\n"
+    "Signal Quality: %s\n"
+    "----------------\n"
+    "%s%s%s";
+
+EventOutput::EventOutput(Print& out) : out(out) {
+  this->bBinary = false;
+  this->resetStats();
+}
+
+/* Binary mode is for clients that speak the binary command protocol */
+void EventOutput::setBinary(bool bBinary) {
+  this->bBinary = bBinary;
+}
+
+bool EventOutput::isBinary() const {
+  return this->bBinary;
+}
+
+void EventOutput::signal(const SignalEvent& event) {
+  if (this->bBinary) {
+    // the timing is appended, older clients read the first 15 bytes
+    uint8_t payload[21];
+    put32(payload, event.id);
+    put32(payload + 4, event.code);
+    payload[8] = event.protocol;
+    payload[9] = event.bitLength;
+    put16(payload + 10, event.pulseLength);
+    payload[12] = event.storeResult;
+    put16(payload + 13, event.storedCount);
+    put16(payload + 15, event.meanDeviation);
+    put16(payload + 17, event.maxDeviation);
+    put16(payload + 19, event.jitter);
+    this->writeFrame(EVT_SIGNAL, payload, sizeof(payload));
+    return;
+  }
+
+  // Stored by the fixed ID, the code changes with every press
+  char rollingCode[80] = "";
+  if (event.layout != NULL) {
+    snprintf(rollingCode, sizeof(rollingCode), "Rolling Code: %s, ID 0x%08lX, varying 0x%08lX\n",
+        event.layout, event.fixedId, event.varying);
+  }
+
+  char triState[80] = "";
+  formatTriState(event, triState, sizeof(triState));
+
+  char storeResult[128];
+  if (event.storeResult == SignalStore::SIGNAL_NOT_STORED) {
+    snprintf(storeResult, sizeof(storeResult), "[Info] Marginal timing, signal not stored\n");
+  } else if (event.storeResult == SignalStore::SIGNAL_EXISTS) {
+    snprintf(storeResult, sizeof(storeResult), "[Info] Signal already exists in memory\n");
+  } else {
+    snprintf(storeResult, sizeof(storeResult), "%s[Info] Signal stored successfully as #%lu\nTotal signals: %u\n",
+        event.storeResult == SignalStore::SIGNAL_REPLACED ? "[Info] Memory full, least recently used signal replaced\n" : "",
+        (unsigned long)event.id, event.storedCount);
+  }
+
+  this->printf(signalEventFormat,
+      (unsigned long)event.code, event.protocol, event.bitLength, event.pulseLength,
+      event.meanDeviation, event.maxDeviation, event.jitter,
+      protocolName(event.protocol), signalQuality(event), rollingCode, triState, storeResult);
+}
+
+/**
+ * The "Tri-State: ..." line of a PT2262 family code, with the switch
+ * address if it is one. Empty for other codes.
+ */
+void EventOutput::formatTriState(const SignalEvent& event, char* buffer, size_t size) {
+  char codeWord[17];
+  RCSwitch::SwitchAddress address;
+  if (event.layout != NULL || !RCSwitch::getTriState(event.code, event.bitLength, codeWord)) {
+    return;
+  }
+  if (!RCSwitch::decodeCodeWord(codeWord, address)) {
+    snprintf(buffer, size, "Tri-State: %s\n", codeWord);
+  } else if (address.type == 'A') {
+    // the DIP switches, switch 1 first
+    char group[6];
+    char device[6];
+    for (int i = 0; i < 5; i++) {
+      group[i] = (address.nGroup & (0x10 >> i)) ? '1' : '0';
+      device[i] = (address.nDevice & (0x10 >> i)) ? '1' : '0';
+    }
+    group[5] = device[5] = '\0';
+    snprintf(buffer, size, "Tri-State: %s, type A, group %s, device %s, %s\n",
+        codeWord, group, device, address.bStatus ? "on" : "off");
+  } else if (address.type == 'C') {
+    snprintf(buffer, size, "Tri-State: %s, type C, family %c, group %d, device %d, %s\n",
+        codeWord, address.sFamily, address.nGroup, address.nDevice, address.bStatus ? "on" : "off");
+  } else {
+    snprintf(buffer, size, "Tri-State: %s, type %c, group %d, device %d, %s\n",
+        codeWord, address.type, address.nGroup, address.nDevice, address.bStatus ? "on" : "off");
+  }
+}
+
+/* Header of a listing of stored signals, text only */
+void EventOutput::dumpBegin() {
+  if (!this->bBinary) {
+    this->printf("\n[Stored Codes]\n----------------\n");
+  }
+}
+
+/* One line of a listing, in the "code|protocol" form the web UI sends back */
+void EventOutput::storedSignal(const SignalStore::Signal& signal) {
+  if (this->bBinary) {
+    uint8_t payload[12];
+    put32(payload, signal.id);
+    put32(payload + 4, signal.code);
+    payload[8] = signal.protocol;
+    payload[9] = signal.bitLength;
+    put16(payload + 10, signal.pulseLength);
+    this->writeFrame(EVT_STORED_SIGNAL, payload, sizeof(payload));
+    return;
+  }
+  this->printf("Signal #%lu: %lu|%u\n", (unsigned long)signal.id, (unsigned long)signal.code, signal.protocol);
+}
+
+/**
+ * End of a listing. If 'bMore', signals after 'lastId' were left out and
+ * can be fetched with "refresh since <lastId>".
+ */
+void EventOutput::dumpEnd(unsigned int nSent, unsigned int nTotal, uint32_t lastId, bool bMore) {
+  if (this->bBinary) {
+    uint8_t payload[9];
+    put16(payload, nSent);
+    put16(payload + 2, nTotal);
+    put32(payload + 4, lastId);
+    payload[8] = bMore;
+    this->writeFrame(EVT_DUMP_END, payload, sizeof(payload));
+    return;
+  }
+  if (bMore) {
+    this->printf("----------------\nTotal signals: %u\nMore after #%lu\n", nTotal, (unsigned long)lastId);
+  } else {
+    this->printf("----------------\nTotal signals: %u\n", nTotal);
+  }
+}
+
+/**
+ * Format into the stack buffer and write it at once.
+ *
+ * @return the number of bytes written
+ */
+size_t EventOutput::printf(const char* format, ...) {
+  char buffer[EVENT_OUTPUT_BUFFER_SIZE];
+  va_list args;
+  va_start(args, format);
+  const int nLength = vsnprintf(buffer, sizeof(buffer), format, args);
+  va_end(args);
+  if (nLength < 0) {
+    return 0;
+  }
+  size_t nWrite = nLength;
+  if (nWrite >= sizeof(buffer)) {
+    this->outputStats.truncated++;
+    nWrite = sizeof(buffer) - 1;
+  }
+  return this->write((const uint8_t*)buffer, nWrite);
+}
+
+const EventOutput::Stats& EventOutput::stats() const {
+  return this->outputStats;
+}
+
+void EventOutput::resetStats() {
+  this->outputStats.events = 0;
+  this->outputStats.bytes = 0;
+  this->outputStats.truncated = 0;
+  this->outputStats.maxWriteMicros = 0;
+}
+
+const char* EventOutput::protocolName(int nProtocol) {
+  switch (nProtocol) {
+    case 1: return "PT2262";
+    case 2: return "Standard";
+    case 3: return "Standard";
+    case 4: return "Standard";
+    case 5: return "Standard";
+    case 6: return "HT6P20B";
+    case 7: return "HS2303-PT";
+    case 8: return "Conrad RS-200 RX";
+    case 9: return "Conrad RS-200 TX";
+    case 10: return "1ByOne Doorbell";
+    case 11: return "HT12E";
+    case 12: return "SM5212";
+    case 13: return "KeeLoq HCS";
+  }
+  return "Unknown Protocol";
+}
+
+const char* EventOutput::signalQuality(const SignalEvent& event) {
+  if (event.pulseLength > 5000) {
+    return "Poor (High Delay)";
+  } else if (event.bitLength < 12) {
+    return "Poor (Short Bit Length)";
+  } else if (isMarginal(event)) {
+    return "Poor (Timing)";
+  } else if (2 * event.jitterPercent > EVENT_OUTPUT_MARGINAL_JITTER_PERCENT) {
+    return "Fair (Jitter)";
+  }
+  return "Good";
+}
+
+/**
+ * Whether the pulses barely matched the protocol, e.g. at the edge of the
+ * range or with a bad antenna. Such a capture may be a distorted code.
+ * Relative to each pulse's own nominal duration, as a slow clock deviates
+ * the long pulses by more microseconds than the short ones.
+ */
+bool EventOutput::isMarginal(const SignalEvent& event) {
+  return event.jitterPercent > EVENT_OUTPUT_MARGINAL_JITTER_PERCENT
+      || event.maxDeviationPercent > EVENT_OUTPUT_MARGINAL_DEVIATION_PERCENT;
+}
+
+size_t EventOutput::writeFrame(uint8_t type, const uint8_t* payload, uint8_t length) {
+  uint8_t frame[5 + COMMAND_PARSER_MAX_PAYLOAD];
+  return this->write(frame, CommandParser::encodeFrame(type, payload, length, frame));
+}
+
+/* Little endian, like the command frames */
+void EventOutput::put16(uint8_t* p, uint16_t value) {
+  p[0] = value;
+  p[1] = value >> 8;
+}
+
+void EventOutput::put32(uint8_t* p, uint32_t value) {
+  p[0] = value;
+  p[1] = value >> 8;
+  p[2] = value >> 16;
+  p[3] = value >> 24;
+}
+
+size_t EventOutput::write(const uint8_t* data, size_t length) {
+  const unsigned long nStartMicros = micros();
+  const size_t nWritten = this->out.write(data, length);
+  const unsigned long nMicros = micros() - nStartMicros;
+  if (nMicros > this->outputStats.maxWriteMicros) {
+    this->outputStats.maxWriteMicros = nMicros;
+  }
+  this->outputStats.events++;
+  this->outputStats.bytes += nWritten;
+  return nWritten;
+}
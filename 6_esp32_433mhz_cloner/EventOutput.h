@@ -0,0 +1,92 @@
+#ifndef EVENT_OUTPUT_H
+#define EVENT_OUTPUT_H
+
+#include <Arduino.h>
+#include "SignalStore.h"
+
+// Size of the format buffer on the stack, longer events are truncated
+#define EVENT_OUTPUT_BUFFER_SIZE 384
+// Jitter above this percentage of the nominal pulse durations makes a capture marginal
+#define EVENT_OUTPUT_MARGINAL_JITTER_PERCENT 10
+// As well as a pulse that deviates by more than this percentage, the decoder accepts 20
+#define EVENT_OUTPUT_MARGINAL_DEVIATION_PERCENT 15
+
+/**
+ * Output of the sketch's events without heap use: each event is formatted
+ * into a buffer on the stack and written with a single write().
+ *
+ * In binary mode, events with a binary form are written as frames of the
+ * command protocol (see CommandParser.h) instead of text, with the event
+ * type as opcode. printf() output stays text in both modes.
+ */
+class EventOutput {
+  public:
+    enum EventType {
+      EVT_SIGNAL = 0x40,
+      EVT_STORED_SIGNAL = 0x41,
+      EVT_DUMP_END = 0x42
+    };
+
+    /* A decoded signal and what the signal store did with it */
+    struct SignalEvent {
+      unsigned long code;
+      uint8_t protocol;
+      uint8_t bitLength;
+      uint16_t pulseLength;
+      /* Deviation from the protocol's nominal pulse durations, microseconds */
+      uint16_t meanDeviation;
+      uint16_t maxDeviation;
+      uint16_t jitter;
+      /* The same in percent of each pulse's nominal duration */
+      uint8_t maxDeviationPercent;
+      uint8_t jitterPercent;
+      /* 0 if the signal has not been stored */
+      uint32_t id;
+      /* SignalStore::AddResult, SIGNAL_NOT_STORED for a marginal capture */
+      uint8_t storeResult;
+      uint16_t storedCount;
+      /* CodeLayout::name() of a rolling code, NULL for a fixed code */
+      const char* layout;
+      unsigned long fixedId;
+      unsigned long varying;
+    };
+
+    struct Stats {
+      unsigned long events;
+      unsigned long bytes;
+      unsigned long truncated;
+      /* Longest time write() blocked, e.g. on a full transmit buffer */
+      unsigned long maxWriteMicros;
+    };
+
+    EventOutput(Print& out);
+
+    void setBinary(bool bBinary);
+    bool isBinary() const;
+
+    void signal(const SignalEvent& event);
+    void dumpBegin();
+    void storedSignal(const SignalStore::Signal& signal);
+    void dumpEnd(unsigned int nSent, unsigned int nTotal, uint32_t lastId, bool bMore);
+    size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+
+    const Stats& stats() const;
+    void resetStats();
+
+    static const char* protocolName(int nProtocol);
+    static const char* signalQuality(const SignalEvent& event);
+    static bool isMarginal(const SignalEvent& event);
+
+  private:
+    static void formatTriState(const SignalEvent& event, char* buffer, size_t size);
+    size_t write(const uint8_t* data, size_t length);
+    size_t writeFrame(uint8_t type, const uint8_t* payload, uint8_t length);
+    static void put16(uint8_t* p, uint16_t value);
+    static void put32(uint8_t* p, uint32_t value);
+
+    Print& out;
+    bool bBinary;
+    Stats outputStats;
+};
+
+#endif
@@ -0,0 +1,148 @@
+#include "EventOutput_benchmark.h"
+
+#if ENABLE_EVENT_OUTPUT_BENCHMARK
+
+#include <stdio.h>
+
+/** Call EventOutput_benchmark::theBenchmark.run() to execute benchmarks. */
+EventOutput_benchmark EventOutput_benchmark::theBenchmark;
+
+/* Counts the writes and samples the free heap at each of them */
+class CountingSink : public Print {
+  public:
+    CountingSink() {
+      this->nWrites = 0;
+      this->nLowestFreeHeap = freeHeap();
+    }
+
+    size_t write(uint8_t c) {
+      return this->write(&c, 1);
+    }
+
+    size_t write(const uint8_t* buffer, size_t size) {
+      (void)buffer;
+      this->nWrites++;
+      const unsigned long nFree = freeHeap();
+      if (nFree < this->nLowestFreeHeap) {
+        this->nLowestFreeHeap = nFree;
+      }
+      return size;
+    }
+
+    static unsigned long freeHeap() {
+#if defined(ESP32)
+      return ESP.getFreeHeap();
+#else
+      return 0;
+#endif
+    }
+
+    unsigned long nWrites;
+    unsigned long nLowestFreeHeap;
+};
+
+/* helper function for writeLegacy(), what Print::println(const String&) does */
+static void println(Print& out, const String& line) {
+  out.write((const uint8_t*)line.c_str(), line.length());
+  out.write((const uint8_t*)"\r\n", 2);
+}
+
+/* The decode event as the sketch wrote it before EventOutput */
+static void writeLegacy(Print& out, const EventOutput::SignalEvent& event) {
+  println(out, "\n[Signal Received]");
+  println(out, "----------------");
+  println(out, "Code: " + String(event.code));
+  println(out, "Protocol: " + String(event.protocol));
+  println(out, "Bit Length: " + String(event.bitLength) + " bits");
+  println(out, "Delay: " + String(event.pulseLength) + " µs");
+  String protocolDesc = "Unknown Protocol";
+  switch (event.protocol) {
+    case 1: protocolDesc = "PT2262"; break;
+    case 2: protocolDesc = "Standard"; break;
+    case 3: protocolDesc = "Standard"; break;
+    case 4: protocolDesc = "Standard"; break;
+    case 5: protocolDesc = "Standard"; break;
+    case 6: protocolDesc = "HT6P20B"; break;
+    case 7: protocolDesc = "HS2303-PT"; break;
+    case 8: protocolDesc = "Conrad RS-200 RX"; break;
+    case 9: protocolDesc = "Conrad RS-200 TX"; break;
+    case 10: protocolDesc = "1ByOne Doorbell"; break;
+    case 11: protocolDesc = "HT12E"; break;
+    case 12: protocolDesc = "SM5212"; break;
+  }
+  println(out, "Protocol Type: " + protocolDesc);
+  String signalQuality = "Good";
+  if (event.pulseLength > 5000) {
+    signalQuality = "Poor (High Delay)";
+  } else if (event.bitLength < 12) {
+    signalQuality = "Poor (Short Bit Length)";
+  }
+  println(out, "Signal Quality: " + signalQuality);
+  println(out, "----------------");
+  println(out, "[Info] Signal stored successfully as #" + String(event.id));
+  println(out, "Total signals: " + String(event.storedCount));
+}
+
+void EventOutput_benchmark::run(Result& result, unsigned long nEvents) const {
+  EventOutput::SignalEvent event = {};
+  event.protocol = 1;
+  event.bitLength = 24;
+  event.pulseLength = 350;
+  event.meanDeviation = 12;
+  event.maxDeviation = 40;
+  event.jitter = 20;
+  event.maxDeviationPercent = 10;
+  event.jitterPercent = 5;
+  event.storeResult = SignalStore::SIGNAL_ADDED;
+  event.storedCount = 10;
+  result.events = nEvents;
+
+  CountingSink legacySink;
+  unsigned long nTotalMicros = 0;
+  result.legacyMaxMicros = 0;
+  for (unsigned long n = 0; n < nEvents; n++) {
+    event.code = 0x515455 + n;
+    event.id = n + 1;
+    const unsigned long nStartMicros = micros();
+    writeLegacy(legacySink, event);
+    const unsigned long nMicros = micros() - nStartMicros;
+    nTotalMicros += nMicros;
+    if (nMicros > result.legacyMaxMicros) result.legacyMaxMicros = nMicros;
+  }
+  result.legacyMicros = (float)nTotalMicros / nEvents;
+  result.legacyHeapBytes = CountingSink::freeHeap() - legacySink.nLowestFreeHeap;
+  result.legacyWrites = legacySink.nWrites / nEvents;
+
+  CountingSink sink;
+  EventOutput output(sink);
+  nTotalMicros = 0;
+  result.maxMicros = 0;
+  for (unsigned long n = 0; n < nEvents; n++) {
+    event.code = 0x515455 + n;
+    event.id = n + 1;
+    const unsigned long nStartMicros = micros();
+    output.signal(event);
+    const unsigned long nMicros = micros() - nStartMicros;
+    nTotalMicros += nMicros;
+    if (nMicros > result.maxMicros) result.maxMicros = nMicros;
+  }
+  result.micros = (float)nTotalMicros / nEvents;
+  result.heapBytes = CountingSink::freeHeap() - sink.nLowestFreeHeap;
+  result.writes = sink.nWrites / nEvents;
+}
+
+void EventOutput_benchmark::print(const Result& result, Print& out) {
+  char buffer[256];
+  const int n = snprintf(buffer, sizeof(buffer),
+    "Decode event, String lines against EventOutput, %lu events:\r\n"
+    "Time: %.2f us against %.2f us average, %lu us against %lu us max\r\n"
+    "Peak heap use: %lu bytes against %lu bytes\r\n"
+    "Writes: %lu against %lu per event\r\n",
+    result.events, (double)result.legacyMicros, (double)result.micros, result.legacyMaxMicros, result.maxMicros,
+    result.legacyHeapBytes, result.heapBytes, result.legacyWrites, result.writes);
+  if (n > 0) {
+    out.write((const uint8_t*)buffer, (n < (int)sizeof(buffer)) ? n : sizeof(buffer) - 1);
+  }
+}
+
+#endif
@@ -0,0 +1,48 @@
+#ifndef EVENT_OUTPUT_BENCHMARK_H
+#define EVENT_OUTPUT_BENCHMARK_H
+
+#if !defined(ENABLE_EVENT_OUTPUT_BENCHMARK)
+#define ENABLE_EVENT_OUTPUT_BENCHMARK true
+#endif
+
+#if ENABLE_EVENT_OUTPUT_BENCHMARK
+
+#include "EventOutput.h"
+
+/**
+ * Cost of a decode event written by EventOutput, next to that of the
+ * String based output it replaced: one Serial.println() of a temporary
+ * String per line.
+ *
+ * Both write into a sink that only counts, hence the UART is not part of
+ * the times. The sink samples the free heap at every write. The Strings
+ * of a line are alive while it is written, so the lowest free heap seen
+ * gives the peak heap use of an event. The heap is sampled on the ESP32
+ * only, elsewhere the heap use reads 0.
+ */
+class EventOutput_benchmark {
+  public:
+    struct Result {
+      unsigned long events;
+      /* Average and longest microseconds per event, the longest adds to the loop() time */
+      float legacyMicros;
+      unsigned long legacyMaxMicros;
+      float micros;
+      unsigned long maxMicros;
+      /* Peak heap use while an event is written, in bytes */
+      unsigned long legacyHeapBytes;
+      unsigned long heapBytes;
+      /* Calls of write() per event */
+      unsigned long legacyWrites;
+      unsigned long writes;
+    };
+
+    void run(Result& result, unsigned long nEvents = 1000) const;
+    static void print(const Result& result, Print& out);
+
+    static EventOutput_benchmark theBenchmark;
+};
+
+#endif
+
+#endif
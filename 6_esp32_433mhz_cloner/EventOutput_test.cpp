@@ -0,0 +1,108 @@
+#include "EventOutput_test.h"
+
+#if ENABLE_EVENT_OUTPUT_TEST
+
+#include <assert.h>
+#include <string.h>
+#include "test/RcSwitch_test.hpp"
+
+/** Call EventOutput_test::theTest.run() to execute tests. */
+EventOutput_test EventOutput_test::theTest;
+
+static const unsigned long CODE = 0x5A3C96UL;
+static const uint8_t CODE_BITS = 24;
+
+/* Sends the capture's frame a few times, and takes the event like decodeRfSignals() */
+void EventOutput_test::receiveCapture(RcSwitch::Receiver& receiver, void* context) {
+  Capture& capture = *(Capture*)context;
+  uint32_t usec = 100000;
+  int level = 1;
+  // the level changes at the end of each pulse
+  auto pulse = [&](uint32_t duration) {
+    usec += duration;
+    level = !level;
+    RcSwitch::RcSwitch_test::handleInterrupt(receiver, level, usec);
+  };
+
+  RcSwitch::RcSwitch_test::handleInterrupt(receiver, level, usec);
+  for (int repeat = 0; repeat < 3; repeat++) {
+    pulse(capture.synch[0] * capture.usecClock);
+    pulse(capture.synch[1] * capture.usecClock);
+    for (int i = CODE_BITS - 1; i >= 0; i--) {
+      const uint8_t* bit = capture.data[(CODE >> i) & 1];
+      uint32_t usecA = bit[0] * capture.usecClock;
+      if (i == capture.stretchedBit) {
+        usecA += usecA * capture.stretchPercent / 100;
+      }
+      pulse(usecA);
+      pulse(bit[1] * capture.usecClock);
+    }
+  }
+  pulse(capture.synch[0] * capture.usecClock);
+  pulse(capture.synch[1] * capture.usecClock);
+
+  EventOutput::SignalEvent& event = capture.event;
+  event = {};
+  if (receiver.available()) {
+    event.code = receiver.receivedValue();
+    event.protocol = receiver.bestProtocol();
+    event.bitLength = receiver.receivedBitsCount();
+    event.pulseLength = capture.usecClock;
+    event.maxDeviation = receiver.bestProtocolMaxDeviation();
+    event.jitter = receiver.bestProtocolJitter();
+    event.maxDeviationPercent = receiver.bestProtocolMaxDeviationPercent();
+    event.jitterPercent = receiver.bestProtocolJitterPercent();
+  }
+}
+
+EventOutput::SignalEvent EventOutput_test::capture(uint32_t usecClock, const uint8_t* synch,
+    const uint8_t (*data)[2], int stretchedBit, uint8_t stretchPercent) {
+  Capture capture = {usecClock, {synch[0], synch[1]}, {{data[0][0], data[0][1]}, {data[1][0], data[1][1]}},
+    stretchedBit, stretchPercent, {}};
+  RcSwitch::RcSwitch_test::withReceiver(rcSwitchProtocolTable(), &receiveCapture, &capture);
+  assert(capture.event.code == CODE);
+  assert(capture.event.bitLength == CODE_BITS);
+  return capture.event;
+}
+
+/**
+ * A clock 5% slow lengthens the 71 clocks long pulses of protocol 3 by far
+ * more microseconds than a clock, as do the 16 clocks long pulses of
+ * protocol 8. Still each pulse is only 5% off, the capture is stored.
+ */
+void EventOutput_test::testSlowClockIsStored() const {
+  static const uint8_t synch3[] = {30, 71};
+  static const uint8_t data3[][2] = {{4, 11}, {9, 6}};
+  EventOutput::SignalEvent event = capture(105, synch3, data3);
+  assert(event.protocol == 3);
+  assert(event.maxDeviation > event.pulseLength / 2);
+  assert(event.maxDeviationPercent == 5);
+  assert(event.jitterPercent == 0);
+  assert(!EventOutput::isMarginal(event));
+
+  static const uint8_t synch8[] = {3, 130};
+  static const uint8_t data8[][2] = {{7, 16}, {3, 16}};
+  event = capture(208, synch8, data8);
+  assert(event.protocol == 8);
+  assert(event.maxDeviation > event.pulseLength / 2);
+  assert(event.maxDeviationPercent == 4);
+  assert(!EventOutput::isMarginal(event));
+}
+
+/* A single pulse near the decoder's tolerance makes the capture marginal */
+void EventOutput_test::testDistortedPulseIsMarginal() const {
+  static const uint8_t synch3[] = {30, 71};
+  static const uint8_t data3[][2] = {{4, 11}, {9, 6}};
+  EventOutput::SignalEvent event = capture(100, synch3, data3, 12, 18);
+  assert(event.protocol == 3);
+  assert(event.maxDeviationPercent == 18);
+  assert(EventOutput::isMarginal(event));
+  assert(strcmp(EventOutput::signalQuality(event), "Poor (Timing)") == 0);
+}
+
+void EventOutput_test::run() const {
+  testSlowClockIsStored();
+  testDistortedPulseIsMarginal();
+}
+
+#endif
@@ -0,0 +1,45 @@
+#ifndef EVENT_OUTPUT_TEST_H
+#define EVENT_OUTPUT_TEST_H
+
+#if !defined(ENABLE_EVENT_OUTPUT_TEST)
+#define ENABLE_EVENT_OUTPUT_TEST true
+#endif
+
+#if ENABLE_EVENT_OUTPUT_TEST
+
+#include "EventOutput.h"
+#include "RcSwitchReceiverAdapter.h"
+
+/**
+ * Tests of the marginal capture rating on frames decoded by the receiver.
+ * They run on a host as well.
+ */
+class EventOutput_test {
+  public:
+    void run() const;
+
+    static EventOutput_test theTest;
+
+  private:
+    /* A frame of 24 bits in clocks of the protocol, sent with a deviating clock */
+    struct Capture {
+      uint32_t usecClock;
+      uint8_t synch[2];
+      uint8_t data[2][2];
+      /* Pulse A of this data bit is stretched by the percentage, -1 for none */
+      int stretchedBit;
+      uint8_t stretchPercent;
+      EventOutput::SignalEvent event;
+    };
+
+    static void receiveCapture(RcSwitch::Receiver& receiver, void* context);
+    static EventOutput::SignalEvent capture(uint32_t usecClock, const uint8_t* synch,
+        const uint8_t (*data)[2], int stretchedBit = -1, uint8_t stretchPercent = 0);
+
+    void testSlowClockIsStored() const;
+    void testDistortedPulseIsMarginal() const;
+};
+
+#endif
+
+#endif
@@ -0,0 +1,104 @@
+#include "LightSleep.h"
+
+#if defined(ESP32)
+#include <driver/gpio.h>
+#include <driver/uart.h>
+#include <esp_sleep.h>
+#include <esp_timer.h>
+#endif
+
+LightSleep::LightSleep() {
+  this->pin = -1;
+  this->lastPinWakeMillis = 0;
+  this->bHolding = false;
+  this->bPacketInHold = false;
+  memset(&this->sleepStats, 0, sizeof(this->sleepStats));
+}
+
+/* Call once with the receiver pin, the wake-up by serial input is enabled for good */
+void LightSleep::begin(int pin) {
+  this->pin = pin;
+#if defined(ESP32)
+  uart_set_wakeup_threshold(UART_NUM_0, LIGHT_SLEEP_UART_WAKEUP_EDGES);
+  esp_sleep_enable_uart_wakeup(UART_NUM_0);
+  esp_sleep_enable_gpio_wakeup();
+#endif
+}
+
+/**
+ * Light sleep until the level of the pin changes, serial input arrives or
+ * 'timeoutMillis' passed. Output still in the serial transmit buffer is
+ * garbled, flush() it first.
+ *
+ * @return false, if it didn't sleep: within the hold time after a wake by
+ * the pin, before begin() or on a host
+ */
+bool LightSleep::sleep(unsigned long timeoutMillis) {
+  if (this->bHolding) {
+    if (millis() - this->lastPinWakeMillis < LIGHT_SLEEP_HOLD_MILLIS) {
+      return false;
+    }
+    this->bHolding = false;
+    if (this->bPacketInHold) {
+      this->sleepStats.pinWakesWithPacket++;
+    }
+  }
+#if defined(ESP32)
+  if (this->pin < 0 || timeoutMillis == 0) {
+    return false;
+  }
+  const gpio_num_t gpio = (gpio_num_t)this->pin;
+  gpio_intr_disable(gpio);
+  gpio_wakeup_enable(gpio, gpio_get_level(gpio) ? GPIO_INTR_LOW_LEVEL : GPIO_INTR_HIGH_LEVEL);
+  esp_sleep_enable_timer_wakeup(timeoutMillis * 1000ULL);
+
+  const int64_t usecStart = esp_timer_get_time();
+  esp_light_sleep_start();
+  const int64_t usecAsleep = esp_timer_get_time() - usecStart;
+
+  gpio_wakeup_disable(gpio);
+  gpio_set_intr_type(gpio, GPIO_INTR_ANYEDGE);
+  gpio_intr_enable(gpio);
+
+  Stats& stats = this->sleepStats;
+  stats.sleeps++;
+  stats.millisAsleep += usecAsleep / 1000;
+  switch (esp_sleep_get_wakeup_cause()) {
+    case ESP_SLEEP_WAKEUP_GPIO:
+      stats.pinWakes++;
+      this->lastPinWakeMillis = millis();
+      this->bHolding = true;
+      this->bPacketInHold = false;
+      break;
+    case ESP_SLEEP_WAKEUP_TIMER: {
+      const int64_t usecLatency = usecAsleep - (int64_t)timeoutMillis * 1000;
+      stats.timerWakes++;
+      stats.usecLastTimerLatency = usecLatency > 0 ? usecLatency : 0;
+      if (stats.usecLastTimerLatency > stats.usecMaxTimerLatency) {
+        stats.usecMaxTimerLatency = stats.usecLastTimerLatency;
+      }
+      break;
+    }
+    case ESP_SLEEP_WAKEUP_UART:
+      stats.serialWakes++;
+      break;
+    default:
+      break;
+  }
+  return true;
+#else
+  (void)timeoutMillis;
+  return false;
+#endif
+}
+
+/* Call for each received packet, to tell wakes by noise from wakes by a packet */
+void LightSleep::packetReceived() {
+  if (this->bHolding) {
+    this->bPacketInHold = true;
+  }
+}
+
+const LightSleep::Stats& LightSleep::stats() const {
+  return this->sleepStats;
+}
@@ -0,0 +1,58 @@
+#ifndef LIGHT_SLEEP_H
+#define LIGHT_SLEEP_H
+
+#include <Arduino.h>
+
+// Stay awake this long after the receiver pin woke us, for the repeats of the packet
+#define LIGHT_SLEEP_HOLD_MILLIS 250
+// Edges on the serial RX line that wake us up, the first byte is lost
+#define LIGHT_SLEEP_UART_WAKEUP_EDGES 3
+
+/**
+ * Light sleep of the idle loop() on the ESP32, woken by a level change on
+ * the receiver pin, by serial input or when the next task is due.
+ *
+ * During light sleep the CPU is stopped, no edge reaches the receiver's
+ * interrupt handler. The edges of the packet that wakes us are lost, only
+ * its repeats are received. Hence sleep() doesn't sleep again until
+ * LIGHT_SLEEP_HOLD_MILLIS passed after a wake by the receiver pin.
+ *
+ * gpio_wakeup_enable() replaces the edge interrupt of the pin with a level
+ * interrupt, so the pin's interrupt is off during sleep() and restored as
+ * any edge (CHANGE) afterwards.
+ *
+ * The statistics show how a sleep ended: the timer wakes tell the wake-up
+ * latency, the time past the requested timeout. A wake by the pin without
+ * a packet is noise of the receiver or a packet that got lost entirely.
+ * Elsewhere, e.g. on a host, sleep() never sleeps.
+ */
+class LightSleep {
+  public:
+    struct Stats {
+      unsigned long sleeps;
+      unsigned long millisAsleep;
+      unsigned long pinWakes;
+      /* Wakes by the pin followed by a packet within the hold time */
+      unsigned long pinWakesWithPacket;
+      unsigned long timerWakes;
+      unsigned long serialWakes;
+      unsigned long usecLastTimerLatency;
+      unsigned long usecMaxTimerLatency;
+    };
+
+    LightSleep();
+
+    void begin(int pin);
+    bool sleep(unsigned long timeoutMillis);
+    void packetReceived();
+    const Stats& stats() const;
+
+  private:
+    int pin;
+    unsigned long lastPinWakeMillis;
+    bool bHolding;
+    bool bPacketInHold;
+    Stats sleepStats;
+};
+
+#endif
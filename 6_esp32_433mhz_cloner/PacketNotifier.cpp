@@ -0,0 +1,94 @@
+#include "PacketNotifier.h"
+
+#if defined(ESP32)
+
+PacketNotifier::PacketNotifier() {
+  this->nNotifications = 0;
+  this->hTask = NULL;
+}
+
+/* Make the calling task the one that wait()s */
+void PacketNotifier::attach() {
+  this->hTask = xTaskGetCurrentTaskHandle();
+}
+
+IRAM_ATTR void PacketNotifier::notifyFromIsr() {
+  this->nNotifications++;
+  this->wakeFromIsr();
+}
+
+IRAM_ATTR void PacketNotifier::wakeFromIsr() {
+  TaskHandle_t hTask = this->hTask;
+  if (hTask == NULL) {
+    return;
+  }
+  BaseType_t bWoken = pdFALSE;
+  vTaskNotifyGiveFromISR(hTask, &bWoken);
+  if (bWoken) {
+    portYIELD_FROM_ISR();
+  }
+}
+
+void PacketNotifier::notify() {
+  this->nNotifications++;
+  TaskHandle_t hTask = this->hTask;
+  // the waiting task itself finds the packet without a notification
+  if (hTask != NULL && hTask != xTaskGetCurrentTaskHandle()) {
+    xTaskNotifyGive(hTask);
+  }
+}
+
+/**
+ * Sleep until notified or 'timeoutMillis' passed, 0 to only check.
+ *
+ * @return true, if notified
+ */
+bool PacketNotifier::wait(unsigned long timeoutMillis) {
+  return ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(timeoutMillis)) != 0;
+}
+
+#else
+
+PacketNotifier::PacketNotifier() {
+  this->nNotifications = 0;
+  this->bPending = false;
+}
+
+void PacketNotifier::attach() {
+}
+
+void PacketNotifier::notifyFromIsr() {
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->nNotifications++;
+    this->bPending = true;
+  }
+  this->condition.notify_one();
+}
+
+void PacketNotifier::notify() {
+  this->notifyFromIsr();
+}
+
+void PacketNotifier::wakeFromIsr() {
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->bPending = true;
+  }
+  this->condition.notify_one();
+}
+
+bool PacketNotifier::wait(unsigned long timeoutMillis) {
+  std::unique_lock<std::mutex> lock(this->mutex);
+  const bool bNotified = this->condition.wait_for(lock, std::chrono::milliseconds(timeoutMillis),
+      [this] { return this->bPending; });
+  this->bPending = false;
+  return bNotified;
+}
+
+#endif
+
+/* Notifications given since start, for statistics */
+unsigned long PacketNotifier::notifications() const {
+  return this->nNotifications;
+}
@@ -0,0 +1,55 @@
+#ifndef PACKET_NOTIFIER_H
+#define PACKET_NOTIFIER_H
+
+#include <Arduino.h>
+
+#if defined(ESP32)
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#else
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#endif
+
+/**
+ * Wakes the task waiting for received packets, instead of it polling
+ * available() on every pass of loop().
+ *
+ * notifyFromIsr() is called from the receiver's available callback. On
+ * the ESP32 it gives a FreeRTOS task notification to the task that called
+ * attach(), which sleeps in wait() meanwhile. Elsewhere, e.g. on a host
+ * for tests, a condition variable does the same.
+ *
+ * notify() is the same for task context, e.g. a packet decoded by the
+ * receiver's wake() in loop(). Called by the waiting task itself, it only
+ * counts the packet. wakeFromIsr() wakes the task without counting a
+ * packet, e.g. for the receiver's wake request.
+ *
+ * Notifications given while nobody waits are kept, several of them wake
+ * wait() only once.
+ */
+class PacketNotifier {
+  public:
+    PacketNotifier();
+
+    void attach();
+    void notifyFromIsr();
+    void notify();
+    void wakeFromIsr();
+    bool wait(unsigned long timeoutMillis);
+
+    unsigned long notifications() const;
+
+  private:
+    volatile unsigned long nNotifications;
+#if defined(ESP32)
+    volatile TaskHandle_t hTask;
+#else
+    std::mutex mutex;
+    std::condition_variable condition;
+    bool bPending;
+#endif
+};
+
+#endif
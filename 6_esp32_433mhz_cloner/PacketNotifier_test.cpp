@@ -0,0 +1,66 @@
+#include "PacketNotifier_test.h"
+
+#if ENABLE_PACKET_NOTIFIER_TEST
+
+#include <assert.h>
+#include <chrono>
+#include <thread>
+
+/** Call PacketNotifier_test::theTest.run() to execute tests. */
+PacketNotifier_test PacketNotifier_test::theTest;
+
+/* A notification before wait() is kept, several wake it once */
+void PacketNotifier_test::testPending() const {
+  PacketNotifier notifier;
+  notifier.attach();
+  notifier.notifyFromIsr();
+  notifier.notifyFromIsr();
+  assert(notifier.notifications() == 2);
+  assert(notifier.wait(0));
+  assert(!notifier.wait(0));
+}
+
+/* A wake request wakes wait(), but is no packet */
+void PacketNotifier_test::testWakeRequest() const {
+  PacketNotifier notifier;
+  notifier.attach();
+  notifier.wakeFromIsr();
+  assert(notifier.notifications() == 0);
+  assert(notifier.wait(0));
+  notifier.notify();
+  assert(notifier.notifications() == 1);
+}
+
+void PacketNotifier_test::testTimeout() const {
+  PacketNotifier notifier;
+  notifier.attach();
+  const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  assert(!notifier.wait(20));
+  assert(std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(20));
+}
+
+/* The receiver completes a packet while the consumer sleeps */
+void PacketNotifier_test::testWakeUp() const {
+  PacketNotifier notifier;
+  notifier.attach();
+  for (int i = 0; i < 20; i++) {
+    std::thread receiver([&notifier] {
+      std::this_thread::sleep_for(std::chrono::milliseconds(2));
+      notifier.notifyFromIsr();
+    });
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    assert(notifier.wait(10000));
+    assert(std::chrono::steady_clock::now() - start < std::chrono::seconds(5));
+    receiver.join();
+  }
+  assert(notifier.notifications() == 20);
+}
+
+void PacketNotifier_test::run() const {
+  testPending();
+  testWakeRequest();
+  testTimeout();
+  testWakeUp();
+}
+
+#endif
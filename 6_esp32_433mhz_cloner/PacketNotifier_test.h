@@ -0,0 +1,36 @@
+#ifndef PACKET_NOTIFIER_TEST_H
+#define PACKET_NOTIFIER_TEST_H
+
+// The test notifies from a thread, hence it runs on a host only
+#if !defined(ENABLE_PACKET_NOTIFIER_TEST)
+#if defined(ESP32)
+#define ENABLE_PACKET_NOTIFIER_TEST false
+#else
+#define ENABLE_PACKET_NOTIFIER_TEST true
+#endif
+#endif
+
+#if ENABLE_PACKET_NOTIFIER_TEST
+
+#include "PacketNotifier.h"
+
+/**
+ * Tests of the condition variable implementation of the packet notifier,
+ * the host equivalent of the FreeRTOS task notification.
+ */
+class PacketNotifier_test {
+  public:
+    void run() const;
+
+    static PacketNotifier_test theTest;
+
+  private:
+    void testPending() const;
+    void testWakeRequest() const;
+    void testTimeout() const;
+    void testWakeUp() const;
+};
+
+#endif
+
+#endif
@@ -0,0 +1,37 @@
+#include "RcSwitchReceiverAdapter.h"
+
+// Equivalent to proto[] in RCSwitch.cpp. Pulse pairs are given in the order
+// they are sent, i.e. low before high for inverse level protocols. The
+// tolerance is per pulse, unlike the receive tolerance of RCSwitch that
+// applies to the base pulse length.
+DATA_ISR_ATTR static const RxProtocolTable <
+  //               #, clk,  %, syA,  syB,  d0A,d0B,  d1A,d1B, inverseLevel
+  makeTimingSpec<  1, 350, 20,   1,   31,    1,  3,    3,  1, false>, // (PT2262)
+  makeTimingSpec<  2, 650, 20,   1,   10,    1,  2,    2,  1, false>, // ()
+  makeTimingSpec<  3, 100, 20,  30,   71,    4, 11,    9,  6, false>, // ()
+  makeTimingSpec<  4, 380, 20,   1,    6,    1,  3,    3,  1, false>, // ()
+  makeTimingSpec<  5, 500, 20,   6,   14,    1,  2,    2,  1, false>, // ()
+  makeTimingSpec<  6, 450, 20,  23,    1,    1,  2,    2,  1, true>,  // (HT6P20B)
+  makeTimingSpec<  7, 150, 20,   2,   62,    1,  6,    6,  1, false>, // (HS2303-PT)
+  makeTimingSpec<  8, 200, 20,   3,  130,    7, 16,    3, 16, false>, // (Conrad RS-200 RX)
+  makeTimingSpec<  9, 200, 20, 130,    7,   16,  7,   16,  3, true>,  // (Conrad RS-200 TX)
+  makeTimingSpec< 10, 365, 20,  18,    1,    3,  1,    1,  3, true>,  // (1ByOne Doorbell)
+  makeTimingSpec< 11, 270, 20,  36,    1,    1,  2,    2,  1, true>,  // (HT12E)
+  makeTimingSpec< 12, 320, 20,  36,    1,    1,  2,    2,  1, true>,  // (SM5212)
+  makeTimingSpec< 13, 400, 20,   1,   10,    2,  1,    1,  2, false>  // (KeeLoq HCS), receive only
+> rcSwitchProtocols;
+
+static const unsigned int rcSwitchPulseLengths[] = {
+  350, 650, 100, 380, 500, 450, 150, 200, 200, 365, 270, 320, 400
+};
+
+RcSwitch::RxTimingSpecTable rcSwitchProtocolTable() {
+  return rcSwitchProtocols.toTimingSpecTable();
+}
+
+unsigned int rcSwitchProtocolPulseLength(int nProtocol) {
+  const int nCount = sizeof(rcSwitchPulseLengths) / sizeof(rcSwitchPulseLengths[0]);
+  if (nProtocol < 1 || nProtocol > nCount)
+    return 0;
+  return rcSwitchPulseLengths[nProtocol - 1];
+}
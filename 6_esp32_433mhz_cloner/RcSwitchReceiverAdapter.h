@@ -0,0 +1,161 @@
+#ifndef RCSWITCH_RECEIVER_ADAPTER_H
+#define RCSWITCH_RECEIVER_ADAPTER_H
+
+#include <RCSwitch.h>
+#include "ProtocolDefinition.hpp"
+#include "RcSwitchReceiver.hpp"
+
+/**
+ * The timing specs of the rc-switch protocols 1 to 12, same numbers, and
+ * of KeeLoq HCS as protocol 13. RCSwitch can't send protocol 13.
+ */
+RcSwitch::RxTimingSpecTable rcSwitchProtocolTable();
+
+/**
+ * @return the nominal pulse length of an rc-switch protocol in
+ * microseconds, 0 for an unknown protocol.
+ */
+unsigned int rcSwitchProtocolPulseLength(int nProtocol);
+
+/**
+ * Receive with RcSwitchReceiver, but provide the receive API of RCSwitch.
+ *
+ * RcSwitchReceiver decodes pulse by pulse in the interrupt handler instead
+ * of trying all protocols on the recorded timings at the end of a frame.
+ * When several protocols match a code, the best fitting one is reported.
+ *
+ * The receiver follows the transmit window of RCSwitch, hence it ignores
+ * the echo of our own transmissions.
+ */
+template<int IOPIN> class RcSwitchReceiverAdapter {
+  typedef RcSwitchReceiver<IOPIN> receiver_t;
+
+  TEXT_ISR_ATTR_0 static void onTransmitWindow(bool bActive) {
+    if (bActive) {
+      receiver_t::beginTransmitWindow();
+    } else {
+      receiver_t::endTransmitWindow();
+    }
+  }
+
+  public:
+    void enableReceive() {
+      receiver_t::begin(rcSwitchProtocolTable());
+      RCSwitch::setTransmitWindowCallback(&onTransmitWindow);
+    }
+
+    /* Stop receiving, e.g. to let RCSwitch receive on the pin */
+    void disableReceive() {
+      detachInterrupt(digitalPinToInterrupt(IOPIN));
+      receiver_t::resetAvailable();
+    }
+
+    bool available() {
+      return receiver_t::available();
+    }
+
+    void resetAvailable() {
+      receiver_t::resetAvailable();
+    }
+
+    /**
+     * Call 'callback' from the interrupt handler when a code becomes
+     * available, see RcSwitchReceiver::setAvailableCallback().
+     */
+    void setAvailableCallback(void (*callback)()) {
+      receiver_t::setAvailableCallback(callback);
+    }
+
+    unsigned long getReceivedValue() {
+      return receiver_t::available() ? receiver_t::receivedValue() : 0;
+    }
+
+    unsigned int getReceivedBitlength() {
+      return receiver_t::available() ? receiver_t::receivedBitsCount() : 0;
+    }
+
+    /**
+     * @return the bits received after the first 32, the first of them
+     * highest, see RcSwitchReceiver::receivedOverflowValue()
+     */
+    unsigned long getReceivedOverflowValue() {
+      return receiver_t::available() ? receiver_t::receivedOverflowValue() : 0;
+    }
+
+    /**
+     * @return the pulse length the code was sent with. Unlike RCSwitch,
+     * it is measured over all data pulses instead of the sync pulse:
+     * the nominal pulse length of the received protocol, scaled by the
+     * received to nominal duration of the data pulses.
+     */
+    unsigned int getReceivedDelay() {
+      const unsigned long nNominal = rcSwitchProtocolPulseLength(receiver_t::bestProtocol());
+      const unsigned long nNominalDuration = receiver_t::bestProtocolDataDuration();
+      if (nNominalDuration == 0)
+        return nNominal;
+      return (nNominal * receiver_t::receivedDataDuration() + nNominalDuration / 2) / nNominalDuration;
+    }
+
+    /**
+     * @return the average deviation of a received pulse from the nominal
+     * pulse duration of the received protocol in microseconds
+     */
+    unsigned int getReceivedMeanDeviation() {
+      return receiver_t::bestProtocolTimingError();
+    }
+
+    /* @return the largest deviation of a data pulse in microseconds */
+    unsigned int getReceivedMaxDeviation() {
+      return receiver_t::bestProtocolMaxDeviation();
+    }
+
+    /**
+     * @return the jitter of the data pulses in microseconds, see
+     * RcSwitchReceiver::bestProtocolJitter()
+     */
+    unsigned int getReceivedJitter() {
+      return receiver_t::bestProtocolJitter();
+    }
+
+    /* @return getReceivedMaxDeviation() in percent of the pulse's nominal duration */
+    unsigned int getReceivedMaxDeviationPercent() {
+      return receiver_t::bestProtocolMaxDeviationPercent();
+    }
+
+    /* @return getReceivedJitter() in percent of the pulses' nominal durations */
+    unsigned int getReceivedJitterPercent() {
+      return receiver_t::bestProtocolJitterPercent();
+    }
+
+    unsigned int getReceivedProtocol() {
+      const int nProtocol = receiver_t::bestProtocol();
+      return (nProtocol < 0) ? 0 : nProtocol;
+    }
+
+    /**
+     * Let the decoder sleep while the CPU is idle, see
+     * RcSwitchReceiver::sleep(). 'callback' is called from the interrupt
+     * handler when a received pulse requests to wake it up.
+     */
+    void setWakeCallback(void (*callback)()) {
+      receiver_t::setWakeCallback(callback);
+    }
+
+    void sleep() {
+      receiver_t::sleep();
+    }
+
+    void wake() {
+      receiver_t::wake();
+    }
+
+    const RcSwitch::EdgeCapture::Statistics& getWakeStatistics() {
+      return receiver_t::wakeStatistics();
+    }
+
+    unsigned long getSelfEchoCount() {
+      return receiver_t::selfEchoPulseCount();
+    }
+};
+
+#endif
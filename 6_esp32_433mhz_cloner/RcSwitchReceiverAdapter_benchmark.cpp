@@ -0,0 +1,100 @@
+#include "RcSwitchReceiverAdapter_benchmark.h"
+
+#if ENABLE_RCSWITCH_RECEIVER_ADAPTER_BENCHMARK && ENABLE_RCSWITCH_BENCHMARK
+
+#include <stdio.h>
+#include "test/RcSwitch_test.hpp"
+
+/** Call RcSwitchReceiverAdapter_benchmark::theBenchmark.run() to execute benchmarks. */
+RcSwitchReceiverAdapter_benchmark RcSwitchReceiverAdapter_benchmark::theBenchmark;
+
+static const unsigned int nRounds = 64;
+static const unsigned int nFrames = 3;
+static const unsigned long benchmarkCode = 0x5A5A5A;
+static const unsigned int nBenchmarkLength = 24;
+static const int nBenchmarkProtocols = 12;
+
+/* The frames to play and the times taken, for benchmarkReceiver() */
+struct ReceiverBenchmark {
+  RCSwitch::Waveform waveform;
+  RCSwitch_benchmark::TickCounter ticks;
+  uint32_t nWorstTicks;
+  uint64_t nTotalTicks;
+  unsigned int nTotalEdges;
+  bool bDecoded;
+};
+
+/* Play the frames of one protocol, keep the best time of each edge over all rounds */
+static void benchmarkReceiver(RcSwitch::Receiver& receiver, void* context) {
+  ReceiverBenchmark& benchmark = *(ReceiverBenchmark*)context;
+  const RCSwitch::Waveform& waveform = benchmark.waveform;
+  // the last edge ends the sync gap of the last frame
+  const unsigned int nEdges = nFrames * waveform.count + 1;
+  uint32_t nEdgeTicks[nFrames * RCSWITCH_MAX_CHANGES + 1];
+  for (unsigned int i = 0; i < nEdges; i++) {
+    nEdgeTicks[i] = UINT32_MAX;
+  }
+
+  uint32_t usec = 0;
+  benchmark.bDecoded = false;
+  for (unsigned int nRound = 0; nRound < nRounds; nRound++) {
+    usec += 100000;
+    for (unsigned int i = 0; i < nEdges; i++) {
+      const unsigned int nPulse = i % waveform.count;
+      const int level = (nPulse & 1) ? !waveform.firstLevel : waveform.firstLevel;
+      const uint32_t nStart = benchmark.ticks();
+      RcSwitch::RcSwitch_test::handleInterrupt(receiver, level, usec);
+      const uint32_t nTicks = benchmark.ticks() - nStart;
+      if (nTicks < nEdgeTicks[i]) nEdgeTicks[i] = nTicks;
+      usec += waveform.durations[nPulse];
+    }
+    if (nRound == 0) {
+      benchmark.bDecoded = receiver.available() && receiver.receivedValue() == benchmarkCode;
+    }
+    receiver.resetAvailable();
+  }
+
+  for (unsigned int i = 0; i < nEdges; i++) {
+    if (nEdgeTicks[i] > benchmark.nWorstTicks) benchmark.nWorstTicks = nEdgeTicks[i];
+    benchmark.nTotalTicks += nEdgeTicks[i];
+  }
+  benchmark.nTotalEdges += nEdges;
+}
+
+void RcSwitchReceiverAdapter_benchmark::run(Result& result, RCSwitch_benchmark::TickCounter ticks, uint32_t nTicksPerMicrosecond) const {
+  RCSwitch_benchmark::benchmarkDecode(result.legacy, ticks, nTicksPerMicrosecond);
+
+  RCSwitch tx;
+  ReceiverBenchmark benchmark;
+  benchmark.ticks = ticks;
+  benchmark.nWorstTicks = 0;
+  benchmark.nTotalTicks = 0;
+  benchmark.nTotalEdges = 0;
+  result.nAdapterDecodedProtocols = 0;
+  for (int nProtocol = 1; nProtocol <= nBenchmarkProtocols; nProtocol++) {
+    tx.setProtocol(nProtocol);
+    tx.compileWaveform(benchmarkCode, nBenchmarkLength, benchmark.waveform);
+    RcSwitch::RcSwitch_test::withReceiver(rcSwitchProtocolTable(), &benchmarkReceiver, &benchmark);
+    if (benchmark.bDecoded) {
+      result.nAdapterDecodedProtocols++;
+    }
+  }
+  result.nsAdapterWorst = (uint64_t)benchmark.nWorstTicks * 1000 / nTicksPerMicrosecond;
+  result.nsAdapterMean = benchmark.nTotalTicks * 1000 / nTicksPerMicrosecond / benchmark.nTotalEdges;
+}
+
+void RcSwitchReceiverAdapter_benchmark::print(const Result& result, Print& out) {
+  char buffer[192];
+  const int n = snprintf(buffer, sizeof(buffer),
+    "Interrupt handler worst case: legacy %lu ns, adapter %lu ns\r\n"
+    "Adapter: %lu ns per edge, %u of 12 protocols decoded\r\n"
+    "Legacy: %lu ns mean decode, %u of 12 protocols decoded\r\n",
+    (unsigned long)result.legacy.nsDecodeWorst, (unsigned long)result.nsAdapterWorst,
+    (unsigned long)result.nsAdapterMean, result.nAdapterDecodedProtocols,
+    (unsigned long)result.legacy.nsDecodeMean, result.legacy.nDecodedProtocols);
+  if (n > 0) {
+    out.write((const uint8_t*)buffer, (n < (int)sizeof(buffer)) ? n : sizeof(buffer) - 1);
+  }
+}
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef RCSWITCH_RECEIVER_ADAPTER_BENCHMARK_H
+#define RCSWITCH_RECEIVER_ADAPTER_BENCHMARK_H
+
+#if !defined(ENABLE_RCSWITCH_RECEIVER_ADAPTER_BENCHMARK)
+#define ENABLE_RCSWITCH_RECEIVER_ADAPTER_BENCHMARK true
+#endif
+
+#include <RCSwitch_benchmark.h>
+
+#if ENABLE_RCSWITCH_RECEIVER_ADAPTER_BENCHMARK && ENABLE_RCSWITCH_BENCHMARK
+
+#include "RcSwitchReceiverAdapter.h"
+
+/**
+ * Interrupt handler times of the receiver behind the adapter, next to
+ * those of the legacy RCSwitch decoder on the same frames: three 24 bit
+ * frames of each protocol 1 to 12.
+ *
+ * The edges are passed to a receiver of its own, not to the one of the
+ * sketch, hence the benchmark can run next to the receiver. Times are
+ * taken like by RCSwitch_benchmark.
+ */
+class RcSwitchReceiverAdapter_benchmark {
+  public:
+    struct Result {
+      /* Longest and average call of the interrupt handler, over all edges */
+      uint32_t nsAdapterWorst;
+      uint32_t nsAdapterMean;
+      unsigned int nAdapterDecodedProtocols;
+      /* The legacy decoder, only the decode part is filled in */
+      RCSwitch_benchmark::Result legacy;
+    };
+
+    void run(Result& result, RCSwitch_benchmark::TickCounter ticks, uint32_t nTicksPerMicrosecond) const;
+    static void print(const Result& result, Print& out);
+
+    static RcSwitchReceiverAdapter_benchmark theBenchmark;
+};
+
+#endif
+
+#endif
@@ -0,0 +1,106 @@
+#include "SignalDump.h"
+
+SignalDump::SignalDump(SignalStore& store, EventOutput& output) : store(store), output(output) {
+  this->bActive = false;
+  this->nLastId = 0;
+  this->nLimit = 0;
+  this->nSent = 0;
+  this->nMatchCode = 0;
+  this->nMatchMask = 0;
+  this->nMatchBitLength = 0;
+}
+
+/**
+ * Start listing the signals with an ID above 'sinceId', at most 'limit'
+ * of them, 0 for all. A running listing is ended first.
+ */
+void SignalDump::begin(uint32_t sinceId, uint16_t limit) {
+  this->nMatchBitLength = 0;
+  this->start(sinceId, limit);
+}
+
+/**
+ * Start listing the signals of 'bitLength' bits whose code has the bits of
+ * 'code' where 'mask' is set.
+ */
+void SignalDump::beginMatching(unsigned long code, unsigned long mask, uint8_t bitLength) {
+  this->nMatchCode = code & mask;
+  this->nMatchMask = mask;
+  this->nMatchBitLength = bitLength;
+  this->start(0, 0);
+}
+
+void SignalDump::start(uint32_t sinceId, uint16_t limit) {
+  if (this->bActive) {
+    this->finish(true);
+  }
+  this->nLastId = sinceId;
+  this->nLimit = limit;
+  this->nSent = 0;
+
+  if (sinceId == 0 && this->store.size() == 0 && !this->output.isBinary()) {
+    this->output.printf("\n[Info] No codes stored in memory\n");
+    return;
+  }
+  this->output.dumpBegin();
+  this->bActive = true;
+}
+
+/* Stop a running listing without writing its end */
+void SignalDump::cancel() {
+  this->bActive = false;
+}
+
+bool SignalDump::active() const {
+  return this->bActive;
+}
+
+/**
+ * Write the next signals of a running listing, as many as fit into
+ * 'nWriteSpace' bytes, e.g. Serial.availableForWrite(). A filtered listing
+ * looks at no more than SIGNAL_DUMP_SCANS_PER_STEP signals.
+ */
+void SignalDump::run(size_t nWriteSpace) {
+  if (!this->bActive) {
+    return;
+  }
+  int nScans = 0;
+  for (int i = 0; i < SIGNAL_DUMP_RECORDS_PER_STEP; i++) {
+    if (nWriteSpace < SIGNAL_DUMP_RECORD_BYTES) {
+      return;
+    }
+    SignalStore::Signal* pSignal;
+    do {
+      if (nScans++ == SIGNAL_DUMP_SCANS_PER_STEP) {
+        return;
+      }
+      pSignal = this->store.nextById(this->nLastId);
+      if (pSignal == NULL) {
+        this->finish(false);
+        return;
+      }
+      if (!this->matches(*pSignal)) {
+        this->nLastId = pSignal->id;
+        pSignal = NULL;
+      }
+    } while (pSignal == NULL);
+    if (this->nLimit != 0 && this->nSent >= this->nLimit) {
+      this->finish(true);
+      return;
+    }
+    this->output.storedSignal(*pSignal);
+    this->nLastId = pSignal->id;
+    this->nSent++;
+    nWriteSpace -= SIGNAL_DUMP_RECORD_BYTES;
+  }
+}
+
+bool SignalDump::matches(const SignalStore::Signal& signal) const {
+  return this->nMatchBitLength == 0
+      || (signal.bitLength == this->nMatchBitLength && (signal.code & this->nMatchMask) == this->nMatchCode);
+}
+
+void SignalDump::finish(bool bMore) {
+  this->output.dumpEnd(this->nSent, this->store.size(), this->nLastId, bMore);
+  this->bActive = false;
+}
@@ -0,0 +1,58 @@
+#ifndef SIGNAL_DUMP_H
+#define SIGNAL_DUMP_H
+
+#include "SignalStore.h"
+#include "EventOutput.h"
+
+// Most signals written by one run()
+#define SIGNAL_DUMP_RECORDS_PER_STEP 4
+// Write space one listed signal needs, text or frame
+#define SIGNAL_DUMP_RECORD_BYTES 48
+// Most signals looked at by one run() of a filtered listing
+#define SIGNAL_DUMP_SCANS_PER_STEP 16
+
+/**
+ * Non-blocking listing of the stored signals ("refresh data").
+ *
+ * begin() starts a listing and run(), called from loop(), writes a few
+ * signals at a time, never more than fit into the free space of the
+ * output's transmit buffer. Hence neither loop() nor the receiver wait
+ * for the UART while a long listing is sent.
+ *
+ * The signals are listed in the order of their IDs. Since IDs are never
+ * reused, the ID of the last listed signal is the cursor: a listing can
+ * continue after it ("refresh since <id>"), and signals added or removed
+ * while a listing runs neither repeat nor shift any other signal.
+ *
+ * beginMatching() lists only the signals whose code matches a pattern,
+ * e.g. the tri-state device address of "find <pattern>".
+ */
+class SignalDump {
+  public:
+    SignalDump(SignalStore& store, EventOutput& output);
+
+    void begin(uint32_t sinceId = 0, uint16_t limit = 0);
+    void beginMatching(unsigned long code, unsigned long mask, uint8_t bitLength);
+    void cancel();
+    bool active() const;
+
+    void run(size_t nWriteSpace);
+
+  private:
+    void start(uint32_t sinceId, uint16_t limit);
+    bool matches(const SignalStore::Signal& signal) const;
+    void finish(bool bMore);
+
+    SignalStore& store;
+    EventOutput& output;
+    bool bActive;
+    uint32_t nLastId;
+    uint16_t nLimit;
+    unsigned int nSent;
+    /* Filter of beginMatching(), bit length 0 for none */
+    unsigned long nMatchCode;
+    unsigned long nMatchMask;
+    uint8_t nMatchBitLength;
+};
+
+#endif
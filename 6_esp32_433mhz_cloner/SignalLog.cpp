@@ -0,0 +1,323 @@
+#include "SignalLog.h"
+
+#include <string.h>
+#include <unistd.h>
+
+FileSignalLogStorage::FileSignalLogStorage(const char* path) {
+  strncpy(this->path, path, sizeof(this->path) - 1);
+  this->path[sizeof(this->path) - 1] = '\0';
+  snprintf(this->rewritePath, sizeof(this->rewritePath), "%s.tmp", this->path);
+  this->file = NULL;
+  this->rewriteFile = NULL;
+}
+
+FileSignalLogStorage::~FileSignalLogStorage() {
+  this->close();
+}
+
+bool FileSignalLogStorage::open() {
+  this->close();
+  FILE* existing = fopen(this->path, "rb");
+  if (existing != NULL) {
+    fclose(existing);
+  } else {
+    // a rewrite was interrupted between removing the log and renaming
+    rename(this->rewritePath, this->path);
+  }
+  this->file = fopen(this->path, "a+b");
+  return this->file != NULL;
+}
+
+void FileSignalLogStorage::close() {
+  if (this->rewriteFile != NULL) {
+    fclose(this->rewriteFile);
+    this->rewriteFile = NULL;
+  }
+  if (this->file != NULL) {
+    fclose(this->file);
+    this->file = NULL;
+  }
+}
+
+uint32_t FileSignalLogStorage::size() {
+  if (this->file == NULL || fseek(this->file, 0, SEEK_END) != 0) {
+    return 0;
+  }
+  const long nSize = ftell(this->file);
+  return nSize < 0 ? 0 : nSize;
+}
+
+bool FileSignalLogStorage::read(uint32_t offset, void* data, size_t length) {
+  return this->file != NULL
+      && fseek(this->file, offset, SEEK_SET) == 0
+      && fread(data, 1, length, this->file) == length;
+}
+
+bool FileSignalLogStorage::append(const void* data, size_t length) {
+  // "a" mode appends anyway, but switching from reading to writing
+  // requires a seek
+  return this->file != NULL
+      && fseek(this->file, 0, SEEK_END) == 0
+      && fwrite(data, 1, length, this->file) == length
+      && sync(this->file);
+}
+
+bool FileSignalLogStorage::beginRewrite() {
+  if (this->rewriteFile != NULL) {
+    fclose(this->rewriteFile);
+  }
+  this->rewriteFile = fopen(this->rewritePath, "wb");
+  return this->rewriteFile != NULL;
+}
+
+bool FileSignalLogStorage::appendRewrite(const void* data, size_t length) {
+  return this->rewriteFile != NULL
+      && fwrite(data, 1, length, this->rewriteFile) == length;
+}
+
+bool FileSignalLogStorage::commitRewrite() {
+  if (this->rewriteFile == NULL) {
+    return false;
+  }
+  const bool bWritten = sync(this->rewriteFile);
+  fclose(this->rewriteFile);
+  this->rewriteFile = NULL;
+  if (!bWritten) {
+    remove(this->rewritePath);
+    return false;
+  }
+
+  if (this->file != NULL) {
+    fclose(this->file);
+    this->file = NULL;
+  }
+  if (rename(this->rewritePath, this->path) != 0) {
+    // not every file system replaces the target, open() recovers if the
+    // reset hits in between
+    remove(this->path);
+    if (rename(this->rewritePath, this->path) != 0) {
+      return false;
+    }
+  }
+  this->file = fopen(this->path, "a+b");
+  return this->file != NULL;
+}
+
+bool FileSignalLogStorage::sync(FILE* file) {
+  return fflush(file) == 0 && fsync(fileno(file)) == 0;
+}
+
+SignalLog::SignalLog(SignalLogStorage& storage) : storage(storage) {
+  this->nSnapshotBytes = 0;
+  this->nTailBytes = 0;
+  memset(&this->logStats, 0, sizeof(this->logStats));
+}
+
+/**
+ * Replace the content of 'store' with the signals in the log. A log that
+ * is missing, torn or corrupt is rewritten from what could be loaded.
+ *
+ * @return false, if the storage can't be opened or rewritten
+ */
+bool SignalLog::load(SignalStore& store) {
+  store.clear();
+  this->logStats.loadedSignals = 0;
+  this->logStats.loadedRecords = 0;
+  this->logStats.droppedTail = false;
+  if (!this->storage.open()) {
+    return false;
+  }
+
+  const uint32_t nSize = this->storage.size();
+  uint32_t offset = 0;
+  if (!this->loadSnapshot(store, offset)) {
+    this->logStats.droppedTail = nSize > 0;
+    return this->compact(store);
+  }
+
+  while (offset < nSize) {
+    uint8_t record[2 + SIGNAL_BYTES + 4];
+    if (offset + 2 > nSize || !this->storage.read(offset, record, 2)) {
+      break;
+    }
+    const uint8_t type = record[0];
+    const uint8_t length = record[1];
+    if (!((type == RECORD_ADD && length == SIGNAL_BYTES) || (type == RECORD_REMOVE && length == 4))
+        || offset + 2 + length + 4 > nSize
+        || !this->storage.read(offset + 2, record + 2, length + 4)
+        || crc32(0, record, 2 + length) != get32(record + 2 + length)) {
+      break;
+    }
+
+    if (type == RECORD_ADD) {
+      restoreSignal(store, record + 2);
+    } else {
+      store.remove(get32(record + 2));
+    }
+    offset += 2 + length + 4;
+    this->logStats.loadedRecords++;
+  }
+  this->nTailBytes = offset - this->nSnapshotBytes;
+
+  if (offset < nSize) {
+    // appending after a torn record would hide the new records
+    this->logStats.droppedTail = true;
+    return this->compact(store);
+  }
+  return true;
+}
+
+bool SignalLog::logAdd(const SignalStore::Signal& signal) {
+  uint8_t payload[SIGNAL_BYTES];
+  packSignal(payload, signal);
+  return this->appendRecord(RECORD_ADD, payload, sizeof(payload));
+}
+
+bool SignalLog::logRemove(uint32_t id) {
+  uint8_t payload[4];
+  put32(payload, id);
+  return this->appendRecord(RECORD_REMOVE, payload, sizeof(payload));
+}
+
+/**
+ * Write the content of 'store' as the new snapshot and drop the records.
+ * Logs a cleared store as well.
+ */
+bool SignalLog::compact(SignalStore& store) {
+  uint8_t header[HEADER_BYTES];
+  uint8_t packed[SIGNAL_BYTES];
+  const uint32_t nCount = store.size();
+
+  // the CRC comes first, the signals are packed twice
+  put32(header + 4, nCount);
+  uint32_t crc = crc32(0, header + 4, 4);
+  for (SignalStore::Signal* pSignal = store.leastRecentlyUsed(); pSignal != NULL; pSignal = store.moreRecentlyUsed(pSignal)) {
+    packSignal(packed, *pSignal);
+    crc = crc32(crc, packed, sizeof(packed));
+  }
+  put32(header, MAGIC);
+  put32(header + 8, crc);
+
+  bool bWritten = this->storage.beginRewrite()
+      && this->storage.appendRewrite(header, sizeof(header));
+  for (SignalStore::Signal* pSignal = store.leastRecentlyUsed(); bWritten && pSignal != NULL; pSignal = store.moreRecentlyUsed(pSignal)) {
+    packSignal(packed, *pSignal);
+    bWritten = this->storage.appendRewrite(packed, sizeof(packed));
+  }
+  if (!bWritten || !this->storage.commitRewrite()) {
+    return false;
+  }
+
+  this->nSnapshotBytes = HEADER_BYTES + nCount * SIGNAL_BYTES;
+  this->nTailBytes = 0;
+  this->logStats.compactions++;
+  return true;
+}
+
+/* Compact once the records take more space than the snapshot and a minimum */
+bool SignalLog::compactIfNeeded(SignalStore& store) {
+  if (this->nTailBytes < SIGNAL_LOG_COMPACT_BYTES || this->nTailBytes < this->nSnapshotBytes) {
+    return true;
+  }
+  return this->compact(store);
+}
+
+/* Bytes of the records after the snapshot */
+uint32_t SignalLog::tailBytes() const {
+  return this->nTailBytes;
+}
+
+const SignalLog::Stats& SignalLog::stats() const {
+  return this->logStats;
+}
+
+/* The snapshot is read in blocks, the store is cleared again if the CRC fails */
+bool SignalLog::loadSnapshot(SignalStore& store, uint32_t& offset) {
+  uint8_t header[HEADER_BYTES];
+  if (!this->storage.read(0, header, sizeof(header)) || get32(header) != MAGIC) {
+    return false;
+  }
+  const uint32_t nCount = get32(header + 4);
+  if (HEADER_BYTES + nCount * SIGNAL_BYTES > this->storage.size()) {
+    return false;
+  }
+
+  uint8_t block[16 * SIGNAL_BYTES];
+  uint32_t crc = crc32(0, header + 4, 4);
+  offset = HEADER_BYTES;
+  for (uint32_t n = 0; n < nCount; ) {
+    const uint32_t nBlockCount = nCount - n < 16 ? nCount - n : 16;
+    if (!this->storage.read(offset, block, nBlockCount * SIGNAL_BYTES)) {
+      return false;
+    }
+    crc = crc32(crc, block, nBlockCount * SIGNAL_BYTES);
+    for (uint32_t i = 0; i < nBlockCount; i++) {
+      restoreSignal(store, block + i * SIGNAL_BYTES);
+    }
+    n += nBlockCount;
+    offset += nBlockCount * SIGNAL_BYTES;
+  }
+  if (crc != get32(header + 8)) {
+    store.clear();
+    return false;
+  }
+
+  this->nSnapshotBytes = offset;
+  this->logStats.loadedSignals = nCount;
+  return true;
+}
+
+bool SignalLog::appendRecord(uint8_t type, const uint8_t* payload, uint8_t length) {
+  uint8_t record[2 + SIGNAL_BYTES + 4];
+  record[0] = type;
+  record[1] = length;
+  memcpy(record + 2, payload, length);
+  put32(record + 2 + length, crc32(0, record, 2 + length));
+  if (!this->storage.append(record, 2 + length + 4)) {
+    return false;
+  }
+  this->nTailBytes += 2 + length + 4;
+  this->logStats.appendedBytes += 2 + length + 4;
+  return true;
+}
+
+/* CRC-32 (IEEE 802.3), chained through 'crc', 0 to start */
+uint32_t SignalLog::crc32(uint32_t crc, const uint8_t* data, size_t length) {
+  crc = ~crc;
+  while (length--) {
+    crc ^= *data++;
+    for (int bit = 0; bit < 8; bit++) {
+      crc = (crc >> 1) ^ (0xEDB88320UL & (0 - (crc & 1)));
+    }
+  }
+  return ~crc;
+}
+
+/* Little endian, whatever the host is */
+void SignalLog::put32(uint8_t* p, uint32_t value) {
+  p[0] = value;
+  p[1] = value >> 8;
+  p[2] = value >> 16;
+  p[3] = value >> 24;
+}
+
+uint32_t SignalLog::get32(const uint8_t* p) {
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+void SignalLog::packSignal(uint8_t* p, const SignalStore::Signal& signal) {
+  put32(p, signal.id);
+  put32(p + 4, signal.code);
+  p[8] = signal.protocol;
+  p[9] = signal.bitLength;
+  p[10] = signal.pulseLength;
+  p[11] = signal.pulseLength >> 8;
+}
+
+void SignalLog::restoreSignal(SignalStore& store, const uint8_t* p) {
+  SignalStore::Signal* pSignal;
+  if (get32(p) == 0) {
+    return;
+  }
+  store.restore(get32(p), get32(p + 4), p[8], p[9], p[10] | (p[11] << 8), pSignal);
+}
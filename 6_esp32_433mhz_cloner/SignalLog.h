@@ -0,0 +1,123 @@
+#ifndef SIGNAL_LOG_H
+#define SIGNAL_LOG_H
+
+#include <stdio.h>
+#include "SignalStore.h"
+
+// Tail size in bytes from which the log is compacted
+#ifndef SIGNAL_LOG_COMPACT_BYTES
+#define SIGNAL_LOG_COMPACT_BYTES 4096
+#endif
+
+/**
+ * Storage of the signal log: one file, which is only appended to, except
+ * that compaction replaces it as a whole.
+ */
+class SignalLogStorage {
+  public:
+    virtual ~SignalLogStorage() {}
+
+    /* Open the log, an empty one if there is none yet */
+    virtual bool open() = 0;
+    virtual void close() = 0;
+    virtual uint32_t size() = 0;
+    virtual bool read(uint32_t offset, void* data, size_t length) = 0;
+    /* Append and make it durable */
+    virtual bool append(const void* data, size_t length) = 0;
+
+    /* Write a new log and replace the current one with it in one step */
+    virtual bool beginRewrite() = 0;
+    virtual bool appendRewrite(const void* data, size_t length) = 0;
+    virtual bool commitRewrite() = 0;
+};
+
+/**
+ * Signal log in a file, through stdio. On the ESP32 the path is one on a
+ * mounted file system, e.g. "/littlefs/signals.log", on Linux the log runs
+ * in tests.
+ *
+ * A rewrite goes to a temporary file, which is then renamed over the log.
+ * If that is interrupted, open() picks the temporary file up.
+ */
+class FileSignalLogStorage : public SignalLogStorage {
+  public:
+    FileSignalLogStorage(const char* path);
+    virtual ~FileSignalLogStorage();
+
+    virtual bool open();
+    virtual void close();
+    virtual uint32_t size();
+    virtual bool read(uint32_t offset, void* data, size_t length);
+    virtual bool append(const void* data, size_t length);
+
+    virtual bool beginRewrite();
+    virtual bool appendRewrite(const void* data, size_t length);
+    virtual bool commitRewrite();
+
+  private:
+    static bool sync(FILE* file);
+
+    char path[64];
+    char rewritePath[68];
+    FILE* file;
+    FILE* rewriteFile;
+};
+
+/**
+ * Persistent copy of a signal store as an append-only log.
+ *
+ * The log starts with a snapshot, a packed array of all signals written by
+ * the last compaction, which is loaded in a few block reads. Signals added or
+ * removed since then follow as records. Snapshot and records are CRC
+ * protected; a record torn by a reset ends the log and is dropped by
+ * compacting right away.
+ *
+ * Compaction writes the content of the store as the new snapshot, oldest
+ * signal first, so eviction picks the same signals after a reset. Using a
+ * signal is not logged, hence the order is that of arrival after a reset.
+ */
+class SignalLog {
+  public:
+    struct Stats {
+      unsigned int loadedSignals;
+      unsigned int loadedRecords;
+      /* Records after a torn or corrupt one */
+      bool droppedTail;
+      unsigned long appendedBytes;
+      unsigned int compactions;
+    };
+
+    SignalLog(SignalLogStorage& storage);
+
+    bool load(SignalStore& store);
+    bool logAdd(const SignalStore::Signal& signal);
+    bool logRemove(uint32_t id);
+    bool compact(SignalStore& store);
+    bool compactIfNeeded(SignalStore& store);
+
+    uint32_t tailBytes() const;
+    const Stats& stats() const;
+
+  private:
+    static const uint32_t MAGIC = 0x314C4753UL; // "SGL1"
+    static const uint8_t RECORD_ADD = 1;
+    static const uint8_t RECORD_REMOVE = 2;
+    static const size_t SIGNAL_BYTES = 12;
+    static const size_t HEADER_BYTES = 12;
+
+    static uint32_t crc32(uint32_t crc, const uint8_t* data, size_t length);
+    static void put32(uint8_t* p, uint32_t value);
+    static uint32_t get32(const uint8_t* p);
+    static void packSignal(uint8_t* p, const SignalStore::Signal& signal);
+    static void restoreSignal(SignalStore& store, const uint8_t* p);
+
+    bool loadSnapshot(SignalStore& store, uint32_t& offset);
+    bool appendRecord(uint8_t type, const uint8_t* payload, uint8_t length);
+
+    SignalLogStorage& storage;
+    uint32_t nSnapshotBytes;
+    uint32_t nTailBytes;
+    Stats logStats;
+};
+
+#endif
@@ -0,0 +1,193 @@
+#include "SignalLog_test.h"
+
+#if ENABLE_SIGNAL_LOG_TEST
+
+#include <assert.h>
+
+/** Call SignalLog_test::theTest.run(path) to execute tests. */
+SignalLog_test SignalLog_test::theTest;
+
+/* The running store and the one loaded after a simulated reset */
+static SignalStore liveStore;
+static SignalStore loadedStore;
+
+/* Same signals with the same IDs and timing, the order is not compared */
+bool SignalLog_test::sameContent(SignalStore& a, SignalStore& b) {
+  if (a.size() != b.size()) {
+    return false;
+  }
+  for (unsigned int i = 0; i < a.capacity(); i++) {
+    const SignalStore::Signal* pSignal = a.at(i);
+    if (pSignal == NULL) {
+      continue;
+    }
+    const SignalStore::Signal* pOther = b.find(pSignal->code, pSignal->protocol, pSignal->bitLength);
+    if (pOther == NULL || pOther->id != pSignal->id || pOther->pulseLength != pSignal->pulseLength) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/* Flip the bits of one byte of the file */
+void SignalLog_test::corrupt(const char* path, long offset) {
+  FILE* file = fopen(path, "r+b");
+  assert(file != NULL);
+  assert(fseek(file, offset, SEEK_SET) == 0);
+  const int value = fgetc(file);
+  assert(value != EOF);
+  assert(fseek(file, offset, SEEK_SET) == 0);
+  fputc(value ^ 0xFF, file);
+  fclose(file);
+}
+
+void SignalLog_test::testRoundTrip(const char* path) const {
+  SignalStore::Signal* pSignal;
+  remove(path);
+  {
+    FileSignalLogStorage storage(path);
+    SignalLog log(storage);
+    assert(log.load(liveStore));
+    assert(liveStore.size() == 0);
+    assert(!log.stats().droppedTail);
+
+    liveStore.add(5393, 1, 24, 350, pSignal);
+    assert(log.logAdd(*pSignal));
+    liveStore.add(5393, 2, 24, 650, pSignal);
+    assert(log.logAdd(*pSignal));
+    liveStore.add(0xA5A5, 11, 12, 333, pSignal);
+    assert(log.logAdd(*pSignal));
+    const uint32_t removedId = liveStore.find(5393, 2, 24)->id;
+    assert(liveStore.remove(removedId));
+    assert(log.logRemove(removedId));
+  }
+
+  FileSignalLogStorage storage(path);
+  SignalLog log(storage);
+  assert(log.load(loadedStore));
+  assert(log.stats().loadedRecords == 4);
+  assert(sameContent(liveStore, loadedStore));
+  // new IDs continue after the loaded ones
+  loadedStore.add(1, 1, 24, 350, pSignal);
+  assert(pSignal->id > loadedStore.find(0xA5A5, 11, 12)->id);
+}
+
+void SignalLog_test::testCompaction(const char* path) const {
+  SignalStore::Signal* pSignal;
+  remove(path);
+  FileSignalLogStorage storage(path);
+  SignalLog log(storage);
+  assert(log.load(liveStore));
+
+  // more signals than the store holds, replaced ones stay in the records
+  const unsigned int nCompactions = log.stats().compactions;
+  for (unsigned long n = 0; n < 3 * liveStore.capacity() || log.stats().compactions == nCompactions; n++) {
+    liveStore.add(0x100000UL + n * 7919UL, 1 + n % 5, 24, 300 + n % 100, pSignal);
+    assert(log.logAdd(*pSignal));
+    assert(log.compactIfNeeded(liveStore));
+    assert(log.tailBytes() < SIGNAL_LOG_COMPACT_BYTES || log.tailBytes() < 12 + 12 * liveStore.size());
+  }
+
+  FileSignalLogStorage reloaded(path);
+  SignalLog reloadedLog(reloaded);
+  assert(reloadedLog.load(loadedStore));
+  assert(sameContent(liveStore, loadedStore));
+
+  // clearing is a compaction of the empty store
+  liveStore.clear();
+  assert(log.compact(liveStore));
+  assert(reloadedLog.load(loadedStore));
+  assert(loadedStore.size() == 0);
+}
+
+void SignalLog_test::testTornTail(const char* path) const {
+  SignalStore::Signal* pSignal;
+  remove(path);
+  FileSignalLogStorage storage(path);
+  SignalLog log(storage);
+  assert(log.load(liveStore));
+  liveStore.add(5393, 1, 24, 350, pSignal);
+  assert(log.logAdd(*pSignal));
+
+  // the reset hit while a record was written
+  static const uint8_t torn[] = { 1, 12, 0x42, 0x42, 0x42 };
+  assert(storage.append(torn, sizeof(torn)));
+  assert(log.load(loadedStore));
+  assert(log.stats().droppedTail);
+  assert(sameContent(liveStore, loadedStore));
+
+  // records appended after the recovery are not hidden
+  liveStore.add(5394, 1, 24, 350, pSignal);
+  assert(log.logAdd(*pSignal));
+  assert(log.load(loadedStore));
+  assert(!log.stats().droppedTail);
+  assert(sameContent(liveStore, loadedStore));
+
+  // a record with a bad CRC ends the log as well
+  const uint32_t nSize = storage.size();
+  liveStore.add(5395, 1, 24, 350, pSignal);
+  assert(log.logAdd(*pSignal));
+  storage.close();
+  corrupt(path, nSize + 4);
+  assert(log.load(loadedStore));
+  assert(log.stats().droppedTail);
+  assert(loadedStore.size() == liveStore.size() - 1);
+}
+
+void SignalLog_test::testCorruptSnapshot(const char* path) const {
+  SignalStore::Signal* pSignal;
+  remove(path);
+  {
+    FileSignalLogStorage storage(path);
+    SignalLog log(storage);
+    assert(log.load(liveStore));
+    liveStore.add(5393, 1, 24, 350, pSignal);
+    liveStore.add(5394, 1, 24, 350, pSignal);
+    assert(log.compact(liveStore));
+  }
+  corrupt(path, 12 + 5);
+
+  FileSignalLogStorage storage(path);
+  SignalLog log(storage);
+  assert(log.load(loadedStore));
+  assert(log.stats().droppedTail);
+  assert(loadedStore.size() == 0);
+  // rewritten as an empty log
+  assert(log.load(loadedStore));
+  assert(!log.stats().droppedTail);
+}
+
+void SignalLog_test::testInterruptedRewrite(const char* path) const {
+  SignalStore::Signal* pSignal;
+  char rewritePath[80];
+  snprintf(rewritePath, sizeof(rewritePath), "%s.tmp", path);
+  remove(path);
+  {
+    FileSignalLogStorage storage(path);
+    SignalLog log(storage);
+    assert(log.load(liveStore));
+    liveStore.add(5393, 1, 24, 350, pSignal);
+    assert(log.compact(liveStore));
+  }
+  // the log was removed, the new one not renamed yet
+  assert(rename(path, rewritePath) == 0);
+
+  FileSignalLogStorage storage(path);
+  SignalLog log(storage);
+  assert(log.load(loadedStore));
+  assert(!log.stats().droppedTail);
+  assert(sameContent(liveStore, loadedStore));
+}
+
+void SignalLog_test::run(const char* path) const {
+  testRoundTrip(path);
+  testCompaction(path);
+  testTornTail(path);
+  testCorruptSnapshot(path);
+  testInterruptedRewrite(path);
+  remove(path);
+  liveStore.clear();
+  loadedStore.clear();
+}
+
+#endif
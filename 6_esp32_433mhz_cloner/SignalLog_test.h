@@ -0,0 +1,36 @@
+#ifndef SIGNAL_LOG_TEST_H
+#define SIGNAL_LOG_TEST_H
+
+#if !defined(ENABLE_SIGNAL_LOG_TEST)
+#define ENABLE_SIGNAL_LOG_TEST true
+#endif
+
+#if ENABLE_SIGNAL_LOG_TEST
+
+#include "SignalLog.h"
+
+/**
+ * Tests of the signal log on a file. They run on a Linux host with a path
+ * in a temporary directory, or on the ESP32 with one on a mounted file
+ * system. The file and its temporary companion are overwritten.
+ */
+class SignalLog_test {
+  public:
+    void run(const char* path) const;
+
+    static SignalLog_test theTest;
+
+  private:
+    static bool sameContent(SignalStore& a, SignalStore& b);
+    static void corrupt(const char* path, long offset);
+
+    void testRoundTrip(const char* path) const;
+    void testCompaction(const char* path) const;
+    void testTornTail(const char* path) const;
+    void testCorruptSnapshot(const char* path) const;
+    void testInterruptedRewrite(const char* path) const;
+};
+
+#endif
+
+#endif
@@ -0,0 +1,285 @@
+#include "SignalStore.h"
+
+SignalStore::SignalStore() {
+  this->nNextId = 1;
+  this->storeStats = Stats();
+  this->clear();
+}
+
+/**
+ * Store a signal, unless one with the same code, protocol and bit length
+ * is stored already. Either way the signal becomes the most recently used
+ * one and 'pSignal' points to it.
+ *
+ * @return SIGNAL_EXISTS for a duplicate, SIGNAL_REPLACED if the least
+ *         recently used signal had to make room
+ */
+SignalStore::AddResult SignalStore::add(unsigned long code, int protocol, int bitLength, int pulseLength, Signal*& pSignal) {
+  return this->insert(this->nNextId, code, protocol, bitLength, pulseLength, pSignal);
+}
+
+/**
+ * Like add(), but with the ID the signal had before, e.g. when it is
+ * loaded from flash. IDs handed out later are above it.
+ */
+SignalStore::AddResult SignalStore::restore(uint32_t id, unsigned long code, int protocol, int bitLength, int pulseLength, Signal*& pSignal) {
+  return this->insert(id, code, protocol, bitLength, pulseLength, pSignal);
+}
+
+SignalStore::AddResult SignalStore::insert(uint32_t id, unsigned long code, int protocol, int bitLength, int pulseLength, Signal*& pSignal) {
+  const int nSlot = this->findSlot(code, protocol, bitLength);
+  if (nSlot >= 0) {
+    pSignal = &this->entries[this->slots[nSlot] - 1];
+    this->touch(pSignal);
+    this->storeStats.duplicates++;
+    return SIGNAL_EXISTS;
+  }
+
+  AddResult result = SIGNAL_ADDED;
+  if (this->nFreeCount == 0) {
+    this->removeEntry(this->nLast);
+    this->storeStats.replaced++;
+    result = SIGNAL_REPLACED;
+  }
+
+  const uint16_t nEntry = this->freeEntries[--this->nFreeCount];
+  Signal& signal = this->entries[nEntry];
+  signal.id = id;
+  if (id >= this->nNextId) {
+    this->nNextId = id + 1;
+  }
+  signal.code = code;
+  signal.protocol = protocol;
+  signal.bitLength = bitLength;
+  signal.pulseLength = pulseLength;
+  signal.waveform.count = 0;
+  signal.waveform.firstLevel = HIGH;
+  this->insertSlot(nEntry);
+  this->linkFirst(nEntry);
+  this->storeStats.added++;
+
+  pSignal = &signal;
+  return result;
+}
+
+/**
+ * @param bitLength 0 matches any bit length, the most recently added
+ *        signal is preferred then
+ * @return NULL, if no such signal is stored
+ */
+SignalStore::Signal* SignalStore::find(unsigned long code, int protocol, int bitLength) {
+  const int nSlot = this->findSlot(code, protocol, bitLength);
+  return nSlot < 0 ? NULL : &this->entries[this->slots[nSlot] - 1];
+}
+
+/**
+ * Linear in the number of stored signals, the hash index is keyed on the
+ * signal, not on its ID.
+ */
+SignalStore::Signal* SignalStore::findById(uint32_t id) {
+  if (id == 0) {
+    return NULL;
+  }
+  for (unsigned int i = 0; i < SIGNAL_STORE_CAPACITY; i++) {
+    if (this->entries[i].id == id) {
+      return &this->entries[i];
+    }
+  }
+  return NULL;
+}
+
+/**
+ * Walk the store in the order of the IDs, e.g. to list the signals added
+ * since the last listing. Signals added during the walk are included.
+ * Linear in the number of stored signals.
+ *
+ * @return the signal with the lowest ID above 'afterId', NULL if none
+ */
+SignalStore::Signal* SignalStore::nextById(uint32_t afterId) {
+  Signal* pNext = NULL;
+  for (unsigned int i = 0; i < SIGNAL_STORE_CAPACITY; i++) {
+    Signal& signal = this->entries[i];
+    if (signal.id > afterId && (pNext == NULL || signal.id < pNext->id)) {
+      pNext = &signal;
+    }
+  }
+  return pNext;
+}
+
+/** Mark a stored signal as used, e.g. when it is sent. */
+void SignalStore::touch(Signal* pSignal) {
+  const uint16_t nEntry = pSignal - this->entries;
+  if (this->nFirst != nEntry) {
+    this->unlink(nEntry);
+    this->linkFirst(nEntry);
+  }
+}
+
+bool SignalStore::remove(uint32_t id) {
+  Signal* pSignal = this->findById(id);
+  if (pSignal == NULL) {
+    return false;
+  }
+  this->removeEntry(pSignal - this->entries);
+  return true;
+}
+
+/** Remove all signals. IDs are not reused. */
+void SignalStore::clear() {
+  for (unsigned int i = 0; i < SIGNAL_STORE_BUCKETS; i++) {
+    this->slots[i] = 0;
+  }
+  this->nFreeCount = 0;
+  for (unsigned int i = SIGNAL_STORE_CAPACITY; i > 0; i--) {
+    this->release(i - 1);
+  }
+  this->nFirst = NO_ENTRY;
+  this->nLast = NO_ENTRY;
+}
+
+/**
+ * Iterate over the store: a signal does not move, but the order of the
+ * slots is neither the order of arrival nor the order of use.
+ *
+ * @param nIndex below capacity()
+ * @return NULL for a free slot
+ */
+SignalStore::Signal* SignalStore::at(unsigned int nIndex) {
+  return this->entries[nIndex].id == 0 ? NULL : &this->entries[nIndex];
+}
+
+/* @return NULL, if the store is empty */
+SignalStore::Signal* SignalStore::leastRecentlyUsed() {
+  return this->nLast == NO_ENTRY ? NULL : &this->entries[this->nLast];
+}
+
+/* @return NULL after the most recently used signal */
+SignalStore::Signal* SignalStore::moreRecentlyUsed(const Signal* pSignal) {
+  const uint16_t nPrev = this->prev[pSignal - this->entries];
+  return nPrev == NO_ENTRY ? NULL : &this->entries[nPrev];
+}
+
+unsigned int SignalStore::size() const {
+  return SIGNAL_STORE_CAPACITY - this->nFreeCount;
+}
+
+unsigned int SignalStore::capacity() const {
+  return SIGNAL_STORE_CAPACITY;
+}
+
+const SignalStore::Stats& SignalStore::stats() const {
+  return this->storeStats;
+}
+
+/*
+ * Only code and protocol are hashed, signals that differ in the bit length
+ * only end up in the same probe sequence. This lets find() match any bit
+ * length.
+ */
+unsigned int SignalStore::hash(unsigned long code, int protocol) {
+  uint32_t h = (uint32_t)code * 0x9E3779B1UL;
+  h ^= (uint32_t)protocol * 0x85EBCA77UL;
+  h ^= h >> 15;
+  h *= 0x2C1B3C6DUL;
+  h ^= h >> 13;
+  return h & (SIGNAL_STORE_BUCKETS - 1);
+}
+
+/* @return the slot of the signal, -1 if it isn't stored */
+int SignalStore::findSlot(unsigned long code, int protocol, int bitLength) {
+  this->storeStats.lookups++;
+  int nFound = -1;
+  for (unsigned int nSlot = hash(code, protocol); this->slots[nSlot] != 0; nSlot = (nSlot + 1) & (SIGNAL_STORE_BUCKETS - 1)) {
+    this->storeStats.probes++;
+    const Signal& signal = this->entries[this->slots[nSlot] - 1];
+    if (signal.code != code || signal.protocol != protocol) {
+      continue;
+    }
+    if (signal.bitLength == bitLength) {
+      return nSlot;
+    }
+    if (bitLength == 0 && (nFound < 0 || signal.id > this->entries[this->slots[nFound] - 1].id)) {
+      nFound = nSlot;
+    }
+  }
+  return nFound;
+}
+
+void SignalStore::removeEntry(uint16_t nEntry) {
+  const Signal& signal = this->entries[nEntry];
+  // the signal is in the index, the lookup can't fail
+  for (unsigned int nSlot = hash(signal.code, signal.protocol); ; nSlot = (nSlot + 1) & (SIGNAL_STORE_BUCKETS - 1)) {
+    if (this->slots[nSlot] == nEntry + 1) {
+      this->removeSlot(nSlot);
+      break;
+    }
+  }
+  this->unlink(nEntry);
+  this->release(nEntry);
+}
+
+void SignalStore::insertSlot(uint16_t nEntry) {
+  const Signal& signal = this->entries[nEntry];
+  unsigned int nSlot = hash(signal.code, signal.protocol);
+  while (this->slots[nSlot] != 0) {
+    nSlot = (nSlot + 1) & (SIGNAL_STORE_BUCKETS - 1);
+  }
+  this->slots[nSlot] = nEntry + 1;
+}
+
+/*
+ * Backward shift deletion: the following slots of the cluster are moved
+ * up where their probe sequence allows it, hence no tombstones pile up
+ * while the store keeps replacing signals.
+ */
+void SignalStore::removeSlot(unsigned int nSlot) {
+  unsigned int nHole = nSlot;
+  unsigned int nNext = nSlot;
+  for (;;) {
+    nNext = (nNext + 1) & (SIGNAL_STORE_BUCKETS - 1);
+    if (this->slots[nNext] == 0) {
+      break;
+    }
+    const Signal& signal = this->entries[this->slots[nNext] - 1];
+    const unsigned int nHome = hash(signal.code, signal.protocol);
+    // distance of the hole and of the slot from the home slot
+    const unsigned int nHoleDistance = (nHole - nHome) & (SIGNAL_STORE_BUCKETS - 1);
+    const unsigned int nNextDistance = (nNext - nHome) & (SIGNAL_STORE_BUCKETS - 1);
+    if (nHoleDistance < nNextDistance) {
+      this->slots[nHole] = this->slots[nNext];
+      nHole = nNext;
+    }
+  }
+  this->slots[nHole] = 0;
+}
+
+void SignalStore::unlink(uint16_t nEntry) {
+  const uint16_t nPrev = this->prev[nEntry];
+  const uint16_t nNext = this->next[nEntry];
+  if (nPrev == NO_ENTRY) {
+    this->nFirst = nNext;
+  } else {
+    this->next[nPrev] = nNext;
+  }
+  if (nNext == NO_ENTRY) {
+    this->nLast = nPrev;
+  } else {
+    this->prev[nNext] = nPrev;
+  }
+}
+
+void SignalStore::linkFirst(uint16_t nEntry) {
+  this->prev[nEntry] = NO_ENTRY;
+  this->next[nEntry] = this->nFirst;
+  if (this->nFirst == NO_ENTRY) {
+    this->nLast = nEntry;
+  } else {
+    this->prev[this->nFirst] = nEntry;
+  }
+  this->nFirst = nEntry;
+}
+
+void SignalStore::release(uint16_t nEntry) {
+  this->entries[nEntry].id = 0;
+  this->freeEntries[this->nFreeCount++] = nEntry;
+}
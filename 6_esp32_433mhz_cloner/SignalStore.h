@@ -0,0 +1,117 @@
+#ifndef SIGNAL_STORE_H
+#define SIGNAL_STORE_H
+
+#include <RCSwitch.h>
+
+#ifndef SIGNAL_STORE_CAPACITY
+#define SIGNAL_STORE_CAPACITY 100
+#endif
+
+// Size of the hash index, a power of two of at least twice the capacity
+#if SIGNAL_STORE_CAPACITY <= 64
+#define SIGNAL_STORE_BUCKETS 128
+#elif SIGNAL_STORE_CAPACITY <= 128
+#define SIGNAL_STORE_BUCKETS 256
+#elif SIGNAL_STORE_CAPACITY <= 512
+#define SIGNAL_STORE_BUCKETS 1024
+#elif SIGNAL_STORE_CAPACITY <= 4096
+#define SIGNAL_STORE_BUCKETS 8192
+#else
+#define SIGNAL_STORE_BUCKETS 32768
+#endif
+
+/**
+ * Fixed capacity store of the received signals.
+ *
+ * Signals are keyed on (code, protocol, bit length) and found through an
+ * open addressing hash index with linear probing, so duplicates are
+ * detected in constant time. When the store is full, adding a signal
+ * replaces the least recently used one, i.e. the one that has been
+ * neither received nor sent for the longest time.
+ *
+ * Every signal gets an ID that stays the same for its lifetime. A signal
+ * doesn't move within the store either, hence pointers to it, e.g. to its
+ * waveform, stay valid until it is removed or replaced.
+ */
+class SignalStore {
+  public:
+    struct Signal {
+      /* 0 for a free slot */
+      uint32_t id;
+      unsigned long code;
+      uint8_t protocol;
+      uint8_t bitLength;
+      /* Measured pulse length in microseconds */
+      uint16_t pulseLength;
+      /* Compiled for replay by the owner of the store */
+      RCSwitch::Waveform waveform;
+    };
+
+    enum AddResult {
+      SIGNAL_ADDED,
+      SIGNAL_EXISTS,
+      /* Added in place of the least recently used signal */
+      SIGNAL_REPLACED,
+      /* Not offered to the store, e.g. a marginal capture. add() never returns it. */
+      SIGNAL_NOT_STORED
+    };
+
+    struct Stats {
+      unsigned long added;
+      unsigned long duplicates;
+      unsigned long replaced;
+      /* Hash index slots looked at by all lookups */
+      unsigned long probes;
+      unsigned long lookups;
+    };
+
+    SignalStore();
+
+    AddResult add(unsigned long code, int protocol, int bitLength, int pulseLength, Signal*& pSignal);
+    AddResult restore(uint32_t id, unsigned long code, int protocol, int bitLength, int pulseLength, Signal*& pSignal);
+    Signal* find(unsigned long code, int protocol, int bitLength = 0);
+    Signal* findById(uint32_t id);
+    Signal* nextById(uint32_t afterId);
+    void touch(Signal* pSignal);
+    bool remove(uint32_t id);
+    void clear();
+
+    Signal* at(unsigned int nIndex);
+    Signal* leastRecentlyUsed();
+    Signal* moreRecentlyUsed(const Signal* pSignal);
+    unsigned int size() const;
+    unsigned int capacity() const;
+    const Stats& stats() const;
+
+  private:
+    static const uint16_t NO_ENTRY = 0xFFFF;
+
+    static unsigned int hash(unsigned long code, int protocol);
+    int findSlot(unsigned long code, int protocol, int bitLength);
+    AddResult insert(uint32_t id, unsigned long code, int protocol, int bitLength, int pulseLength, Signal*& pSignal);
+    void removeEntry(uint16_t nEntry);
+    void insertSlot(uint16_t nEntry);
+    void removeSlot(unsigned int nSlot);
+    void unlink(uint16_t nEntry);
+    void linkFirst(uint16_t nEntry);
+    void release(uint16_t nEntry);
+
+    Signal entries[SIGNAL_STORE_CAPACITY];
+    /* Index of the entry + 1, 0 marks an empty slot */
+    uint16_t slots[SIGNAL_STORE_BUCKETS];
+
+    /* Recency list, most recently used first */
+    uint16_t prev[SIGNAL_STORE_CAPACITY];
+    uint16_t next[SIGNAL_STORE_CAPACITY];
+    uint16_t nFirst;
+    uint16_t nLast;
+
+    /* Stack of the free entries */
+    uint16_t freeEntries[SIGNAL_STORE_CAPACITY];
+    unsigned int nFreeCount;
+
+    uint32_t nNextId;
+    Stats storeStats;
+};
+
+#endif
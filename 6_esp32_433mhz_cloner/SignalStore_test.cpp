@@ -0,0 +1,238 @@
+#include "SignalStore_test.h"
+
+#if ENABLE_SIGNAL_STORE_TEST
+
+#include <assert.h>
+
+/** Call SignalStore_test::theTest.run() to execute tests. */
+SignalStore_test SignalStore_test::theTest;
+
+/* Codes spread like those of real remotes: a fixed address, varying keys */
+static unsigned long testCode(unsigned long n) {
+  return 0x500000UL | ((n * 2654435761UL) & 0xFFFFFUL);
+}
+
+/* Every stored signal must be found through the index */
+void SignalStore_test::checkIndex(SignalStore& store) {
+  unsigned int nCount = 0;
+  for (unsigned int i = 0; i < store.capacity(); i++) {
+    SignalStore::Signal* pSignal = store.at(i);
+    if (pSignal != NULL) {
+      assert(store.find(pSignal->code, pSignal->protocol, pSignal->bitLength) == pSignal);
+      nCount++;
+    }
+  }
+  assert(nCount == store.size());
+}
+
+void SignalStore_test::testDedupe(SignalStore& store) const {
+  SignalStore::Signal* pFirst;
+  SignalStore::Signal* pSignal;
+
+  store.clear();
+  assert(store.add(5393, 1, 24, 350, pFirst) == SignalStore::SIGNAL_ADDED);
+  assert(store.add(5393, 1, 24, 352, pSignal) == SignalStore::SIGNAL_EXISTS);
+  assert(pSignal == pFirst);
+  // the first measurement is kept
+  assert(pSignal->pulseLength == 350);
+
+  // the same code on another protocol or with another length is another signal
+  assert(store.add(5393, 2, 24, 650, pSignal) == SignalStore::SIGNAL_ADDED);
+  assert(pSignal != pFirst);
+  assert(store.add(5393, 1, 12, 350, pSignal) == SignalStore::SIGNAL_ADDED);
+  assert(store.size() == 3);
+
+  assert(store.find(5393, 1, 24) == pFirst);
+  assert(store.find(5393, 1, 12) == pSignal);
+  assert(store.find(5393, 1, 20) == NULL);
+  assert(store.find(5394, 1, 24) == NULL);
+  // any length, the most recently added
+  assert(store.find(5393, 1) == pSignal);
+  checkIndex(store);
+}
+
+void SignalStore_test::testEviction(SignalStore& store) const {
+  SignalStore::Signal* pSignal;
+
+  store.clear();
+  const uint32_t firstId = store.stats().added + 1;
+  for (unsigned long n = 0; n < store.capacity(); n++) {
+    assert(store.add(testCode(n), 1, 24, 350, pSignal) == SignalStore::SIGNAL_ADDED);
+    assert(pSignal->id == firstId + n);
+  }
+  assert(store.size() == store.capacity());
+
+  // receiving or sending a signal keeps it
+  store.add(testCode(0), 1, 24, 350, pSignal);
+  store.touch(store.find(testCode(1), 1, 24));
+
+  assert(store.add(testCode(store.capacity()), 1, 24, 350, pSignal) == SignalStore::SIGNAL_REPLACED);
+  assert(pSignal->id == firstId + store.capacity());
+  assert(store.size() == store.capacity());
+  assert(store.find(testCode(2), 1, 24) == NULL);
+  assert(store.findById(firstId + 2) == NULL);
+  assert(store.find(testCode(0), 1, 24) != NULL);
+  assert(store.find(testCode(1), 1, 24) != NULL);
+
+  // IDs of the others are stable
+  for (unsigned long n = 3; n < store.capacity(); n++) {
+    SignalStore::Signal* pOther = store.findById(firstId + n);
+    assert(pOther != NULL && pOther->code == testCode(n));
+  }
+  checkIndex(store);
+}
+
+void SignalStore_test::testRemove(SignalStore& store) const {
+  SignalStore::Signal* pSignal;
+
+  // the same code on all protocols makes one long probe sequence
+  store.clear();
+  const uint32_t firstId = store.stats().added + 1;
+  const unsigned int nCount = store.capacity() < 24 ? store.capacity() : 24;
+  for (unsigned int n = 0; n < nCount; n++) {
+    store.add(0x123456, 1 + n / 2, n % 2 == 0 ? 24 : 32, 350, pSignal);
+  }
+  unsigned int nRemoved = 0;
+  for (uint32_t id = firstId; id < firstId + nCount; id += 3) {
+    assert(store.remove(id));
+    assert(!store.remove(id));
+    nRemoved++;
+    checkIndex(store);
+  }
+  assert(store.size() == nCount - nRemoved);
+
+  store.clear();
+  assert(store.size() == 0);
+  assert(store.find(0x123456, 1) == NULL);
+  // IDs are not reused
+  store.add(0x123456, 1, 24, 350, pSignal);
+  assert(pSignal->id == firstId + nCount);
+}
+
+void SignalStore_test::testIdOrder(SignalStore& store) const {
+  SignalStore::Signal* pSignal;
+
+  store.clear();
+  const uint32_t firstId = store.stats().added + 1;
+  for (unsigned long n = 0; n < store.capacity(); n++) {
+    store.add(testCode(n), 1, 24, 350, pSignal);
+  }
+  // free slots in between, reused by later signals
+  store.remove(firstId + 1);
+  store.remove(firstId + 2);
+  store.add(testCode(store.capacity()), 1, 24, 350, pSignal);
+
+  unsigned int nCount = 0;
+  uint32_t lastId = 0;
+  for (pSignal = store.nextById(0); pSignal != NULL; pSignal = store.nextById(pSignal->id)) {
+    assert(pSignal->id > lastId);
+    lastId = pSignal->id;
+    nCount++;
+  }
+  assert(nCount == store.size());
+  assert(lastId == firstId + store.capacity());
+  assert(store.nextById(firstId)->id == firstId + 3);
+  assert(store.nextById(lastId) == NULL);
+}
+
+/* Random adds, finds and removes against the expected content */
+void SignalStore_test::testChurn(SignalStore& store) const {
+  SignalStore::Signal* pSignal;
+  uint32_t nRandom = 1;
+
+  store.clear();
+  for (unsigned int n = 0; n < 20000; n++) {
+    nRandom = nRandom * 1103515245UL + 12345UL;
+    const unsigned long code = testCode((nRandom >> 8) % (2 * store.capacity()));
+    const int protocol = 1 + (nRandom >> 4) % 3;
+    switch ((nRandom >> 28) % 4) {
+      case 0:
+        pSignal = store.find(code, protocol, 24);
+        if (pSignal != NULL) {
+          assert(store.remove(pSignal->id));
+          assert(store.find(code, protocol, 24) == NULL);
+        }
+        break;
+      default: {
+        const bool bStored = store.find(code, protocol, 24) != NULL;
+        const SignalStore::AddResult result = store.add(code, protocol, 24, 350, pSignal);
+        assert(bStored == (result == SignalStore::SIGNAL_EXISTS));
+        assert(pSignal->code == code && pSignal->protocol == protocol);
+        break;
+      }
+    }
+    assert(store.size() <= store.capacity());
+    if (n % 1000 == 0) {
+      checkIndex(store);
+    }
+  }
+  checkIndex(store);
+}
+
+/*
+ * The store is too large for the stack of the loop task and is only
+ * needed while the tests run, hence it is allocated on the heap.
+ */
+void SignalStore_test::run() const {
+  SignalStore* pStore = new SignalStore();
+  testDedupe(*pStore);
+  testEviction(*pStore);
+  testRemove(*pStore);
+  testIdOrder(*pStore);
+  testChurn(*pStore);
+  delete pStore;
+}
+
+/**
+ * Add nSignals different signals, replacing all but the last capacity()
+ * ones, then look each of them up: the last ones are found, the others
+ * are not. The lookups are repeated with a linear scan of the store, like
+ * the one the store replaced.
+ */
+SignalStore_test::BenchmarkResult SignalStore_test::benchmark(unsigned long nSignals) const {
+  BenchmarkResult result;
+  SignalStore::Signal* pSignal;
+  result.signals = nSignals;
+
+  SignalStore* pStore = new SignalStore();
+  SignalStore& testStore = *pStore;
+  unsigned long nStartMicros = micros();
+  for (unsigned long n = 0; n < nSignals; n++) {
+    testStore.add(testCode(n), 1 + n % 12, 24, 350, pSignal);
+  }
+  result.addMicros = (float)(micros() - nStartMicros) / nSignals;
+
+  const unsigned long nProbes = testStore.stats().probes;
+  const unsigned long nLookups = testStore.stats().lookups;
+  unsigned long nFound = 0;
+  nStartMicros = micros();
+  for (unsigned long n = 0; n < nSignals; n++) {
+    if (testStore.find(testCode(n), 1 + n % 12, 24) != NULL) {
+      nFound++;
+    }
+  }
+  result.findMicros = (float)(micros() - nStartMicros) / nSignals;
+  result.probesPerLookup = (float)(testStore.stats().probes - nProbes) / (testStore.stats().lookups - nLookups);
+  assert(nFound == (nSignals < testStore.capacity() ? nSignals : testStore.capacity()));
+
+  unsigned long nLinearFound = 0;
+  nStartMicros = micros();
+  for (unsigned long n = 0; n < nSignals; n++) {
+    const unsigned long code = testCode(n);
+    const int protocol = 1 + n % 12;
+    for (unsigned int i = 0; i < testStore.capacity(); i++) {
+      const SignalStore::Signal* pStored = testStore.at(i);
+      if (pStored != NULL && pStored->code == code && pStored->protocol == protocol && pStored->bitLength == 24) {
+        nLinearFound++;
+        break;
+      }
+    }
+  }
+  result.linearFindMicros = (float)(micros() - nStartMicros) / nSignals;
+  assert(nLinearFound == nFound);
+
+  delete pStore;
+  return result;
+}
+
+#endif
@@ -0,0 +1,46 @@
+#ifndef SIGNAL_STORE_TEST_H
+#define SIGNAL_STORE_TEST_H
+
+#if !defined(ENABLE_SIGNAL_STORE_TEST)
+#define ENABLE_SIGNAL_STORE_TEST true
+#endif
+
+#if ENABLE_SIGNAL_STORE_TEST
+
+#include "SignalStore.h"
+
+/**
+ * Tests and benchmark of the signal store. They only use the store and
+ * micros(), hence they run on a host as well. The store they use is
+ * allocated for the duration of run() and benchmark().
+ */
+class SignalStore_test {
+  public:
+    struct BenchmarkResult {
+      unsigned long signals;
+      /* Average microseconds per operation */
+      float addMicros;
+      float findMicros;
+      float linearFindMicros;
+      /* Average hash index slots looked at per lookup */
+      float probesPerLookup;
+    };
+
+    void run() const;
+    BenchmarkResult benchmark(unsigned long nSignals = 10000) const;
+
+    static SignalStore_test theTest;
+
+  private:
+    static void checkIndex(SignalStore& store);
+
+    void testDedupe(SignalStore& store) const;
+    void testEviction(SignalStore& store) const;
+    void testRemove(SignalStore& store) const;
+    void testIdOrder(SignalStore& store) const;
+    void testChurn(SignalStore& store) const;
+};
+
+#endif
+
+#endif
@@ -0,0 +1,116 @@
+#include "TaskScheduler.h"
+
+TaskScheduler::TaskScheduler(Clock millisClock, Clock microsClock) {
+  this->millisClock = millisClock;
+  this->microsClock = microsClock;
+  this->nTaskCount = 0;
+}
+
+/**
+ * Add a task, due at once and then every 'intervalMillis', 0 for every
+ * run(). Tasks run in the order they were added.
+ *
+ * @return the task number, -1 if the scheduler is full
+ */
+int TaskScheduler::add(const char* name, TaskFunction function, unsigned long intervalMillis) {
+  if (this->nTaskCount >= TASK_SCHEDULER_CAPACITY) {
+    return -1;
+  }
+  Task& task = this->tasks[this->nTaskCount];
+  task.name = name;
+  task.function = function;
+  task.intervalMillis = intervalMillis;
+  task.dueMillis = this->millisClock();
+  task.enabled = true;
+  task.runs = 0;
+  task.totalMicros = 0;
+  task.maxMicros = 0;
+  return this->nTaskCount++;
+}
+
+/* The new interval counts from the last run */
+void TaskScheduler::setInterval(int nTask, unsigned long intervalMillis) {
+  Task& task = this->tasks[nTask];
+  task.dueMillis += intervalMillis - task.intervalMillis;
+  task.intervalMillis = intervalMillis;
+}
+
+/* An enabled task is due at once */
+void TaskScheduler::enable(int nTask, bool bEnabled) {
+  Task& task = this->tasks[nTask];
+  if (bEnabled && !task.enabled) {
+    task.dueMillis = this->millisClock();
+  }
+  task.enabled = bEnabled;
+}
+
+/* Run a task on the next run(), whether its interval passed or not */
+void TaskScheduler::trigger(int nTask) {
+  this->tasks[nTask].dueMillis = this->millisClock();
+}
+
+/* One pass over the tasks, call from loop() */
+void TaskScheduler::run() {
+  for (unsigned int i = 0; i < this->nTaskCount; i++) {
+    Task& task = this->tasks[i];
+    const uint32_t nNowMillis = this->millisClock();
+    // signed difference, millis() wraps after 49 days
+    if (!task.enabled || (int32_t)(nNowMillis - task.dueMillis) < 0) {
+      continue;
+    }
+    task.dueMillis += task.intervalMillis;
+    if ((int32_t)(nNowMillis - task.dueMillis) >= 0) {
+      task.dueMillis = nNowMillis + task.intervalMillis;
+    }
+
+    const unsigned long nStartMicros = this->microsClock();
+    task.function();
+    const unsigned long nMicros = this->microsClock() - nStartMicros;
+    task.runs++;
+    task.totalMicros += nMicros;
+    if (nMicros > task.maxMicros) {
+      task.maxMicros = nMicros;
+    }
+  }
+}
+
+/**
+ * Time loop() may sleep before a task with an interval is due. Tasks that
+ * run on every pass are left out, the caller knows whether they have work.
+ *
+ * @return milliseconds, 0 if a task is due, at most 'nMaxMillis'
+ */
+unsigned long TaskScheduler::millisUntilDue(unsigned long nMaxMillis) const {
+  const uint32_t nNowMillis = this->millisClock();
+  unsigned long nMillis = nMaxMillis;
+  for (unsigned int i = 0; i < this->nTaskCount; i++) {
+    const Task& task = this->tasks[i];
+    if (!task.enabled || task.intervalMillis == 0) {
+      continue;
+    }
+    const int32_t nLeft = task.dueMillis - nNowMillis;
+    if (nLeft <= 0) {
+      return 0;
+    }
+    if ((unsigned long)nLeft < nMillis) {
+      nMillis = nLeft;
+    }
+  }
+  return nMillis;
+}
+
+unsigned int TaskScheduler::size() const {
+  return this->nTaskCount;
+}
+
+const TaskScheduler::Task& TaskScheduler::task(int nTask) const {
+  return this->tasks[nTask];
+}
+
+void TaskScheduler::resetStats() {
+  for (unsigned int i = 0; i < this->nTaskCount; i++) {
+    this->tasks[i].runs = 0;
+    this->tasks[i].totalMicros = 0;
+    this->tasks[i].maxMicros = 0;
+  }
+}
@@ -0,0 +1,60 @@
+#ifndef TASK_SCHEDULER_H
+#define TASK_SCHEDULER_H
+
+#include <Arduino.h>
+
+#define TASK_SCHEDULER_CAPACITY 8
+
+/**
+ * Cooperative scheduler for the tasks of loop().
+ *
+ * Each task is a function that does a bounded amount of work and
+ * returns, it never waits. run() calls every task that is due once: tasks
+ * with interval 0 on every pass, the others when their interval in
+ * milliseconds (ticks) has passed. A task that falls behind runs once
+ * and is then due a full interval later, it does not catch up in a burst.
+ *
+ * The run time of each task is measured, see Task::maxMicros, to find
+ * the task that delays the others.
+ *
+ * Both clocks are injected, e.g. a fake clock to test on a host.
+ */
+class TaskScheduler {
+  public:
+    typedef void (*TaskFunction)();
+    typedef unsigned long (*Clock)();
+
+    struct Task {
+      const char* name;
+      TaskFunction function;
+      unsigned long intervalMillis;
+      /* 32 bits like millis() on the ESP32, for the same wrap on a host */
+      uint32_t dueMillis;
+      bool enabled;
+      unsigned long runs;
+      unsigned long totalMicros;
+      unsigned long maxMicros;
+    };
+
+    TaskScheduler(Clock millisClock = millis, Clock microsClock = micros);
+
+    int add(const char* name, TaskFunction function, unsigned long intervalMillis = 0);
+    void setInterval(int nTask, unsigned long intervalMillis);
+    void enable(int nTask, bool bEnabled);
+    void trigger(int nTask);
+
+    void run();
+    unsigned long millisUntilDue(unsigned long nMaxMillis) const;
+
+    unsigned int size() const;
+    const Task& task(int nTask) const;
+    void resetStats();
+
+  private:
+    Clock millisClock;
+    Clock microsClock;
+    Task tasks[TASK_SCHEDULER_CAPACITY];
+    unsigned int nTaskCount;
+};
+
+#endif
@@ -0,0 +1,204 @@
+#include "TaskScheduler_test.h"
+
+#if ENABLE_TASK_SCHEDULER_TEST
+
+#include <assert.h>
+
+/** Call TaskScheduler_test::theTest.run() to execute tests. */
+TaskScheduler_test TaskScheduler_test::theTest;
+
+static unsigned long nFakeMicros = 0;
+static unsigned long nFakeMillisOffset = 0;
+static unsigned long nFastRuns = 0;
+static unsigned long nSlowRuns = 0;
+
+unsigned long TaskScheduler_test::fakeMillis() {
+  return (uint32_t)(nFakeMillisOffset + nFakeMicros / 1000);
+}
+
+unsigned long TaskScheduler_test::fakeMicros() {
+  return nFakeMicros;
+}
+
+void TaskScheduler_test::setClock(unsigned long nMillisOffset) {
+  nFakeMicros = 0;
+  nFakeMillisOffset = nMillisOffset;
+  nFastRuns = 0;
+  nSlowRuns = 0;
+}
+
+void TaskScheduler_test::fastTask() {
+  nFastRuns++;
+  nFakeMicros += 10;
+}
+
+/* Runs 3 ms, like a blocking transmit or a long listing */
+void TaskScheduler_test::slowTask() {
+  nSlowRuns++;
+  nFakeMicros += 3000;
+}
+
+void TaskScheduler_test::testIntervals() const {
+  setClock(0);
+  TaskScheduler scheduler(fakeMillis, fakeMicros);
+  const int nEveryPass = scheduler.add("every pass", fastTask);
+  const int nEvery100 = scheduler.add("every 100 ms", slowTask, 100);
+  assert(nEveryPass == 0 && nEvery100 == 1);
+  assert(scheduler.size() == 2);
+
+  // due at once, then after 100 ms
+  scheduler.run();
+  assert(nFastRuns == 1 && nSlowRuns == 1);
+  for (int i = 0; i < 20; i++) {
+    nFakeMicros += 1000;
+    scheduler.run();
+  }
+  assert(nFastRuns == 21);
+  assert(nSlowRuns == 1);
+  nFakeMicros = 100000;
+  scheduler.run();
+  assert(nSlowRuns == 2);
+  scheduler.run();
+  assert(nSlowRuns == 2);
+  assert(nFastRuns == 23);
+
+  // the phase is kept, run 150 ms late
+  nFakeMicros = 150000;
+  scheduler.run();
+  assert(nSlowRuns == 2);
+  nFakeMicros = 199000;
+  scheduler.run();
+  assert(nSlowRuns == 2);
+  nFakeMicros = 200000;
+  scheduler.run();
+  assert(nSlowRuns == 3);
+
+  // trigger runs a task early, the interval counts from there
+  scheduler.trigger(nEvery100);
+  scheduler.run();
+  assert(nSlowRuns == 4);
+  scheduler.run();
+  assert(nSlowRuns == 4);
+
+  scheduler.setInterval(nEvery100, 10);
+  nFakeMicros += 10000;
+  scheduler.run();
+  assert(nSlowRuns == 5);
+  assert(scheduler.task(nEvery100).runs == 5);
+  assert(scheduler.task(nEveryPass).runs == nFastRuns);
+}
+
+/* A task far behind runs once, not once per missed interval */
+void TaskScheduler_test::testFallingBehind() const {
+  setClock(0);
+  TaskScheduler scheduler(fakeMillis, fakeMicros);
+  const int nTask = scheduler.add("heartbeat", fastTask, 100);
+  scheduler.run();
+  assert(nFastRuns == 1);
+  nFakeMicros = 1000000;
+  scheduler.run();
+  scheduler.run();
+  assert(nFastRuns == 2);
+  nFakeMicros = 1099000;
+  scheduler.run();
+  assert(nFastRuns == 2);
+  nFakeMicros = 1100000;
+  scheduler.run();
+  assert(nFastRuns == 3);
+  assert(scheduler.task(nTask).dueMillis == 1200);
+}
+
+void TaskScheduler_test::testEnable() const {
+  setClock(0);
+  TaskScheduler scheduler(fakeMillis, fakeMicros);
+  const int nTask = scheduler.add("led", fastTask, 100);
+  scheduler.enable(nTask, false);
+  for (int i = 0; i < 5; i++) {
+    nFakeMicros += 100000;
+    scheduler.run();
+  }
+  assert(nFastRuns == 0);
+  scheduler.enable(nTask, true);
+  scheduler.run();
+  assert(nFastRuns == 1);
+
+  // the capacity is a hard limit
+  for (int i = 1; i < TASK_SCHEDULER_CAPACITY; i++) {
+    assert(scheduler.add("filler", fastTask) == i);
+  }
+  assert(scheduler.add("one too many", fastTask) == -1);
+  assert(scheduler.size() == TASK_SCHEDULER_CAPACITY);
+}
+
+void TaskScheduler_test::testRunTime() const {
+  setClock(0);
+  TaskScheduler scheduler(fakeMillis, fakeMicros);
+  const int nFast = scheduler.add("fast", fastTask);
+  const int nSlow = scheduler.add("slow", slowTask);
+  for (int i = 0; i < 10; i++) {
+    scheduler.run();
+  }
+  assert(scheduler.task(nFast).runs == 10);
+  assert(scheduler.task(nFast).maxMicros == 10);
+  assert(scheduler.task(nFast).totalMicros == 100);
+  assert(scheduler.task(nSlow).maxMicros == 3000);
+  assert(scheduler.task(nSlow).totalMicros == 30000);
+
+  scheduler.resetStats();
+  assert(scheduler.task(nSlow).runs == 0);
+  assert(scheduler.task(nSlow).maxMicros == 0);
+}
+
+/* millis() wraps after 49 days */
+void TaskScheduler_test::testWrapAround() const {
+  setClock(0xFFFFFFFFUL - 1999);
+  TaskScheduler scheduler(fakeMillis, fakeMicros);
+  scheduler.add("status", fastTask, 4000);
+  scheduler.run();
+  assert(nFastRuns == 1);
+  nFakeMicros = 1999000;
+  scheduler.run();
+  assert(fakeMillis() == 0xFFFFFFFFUL);
+  assert(nFastRuns == 1);
+  nFakeMicros = 3999000;
+  scheduler.run();
+  assert(fakeMillis() == 1999);
+  assert(nFastRuns == 1);
+  nFakeMicros = 4000000;
+  scheduler.run();
+  assert(nFastRuns == 2);
+}
+
+void TaskScheduler_test::testMillisUntilDue() const {
+  setClock(0xFFFFFFFFUL - 20);
+  TaskScheduler scheduler(fakeMillis, fakeMicros);
+  assert(scheduler.millisUntilDue(10) == 10);
+  const int nEveryPass = scheduler.add("every pass", fastTask);
+  assert(scheduler.millisUntilDue(10) == 10);
+  const int nLed = scheduler.add("led", fastTask, 100);
+  const int nStatus = scheduler.add("status", fastTask, 30);
+  assert(scheduler.millisUntilDue(10) == 0);
+  scheduler.run();
+  assert(scheduler.millisUntilDue(1000) == 30);
+  assert(scheduler.millisUntilDue(10) == 10);
+  nFakeMicros = 25000;
+  assert(scheduler.millisUntilDue(1000) == 5);
+  scheduler.enable(nStatus, false);
+  assert(scheduler.millisUntilDue(1000) == 75);
+  nFakeMicros = 100000;
+  assert(scheduler.millisUntilDue(1000) == 0);
+  scheduler.enable(nLed, false);
+  scheduler.enable(nEveryPass, false);
+  assert(scheduler.millisUntilDue(1000) == 1000);
+}
+
+void TaskScheduler_test::run() const {
+  testIntervals();
+  testFallingBehind();
+  testEnable();
+  testRunTime();
+  testWrapAround();
+  testMillisUntilDue();
+}
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef TASK_SCHEDULER_TEST_H
+#define TASK_SCHEDULER_TEST_H
+
+#if !defined(ENABLE_TASK_SCHEDULER_TEST)
+#define ENABLE_TASK_SCHEDULER_TEST true
+#endif
+
+#if ENABLE_TASK_SCHEDULER_TEST
+
+#include "TaskScheduler.h"
+
+/**
+ * Tests of the task scheduler on a fake clock. The tasks advance the
+ * clock to simulate their run time, hence the tests run on a host as well
+ * and take no time.
+ */
+class TaskScheduler_test {
+  public:
+    void run() const;
+
+    static TaskScheduler_test theTest;
+
+  private:
+    static unsigned long fakeMillis();
+    static unsigned long fakeMicros();
+    static void setClock(unsigned long nMillisOffset);
+    static void fastTask();
+    static void slowTask();
+
+    void testIntervals() const;
+    void testFallingBehind() const;
+    void testEnable() const;
+    void testRunTime() const;
+    void testWrapAround() const;
+    void testMillisUntilDue() const;
+};
+
+#endif
+
+#endif
@@ -0,0 +1,271 @@
+#include "TransmitQueue.h"
+
+TransmitQueue::TransmitQueue(RCSwitch& rcSwitch) : rcSwitch(rcSwitch) {
+  this->nJobCount = 0;
+  this->nNextSequence = 0;
+  this->bActive = false;
+  this->nActiveStartMicros = 0;
+  this->nLastDoneMicros = 0;
+  this->nSequenceAtDone = 0;
+  this->nStagedSequence = 0;
+  this->bStaged = false;
+  this->pJobDoneCallback = NULL;
+  this->pWaveformSource = NULL;
+  this->resetStats();
+}
+
+/* helper function for enqueue(), limits a value to the range of a uint8_t field */
+static uint8_t clampToByte(int value, int min) {
+  return (value < min) ? min : (value > 255) ? 255 : value;
+}
+
+/**
+ * Queue the first 'bitLength' bits of 'code' to be sent with 'protocol'.
+ * 'repeats' is limited to 1 to 255, 'priority' to 0 to 255.
+ *
+ * @return false, if the queue is full or 'protocol' or 'bitLength' is out
+ *         of range. A job that doesn't fit is counted as dropped.
+ */
+bool TransmitQueue::enqueue(unsigned long code, int protocol, int repeats, int priority, int bitLength) {
+  if (protocol < 1 || protocol > 255 || bitLength < 1 || bitLength > 32) {
+    this->txStats.rejectedJobs++;
+    return false;
+  }
+  Job job;
+  job.code = code;
+  job.protocol = protocol;
+  job.bitLength = bitLength;
+  job.repeats = clampToByte(repeats, 1);
+  job.priority = clampToByte(priority, 0);
+  job.signalId = 0;
+  return this->insert(job);
+}
+
+/**
+ * Queue the stored signal 'signalId'. Its waveform is looked up with the
+ * WaveformSource when the job is started. 'repeats' and 'priority' are
+ * limited like those of a code.
+ *
+ * @return false, if the queue is full or 'signalId' is 0. A job that
+ *         doesn't fit is counted as dropped.
+ */
+bool TransmitQueue::enqueueSignal(uint32_t signalId, int repeats, int priority) {
+  if (signalId == 0) {
+    this->txStats.rejectedJobs++;
+    return false;
+  }
+  Job job;
+  job.code = 0;
+  job.protocol = 0;
+  job.bitLength = 0;
+  job.repeats = clampToByte(repeats, 1);
+  job.priority = clampToByte(priority, 0);
+  job.signalId = signalId;
+  return this->insert(job);
+}
+
+/* Sorted insert: descending priority, FIFO within the same priority */
+bool TransmitQueue::insert(Job& job) {
+  if (this->nJobCount >= TRANSMIT_QUEUE_CAPACITY) {
+    this->txStats.droppedJobs++;
+    return false;
+  }
+  job.sequence = this->nNextSequence++;
+
+  unsigned int i = this->nJobCount;
+  while (i > 0 && this->jobs[i - 1].priority < job.priority) {
+    this->jobs[i] = this->jobs[i - 1];
+    i--;
+  }
+  this->jobs[i] = job;
+  this->nJobCount++;
+  return true;
+}
+
+/**
+ * Drop the queued jobs of the stored signal 'signalId', e.g. when it is
+ * replaced or removed. A job on air is finished, its waveform is a copy.
+ *
+ * @return the number of jobs dropped
+ */
+unsigned int TransmitQueue::cancel(uint32_t signalId) {
+  unsigned int nKept = 0;
+  for (unsigned int i = 0; i < this->nJobCount; i++) {
+    if (signalId == 0 || this->jobs[i].signalId != signalId) {
+      this->jobs[nKept++] = this->jobs[i];
+    }
+  }
+  const unsigned int nCancelled = this->nJobCount - nKept;
+  this->nJobCount = nKept;
+  this->txStats.cancelledJobs += nCancelled;
+  return nCancelled;
+}
+
+/**
+ * Drop all queued jobs. A job on air is finished.
+ */
+void TransmitQueue::clear() {
+  this->nJobCount = 0;
+  this->bStaged = false;
+}
+
+void TransmitQueue::run() {
+  this->run(micros());
+}
+
+/**
+ * Advance the queue. Call this from loop(), nowMicros is the current time
+ * as returned by micros().
+ */
+void TransmitQueue::run(unsigned long nowMicros) {
+  if (this->bActive) {
+    if (this->rcSwitch.isBusy()) {
+      // Use the air time to compile the next waveform.
+      this->stageHead();
+      return;
+    }
+    this->bActive = false;
+    this->nLastDoneMicros = nowMicros;
+    this->nSequenceAtDone = this->nNextSequence;
+    this->txStats.codesSent++;
+    this->txStats.framesSent += this->activeJob.repeats;
+    this->txStats.activeMicros += nowMicros - this->nActiveStartMicros;
+    if (this->pJobDoneCallback != NULL) {
+      this->pJobDoneCallback(this->activeJob);
+    }
+    if (this->nJobCount > 0) {
+      this->startHead(nowMicros);
+    }
+  } else if (this->nJobCount > 0) {
+    this->startHead(nowMicros);
+  }
+}
+
+/* Compile the code of the job with its protocol into waveform */
+void TransmitQueue::prepare(const Job& job, RCSwitch::Waveform& waveform) {
+  this->rcSwitch.setProtocol(job.protocol);
+  this->rcSwitch.compileWaveform(job.code, job.bitLength, waveform);
+}
+
+void TransmitQueue::stageHead() {
+  if (this->nJobCount == 0 || this->jobs[0].signalId != 0)
+    return;
+  if (this->bStaged && this->nStagedSequence == this->jobs[0].sequence)
+    return;
+  this->prepare(this->jobs[0], this->stagedWaveform);
+  this->nStagedSequence = this->jobs[0].sequence;
+  this->bStaged = true;
+}
+
+void TransmitQueue::removeHead() {
+  this->nJobCount--;
+  for (unsigned int i = 0; i < this->nJobCount; i++) {
+    this->jobs[i] = this->jobs[i + 1];
+  }
+}
+
+void TransmitQueue::startHead(unsigned long nowMicros) {
+  // Skip the jobs of signals that are gone
+  const RCSwitch::Waveform* pWaveform = NULL;
+  while (this->nJobCount > 0 && this->jobs[0].signalId != 0) {
+    if (this->pWaveformSource != NULL) {
+      pWaveform = this->pWaveformSource(this->jobs[0].signalId);
+    }
+    if (pWaveform != NULL)
+      break;
+    this->removeHead();
+    this->txStats.cancelledJobs++;
+  }
+  if (this->nJobCount == 0)
+    return;
+
+  this->activeJob = this->jobs[0];
+  this->removeHead();
+
+  if (pWaveform == NULL) {
+    if (!this->bStaged || this->nStagedSequence != this->activeJob.sequence) {
+      this->prepare(this->activeJob, this->stagedWaveform);
+    }
+    pWaveform = &this->stagedWaveform;
+  }
+  // The waveform is copied by sendWaveformAsync(), the stage is free again.
+  this->bStaged = false;
+
+  this->rcSwitch.setRepeatTransmit(this->activeJob.repeats);
+  if (!this->rcSwitch.sendWaveformAsync(*pWaveform)) {
+    // Somebody else is transmitting, retry with the next run().
+    Job job = this->activeJob;
+    this->nJobCount++;
+    for (unsigned int i = this->nJobCount - 1; i > 0; i--) {
+      this->jobs[i] = this->jobs[i - 1];
+    }
+    this->jobs[0] = job;
+    return;
+  }
+
+  // Jobs that were already waiting when the previous one finished
+  // should follow without delay.
+  if (this->txStats.codesSent > 0 && this->activeJob.sequence < this->nSequenceAtDone) {
+    const unsigned long gap = nowMicros - this->nLastDoneMicros;
+    if (gap > this->txStats.maxGapMicros) {
+      this->txStats.maxGapMicros = gap;
+    }
+  }
+  this->bActive = true;
+  this->nActiveStartMicros = nowMicros;
+}
+
+/**
+ * Install a callback that is called from run() after a job has been sent.
+ */
+void TransmitQueue::setJobDoneCallback(JobDoneCallback callback) {
+  this->pJobDoneCallback = callback;
+}
+
+/**
+ * Install the lookup of the stored signals queued with enqueueSignal().
+ * The waveform it returns only needs to stay valid until the call
+ * returns to the queue, it is copied for sending. Without a source,
+ * signal jobs are skipped.
+ */
+void TransmitQueue::setWaveformSource(WaveformSource source) {
+  this->pWaveformSource = source;
+}
+
+bool TransmitQueue::isIdle() const {
+  return !this->bActive && this->nJobCount == 0;
+}
+
+unsigned int TransmitQueue::pending() const {
+  return this->nJobCount;
+}
+
+/**
+ * @return the number of jobs that can be queued before the queue is full
+ */
+unsigned int TransmitQueue::room() const {
+  return TRANSMIT_QUEUE_CAPACITY - this->nJobCount;
+}
+
+const TransmitQueue::Stats& TransmitQueue::stats() const {
+  return this->txStats;
+}
+
+/**
+ * @return the throughput of the sent jobs, based on their on-air time.
+ */
+float TransmitQueue::codesPerSecond() const {
+  if (this->txStats.activeMicros == 0)
+    return 0.0f;
+  return this->txStats.codesSent * 1000000.0f / this->txStats.activeMicros;
+}
+
+void TransmitQueue::resetStats() {
+  this->txStats.codesSent = 0;
+  this->txStats.framesSent = 0;
+  this->txStats.droppedJobs = 0;
+  this->txStats.rejectedJobs = 0;
+  this->txStats.cancelledJobs = 0;
+  this->txStats.activeMicros = 0;
+  this->txStats.maxGapMicros = 0;
+}
@@ -0,0 +1,110 @@
+#ifndef TRANSMIT_QUEUE_H
+#define TRANSMIT_QUEUE_H
+
+#include <RCSwitch.h>
+
+#define TRANSMIT_QUEUE_CAPACITY 32
+
+/**
+ * Non-blocking transmit scheduler on top of RCSwitch.
+ *
+ * Jobs of (code, protocol, repeats, priority) are queued with enqueue()
+ * and sent one after the other by run(), which must be called from
+ * loop(). Higher priority jobs are sent first, jobs with equal priority
+ * in the order they were queued.
+ *
+ * Stored signals are queued by their ID with enqueueSignal(). The ID is
+ * resolved to the signal's waveform by the WaveformSource when the job
+ * is started, a job whose signal is gone by then is skipped. Hence the
+ * owner of the signals may replace or remove them at any time, cancel()
+ * drops their queued jobs right away.
+ *
+ * While a job is on air, the waveform of the next job is compiled ahead,
+ * so it can be started as soon as the transmitter becomes idle. The
+ * sync gap at the end of every frame serves as the inter-frame gap, no
+ * extra pause is added between jobs.
+ *
+ * The queue owns the repeat setting of the RCSwitch it drives.
+ */
+class TransmitQueue {
+  public:
+    struct Job {
+      unsigned long code;
+      uint8_t protocol;
+      uint8_t bitLength;
+      uint8_t repeats;
+      uint8_t priority;
+      /* The stored signal to send instead of the code, 0 for none */
+      uint32_t signalId;
+      uint32_t sequence;
+    };
+
+    typedef void (*JobDoneCallback)(const Job& job);
+    /* The waveform of a stored signal, NULL if there is no such signal anymore */
+    typedef const RCSwitch::Waveform* (*WaveformSource)(uint32_t signalId);
+
+    struct Stats {
+      unsigned long codesSent;
+      unsigned long framesSent;
+      /* Jobs that didn't fit into the queue */
+      unsigned long droppedJobs;
+      /* Jobs with a protocol or bit length out of range */
+      unsigned long rejectedJobs;
+      /* Jobs cancelled or skipped, because their signal was gone */
+      unsigned long cancelledJobs;
+      /* Sum of the on-air time of all sent jobs */
+      unsigned long activeMicros;
+      /* Largest idle time between two jobs that were queued back-to-back */
+      unsigned long maxGapMicros;
+    };
+
+    TransmitQueue(RCSwitch& rcSwitch);
+
+    bool enqueue(unsigned long code, int protocol, int repeats = 10, int priority = 0, int bitLength = 24);
+    bool enqueueSignal(uint32_t signalId, int repeats = 10, int priority = 0);
+    unsigned int cancel(uint32_t signalId);
+    void clear();
+
+    void run();
+    void run(unsigned long nowMicros);
+
+    void setJobDoneCallback(JobDoneCallback callback);
+    void setWaveformSource(WaveformSource source);
+
+    bool isIdle() const;
+    unsigned int pending() const;
+    unsigned int room() const;
+    const Stats& stats() const;
+    float codesPerSecond() const;
+    void resetStats();
+
+  private:
+    bool insert(Job& job);
+    void startHead(unsigned long nowMicros);
+    void removeHead();
+    void prepare(const Job& job, RCSwitch::Waveform& waveform);
+    void stageHead();
+
+    RCSwitch& rcSwitch;
+    Job jobs[TRANSMIT_QUEUE_CAPACITY];
+    unsigned int nJobCount;
+    uint32_t nNextSequence;
+
+    /* The job on air */
+    Job activeJob;
+    bool bActive;
+    unsigned long nActiveStartMicros;
+    unsigned long nLastDoneMicros;
+    uint32_t nSequenceAtDone;
+
+    /* The waveform compiled ahead for the job at the head of the queue */
+    RCSwitch::Waveform stagedWaveform;
+    uint32_t nStagedSequence;
+    bool bStaged;
+
+    JobDoneCallback pJobDoneCallback;
+    WaveformSource pWaveformSource;
+    Stats txStats;
+};
+
+#endif
@@ -0,0 +1,203 @@
+#include "TransmitQueue_test.h"
+
+#if ENABLE_TRANSMIT_QUEUE_TEST
+
+#include <assert.h>
+
+/** Call TransmitQueue_test::theTest.run() to execute tests. */
+TransmitQueue_test TransmitQueue_test::theTest;
+
+static const unsigned long nLoopMicros = 50;
+
+static unsigned long nSimMicros = 0;
+static unsigned long nAlarmMicros = 0;
+static bool bAlarmArmed = false;
+
+/* The jobs in the order they were done */
+static TransmitQueue::Job doneJobs[8];
+static unsigned int nDoneCount = 0;
+
+/* The stored signals of the tests, signal 7 only */
+static RCSwitch::Waveform storedWaveform;
+static uint32_t nStoredId = 7;
+
+void TransmitQueue_test::startTimer(unsigned int nMicroseconds) {
+  nAlarmMicros = nSimMicros + nMicroseconds;
+  bAlarmArmed = true;
+}
+
+void TransmitQueue_test::nextTimer(unsigned int nMicroseconds) {
+  nAlarmMicros += nMicroseconds;
+  bAlarmArmed = true;
+}
+
+void TransmitQueue_test::onJobDone(const TransmitQueue::Job& job) {
+  if (nDoneCount < sizeof(doneJobs) / sizeof(doneJobs[0])) {
+    doneJobs[nDoneCount] = job;
+  }
+  nDoneCount++;
+}
+
+const RCSwitch::Waveform* TransmitQueue_test::findWaveform(uint32_t signalId) {
+  return (signalId == nStoredId) ? &storedWaveform : NULL;
+}
+
+/* Call run() every nLoopMicros, the timer expires in between */
+void TransmitQueue_test::runUntilIdle(TransmitQueue& queue, RCSwitch& rcSwitch) {
+  for (unsigned long nGuard = 0; !queue.isIdle(); nGuard++) {
+    assert(nGuard < 1000000);
+    queue.run(nSimMicros);
+    const unsigned long nUntil = nSimMicros + nLoopMicros;
+    while (bAlarmArmed && (long)(nAlarmMicros - nUntil) <= 0) {
+      bAlarmArmed = false;
+      nSimMicros = nAlarmMicros;
+      RCSwitch::handleTransmitTimer();
+    }
+    nSimMicros = nUntil;
+  }
+  assert(!rcSwitch.isBusy());
+}
+
+/* Higher priority first, FIFO within the same priority */
+void TransmitQueue_test::testOrder(RCSwitch& rcSwitch) const {
+  TransmitQueue queue(rcSwitch);
+  queue.setJobDoneCallback(&onJobDone);
+  queue.setWaveformSource(&findWaveform);
+  nDoneCount = 0;
+
+  rcSwitch.setProtocol(1);
+  rcSwitch.compileWaveform(77, 24, storedWaveform);
+  assert(queue.enqueue(1, 1, 3, 0));
+  assert(queue.enqueue(2, 2, 3, 0));
+  assert(queue.enqueue(3, 1, 3, 5));
+  assert(queue.enqueueSignal(nStoredId, 2, 0));
+  assert(queue.pending() == 4);
+
+  // a high priority code arrives while the first job is on air
+  queue.run(nSimMicros);
+  assert(rcSwitch.isBusy());
+  assert(queue.enqueue(4, 1, 3, 9));
+  runUntilIdle(queue, rcSwitch);
+
+  assert(nDoneCount == 5);
+  assert(doneJobs[0].code == 3);
+  assert(doneJobs[1].code == 4);
+  assert(doneJobs[2].code == 1);
+  assert(doneJobs[3].code == 2);
+  assert(doneJobs[4].signalId == nStoredId);
+  assert(queue.stats().codesSent == 5);
+  assert(queue.stats().framesSent == 14);
+}
+
+/* Queued jobs follow each other without a gap, throughput is on-air time */
+void TransmitQueue_test::testBackToBack(RCSwitch& rcSwitch) const {
+  TransmitQueue queue(rcSwitch);
+  for (unsigned long code = 0; code < 10; code++) {
+    assert(queue.enqueue(0x500000 + code, 1, 2));
+  }
+  runUntilIdle(queue, rcSwitch);
+
+  // protocol 1: 24 bits of 4 pulses and a sync of 32 pulses, 350 us each
+  const unsigned long nJobMicros = 2 * (24 * 4 + 32) * 350;
+  const TransmitQueue::Stats& stats = queue.stats();
+  assert(stats.codesSent == 10);
+  assert(stats.framesSent == 20);
+  // the end of a job is noticed by the next run()
+  assert(stats.activeMicros >= 10 * nJobMicros);
+  assert(stats.activeMicros <= 10 * (nJobMicros + nLoopMicros));
+  assert(stats.maxGapMicros <= nLoopMicros);
+  const float codesPerSecond = queue.codesPerSecond();
+  assert(codesPerSecond > 1000000.0f / (nJobMicros + nLoopMicros));
+  assert(codesPerSecond <= 1000000.0f / nJobMicros);
+}
+
+void TransmitQueue_test::testLimits(RCSwitch& rcSwitch) const {
+  TransmitQueue queue(rcSwitch);
+  queue.setJobDoneCallback(&onJobDone);
+
+  // out of range values would be truncated by the byte sized fields
+  assert(!queue.enqueue(1, 0));
+  assert(!queue.enqueue(1, 256));
+  assert(!queue.enqueue(1, 1, 10, 0, 0));
+  assert(!queue.enqueue(1, 1, 10, 0, 33));
+  assert(queue.stats().rejectedJobs == 4);
+  assert(queue.stats().droppedJobs == 0);
+  assert(queue.pending() == 0);
+
+  nDoneCount = 0;
+  assert(queue.enqueue(1, 1, 0, 1000, 8));
+  assert(queue.enqueue(2, 1, 300, -5, 8));
+  runUntilIdle(queue, rcSwitch);
+  assert(nDoneCount == 2);
+  assert(doneJobs[0].code == 1 && doneJobs[0].repeats == 1 && doneJobs[0].priority == 255);
+  assert(doneJobs[1].code == 2 && doneJobs[1].repeats == 255 && doneJobs[1].priority == 0);
+  assert(queue.stats().framesSent == 256);
+
+  // a full queue drops the job
+  assert(queue.room() == TRANSMIT_QUEUE_CAPACITY);
+  for (unsigned int i = 0; i < TRANSMIT_QUEUE_CAPACITY; i++) {
+    assert(queue.enqueue(i, 1));
+  }
+  assert(queue.room() == 0);
+  assert(!queue.enqueue(99, 1));
+  assert(queue.stats().droppedJobs == 1);
+  queue.clear();
+  assert(queue.isIdle());
+  assert(queue.room() == TRANSMIT_QUEUE_CAPACITY);
+}
+
+/* Jobs of signals that are replaced or removed are not sent */
+void TransmitQueue_test::testCancel(RCSwitch& rcSwitch) const {
+  TransmitQueue queue(rcSwitch);
+  queue.setJobDoneCallback(&onJobDone);
+  queue.setWaveformSource(&findWaveform);
+  nDoneCount = 0;
+
+  rcSwitch.setProtocol(1);
+  rcSwitch.compileWaveform(77, 24, storedWaveform);
+  assert(!queue.enqueueSignal(0));
+  assert(queue.stats().rejectedJobs == 1);
+  assert(queue.enqueueSignal(nStoredId, 1));
+  assert(queue.enqueue(1, 1, 1));
+  assert(queue.enqueueSignal(nStoredId, 1));
+  assert(queue.enqueueSignal(8, 1));
+  assert(queue.cancel(nStoredId) == 2);
+  assert(queue.cancel(nStoredId) == 0);
+  assert(queue.pending() == 2);
+
+  // signal 7 is replaced by signal 9 in the same place while queued
+  assert(queue.enqueueSignal(nStoredId, 1));
+  nStoredId = 9;
+  assert(queue.enqueueSignal(nStoredId, 1));
+  runUntilIdle(queue, rcSwitch);
+  nStoredId = 7;
+
+  assert(nDoneCount == 2);
+  assert(doneJobs[0].code == 1);
+  assert(doneJobs[1].signalId == 9);
+  assert(queue.stats().codesSent == 2);
+  assert(queue.stats().cancelledJobs == 4);
+
+  // without a source there are no signals
+  queue.setWaveformSource(NULL);
+  assert(queue.enqueueSignal(nStoredId, 1));
+  runUntilIdle(queue, rcSwitch);
+  assert(nDoneCount == 2);
+  assert(queue.stats().cancelledJobs == 5);
+}
+
+void TransmitQueue_test::run(int nTransmitterPin) const {
+  RCSwitch rcSwitch;
+  rcSwitch.enableTransmit(nTransmitterPin);
+  static const RCSwitch::TransmitTimer simulatedTimer = { &startTimer, &nextTimer };
+  RCSwitch::setTransmitTimer(&simulatedTimer);
+
+  testOrder(rcSwitch);
+  testBackToBack(rcSwitch);
+  testLimits(rcSwitch);
+  testCancel(rcSwitch);
+
+  RCSwitch::setTransmitTimer(NULL);
+}
+
+#endif
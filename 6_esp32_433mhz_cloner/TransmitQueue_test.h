@@ -0,0 +1,47 @@
+#ifndef TRANSMIT_QUEUE_TEST_H
+#define TRANSMIT_QUEUE_TEST_H
+
+// The test replaces the transmit timer of RCSwitch, hence it runs on a host only
+#if !defined(ENABLE_TRANSMIT_QUEUE_TEST)
+#if defined(ESP32)
+#define ENABLE_TRANSMIT_QUEUE_TEST false
+#else
+#define ENABLE_TRANSMIT_QUEUE_TEST true
+#endif
+#endif
+
+#if ENABLE_TRANSMIT_QUEUE_TEST
+
+#include "TransmitQueue.h"
+
+/**
+ * Tests of the transmit queue on a simulated clock. RCSwitch plays the
+ * jobs on a simulated transmit timer, which advances the clock to each
+ * expiry. loop() is simulated to call run() every 50 us, hence the tests
+ * take no time.
+ *
+ * The transmitter pin passed to run() is toggled, so it must not have a
+ * transmitter attached.
+ */
+class TransmitQueue_test {
+  public:
+    void run(int nTransmitterPin) const;
+
+    static TransmitQueue_test theTest;
+
+  private:
+    static void startTimer(unsigned int nMicroseconds);
+    static void nextTimer(unsigned int nMicroseconds);
+    static void onJobDone(const TransmitQueue::Job& job);
+    static const RCSwitch::Waveform* findWaveform(uint32_t signalId);
+    static void runUntilIdle(TransmitQueue& queue, RCSwitch& rcSwitch);
+
+    void testOrder(RCSwitch& rcSwitch) const;
+    void testBackToBack(RCSwitch& rcSwitch) const;
+    void testLimits(RCSwitch& rcSwitch) const;
+    void testCancel(RCSwitch& rcSwitch) const;
+};
+
+#endif
+
+#endif
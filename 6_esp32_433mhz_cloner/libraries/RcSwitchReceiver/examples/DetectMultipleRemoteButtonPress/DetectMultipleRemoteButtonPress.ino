@@ -30,6 +30,7 @@
 #include "ProtocolDefinition.hpp"
 #include "RcSwitchReceiver.hpp"
 #include "RcButtonPressDetector.hpp"
+#include "RcButtonMap.hpp"
 #include <Arduino.h>
 
 #define PRINT_DETECTED_BUTTON true
@@ -80,6 +81,30 @@ enum class BUTTON_CODE : int { // Note: valid button codes must not be negative.
 	I_ALL_OFF,
 };
 
+#define BUTTON(protocol, value, code) {protocol, value, static_cast<RcButtonMap::rcButtonCode_t>(BUTTON_CODE::code)}
+
+// The received values of the buttons. Instead of a switch statement over the
+// values in rcDataToButton(), the button press detector looks them up with a
+// binary search, hence they must be sorted by value. Add more buttons here.
+static constexpr RcButtonMap::Entry BUTTONS[] = {
+	//     protocol        , value     , button
+	BUTTON(PROTOCOL_PT2262 , 5592323   , C),
+	BUTTON(PROTOCOL_PT2262 , 5592332   , A),
+	BUTTON(PROTOCOL_PT2262 , 5592368   , D),
+	BUTTON(PROTOCOL_PT2262 , 5592512   , B),
+	BUTTON(PROTOCOL_SYGONIX, 2171105792, I_1_OFF),
+	BUTTON(PROTOCOL_SYGONIX, 2389209600, I_1_ON),
+	BUTTON(PROTOCOL_SYGONIX, 2473095680, I_ALL_ON),
+	BUTTON(PROTOCOL_SYGONIX, 2523427328, I_3_ON),
+	BUTTON(PROTOCOL_SYGONIX, 2657645056, I_3_OFF),
+	BUTTON(PROTOCOL_SYGONIX, 2741531136, I_ALL_OFF),
+	BUTTON(PROTOCOL_SYGONIX, 2791862784, I_2_ON),
+	BUTTON(PROTOCOL_SYGONIX, 2926080512, I_2_OFF),
+};
+static_assert(RcButtonMap::isSorted(BUTTONS), "Error: BUTTONS must be sorted by value.");
+
+static const RcButtonMap buttonMap(BUTTONS);
+
 #if PRINT_DETECTED_BUTTON
 static const char* const BUTTON_TEXT[] = { // Must be ordered as in enum BUTTON_CODE
 		"A","B","C","D",
@@ -131,54 +156,6 @@ class MyRcButtonPressDetector : public RcButtonPressDetector { // @suppress("Cla
 		return result;
 	}
 
-	rcButtonCode_t rcDataToButton(const int rcProtocol, receivedValue_t receivedData) const override {
-		BUTTON_CODE buttonCode = static_cast<BUTTON_CODE>(RcButtonPressDetector::rcDataToButton(rcProtocol, receivedData));
-		if(rcProtocol == PROTOCOL_PT2262) {
-			switch (receivedData) {
-			case 5592332:
-				buttonCode = BUTTON_CODE::A;
-				break;
-			case 5592512:
-				buttonCode = BUTTON_CODE::B;
-				break;
-			case 5592323:
-				buttonCode = BUTTON_CODE::C;
-				break;
-			case 5592368:
-				buttonCode = BUTTON_CODE::D;
-				break;
-			}
-		} else if(rcProtocol == PROTOCOL_SYGONIX) {
-			switch (receivedData) {
-			case 2389209600:
-				buttonCode = BUTTON_CODE::I_1_ON;
-				break;
-			case 2791862784:
-				buttonCode = BUTTON_CODE::I_2_ON;
-				break;
-			case 2523427328:
-				buttonCode = BUTTON_CODE::I_3_ON;
-				break;
-			case 2473095680:
-				buttonCode = BUTTON_CODE::I_ALL_ON;
-				break;
-			case 2171105792:
-				buttonCode = BUTTON_CODE::I_1_OFF;
-				break;
-			case 2926080512:
-				buttonCode = BUTTON_CODE::I_2_OFF;
-				break;
-			case 2657645056:
-				buttonCode = BUTTON_CODE::I_3_OFF;
-				break;
-			case 2741531136:
-				buttonCode = BUTTON_CODE::I_ALL_OFF;
-				break;
-			}
-		}
-		return static_cast<rcButtonCode_t>(buttonCode);
-	}
-
 	// The detected button is printed here and the builtin led is set.
 	void onButtonPressed(rcButtonCode_t buttonCode) const override {
 #if PRINT_DETECTED_BUTTON
@@ -194,6 +171,14 @@ class MyRcButtonPressDetector : public RcButtonPressDetector { // @suppress("Cla
 		}
 	}
 
+#if PRINT_DETECTED_BUTTON
+	// Called once, when a button is held down for a second.
+	void onButtonHeld(rcButtonCode_t buttonCode) const override {
+		output.print("You hold button ");
+		output.println(buttonToText(buttonCode));
+	}
+#endif
+
 public:
 	MyRcButtonPressDetector()
 		: RcButtonPressDetector(400) // Use 400ms instead of 250ms default for debounce
@@ -210,6 +195,8 @@ void setup()
 	pinMode(LED_BUILTIN, OUTPUT);
 	rcSwitchReceiver.begin(rxProtocolTable.toTimingSpecTable());
 	rcButtonPressDetector.begin(rcSwitchReceiver);
+	rcButtonPressDetector.setButtonMap(&buttonMap);
+	rcButtonPressDetector.setHoldTime(1000);
 }
 
 // The loop function is called in an endless loop
@@ -105,6 +105,11 @@ void loop()
 			output.print(protocolNumber);
 		}
 
+		if(n > 1) {
+			output.print(" / Best fit: ");
+			output.print(rcSwitchReceiver.bestProtocol());
+		}
+
 		output.println();
 
 		rcSwitchReceiver.resetAvailable();
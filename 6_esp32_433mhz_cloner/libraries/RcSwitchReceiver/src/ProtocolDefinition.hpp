@@ -114,6 +114,54 @@ template<
 	bool inverseLevel>               /* Flag whether pulse levels are normal or inverse. */
 struct makeTimingSpec;
 
+/*
+ * Pulse distance coding, where all data bits start with a pulse of the same
+ * duration and the pause after it tells a logical 0 from a logical 1, is a
+ * pulse pair protocol as well, e.g.:
+ *
+ *  //                   #, clk,  %, syA,  syB,  d0A,d0B,  d1A,d1B, inverseLevel
+ *  	makeTimingSpec< 20, 560, 20,  16,    8,    1,  1,    1,  3, false>
+ *
+ * A pulse pair protocol's message packet ends with the next synch pulse
+ * pair, or with a pause longer than the synch pulse pair. The latter is the case
+ * for protocols that send the synch in front of the data and end with a
+ * guard time, e.g. KeeLoq HCS. The pulse pair that ends with the pause
+ * is no data bit, hence the last data bit is lost then:
+ *
+ *  	makeTimingSpec< 13, 400, 20,   1,   10,    2,  1,    1,  2, false>
+ *
+ * Manchester coding has a level change in the middle of every data bit
+ * instead. Pulses are one or two half bits long, hence a data bit doesn't
+ * match a pulse pair. A logical 1 starts with the level of synch pulse A
+ * and changes to the other level in the middle of the bit, a logical 0 does
+ * it the other way round:
+ *
+ *     Normal level protocols, logical 1 followed by logical 0:
+ *          _____       _____
+ *     XXXX|     |_____|     |XXXX
+ *
+ *  The first half of the first data bit may extend synch pulse B by a half
+ *  bit, if it has the level of synch pulse B. The message packet ends with
+ *  the first pulse that is neither a half nor a full bit long.
+ *
+ *  Manchester and pulse pair protocols can be mixed in one RxProtocolTable.
+ *  They are decoded in parallel on the same pulses.
+ */
+
+/**
+ * makeManchesterTimingSpec
+ *
+ * Calculates the pulse timings specification of a Manchester coded protocol
+ * at compile time. To be used in combination with RxProtocolTable below.
+ */
+template<
+	unsigned int protocolNumber,           /* A unique integer identifier of this protocol. */
+	unsigned int usecClock,                /* The duration of half a data bit in microseconds.  */
+	unsigned percentTolerance,       /* The tolerance for a pulse length to be recognized as a valid. */
+	unsigned int synchA,  unsigned int synchB,   /* Number of clocks for the synchronization pulse pair. */
+	bool inverseLevel>               /* Flag whether pulse levels are normal or inverse. */
+struct makeManchesterTimingSpec;
+
 /**
  * RxProtocolTable
  *
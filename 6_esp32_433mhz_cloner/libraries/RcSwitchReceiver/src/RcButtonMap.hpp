@@ -0,0 +1,137 @@
+/*
+  RcSwitchReceiver - Arduino libary for remote control receiver Copyright (c)
+  2024 Wolfgang Schmieder.  All right reserved.
+
+  Contributors:
+  - Wolfgang Schmieder
+
+  Project home: https://github.com/dac1e/RcSwitchReceiver/
+
+  This library is free software; you can redistribute it and/or modify it
+  the terms of the GNU Lesser General Public License as under published
+  by the Free Software Foundation; either version 3.0 of the License,
+  or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+*/
+
+
+#pragma once
+
+#ifndef RCSWITCH_RCBUTTONMAP_API_HPP_
+#define RCSWITCH_RCBUTTONMAP_API_HPP_
+
+#include <stddef.h>
+#include "internal/RcSwitch.hpp"
+
+/**
+ * Maps received values to button codes, for the RcButtonPressDetector.
+ * The entries are sorted by value and protocol, hence a lookup is a
+ * binary search, O(log n) also for hundreds of buttons.
+ *
+ * The map can refer to a constant table that is populated at compile time:
+ *
+ *	static constexpr RcButtonMap::Entry BUTTONS[] = {
+ *		// protocol, value, button code, sorted by value and protocol
+ *		{1, 5592323, 'C'},
+ *		{1, 5592332, 'A'},
+ *		{1, 5592368, 'D'},
+ *		{1, 5592512, 'B'},
+ *	};
+ *	static_assert(RcButtonMap::isSorted(BUTTONS), "BUTTONS must be sorted");
+ *	static const RcButtonMap buttonMap(BUTTONS);
+ *
+ * Buttons learned at runtime go into an RcButtonMapStore instead.
+ */
+class RcButtonMap {
+public:
+	using receivedValue_t = RcSwitch::receivedValue_t;
+	using rcButtonCode_t = int;
+	static constexpr rcButtonCode_t NO_BUTTON = -1;
+
+	struct Entry {
+		int protocol;
+		receivedValue_t value;
+		rcButtonCode_t buttonCode;
+	};
+
+	constexpr RcButtonMap(const Entry* entries, const size_t size)
+		: mEntries(entries), mSize(size) {
+	}
+
+	template<size_t N> constexpr RcButtonMap(const Entry (&entries)[N])
+		: mEntries(entries), mSize(N) {
+	}
+
+	/**
+	 * Return the button code for the value received with the protocol.
+	 * NO_BUTTON, if there is none.
+	 */
+	rcButtonCode_t find(const int protocol, const receivedValue_t value) const;
+
+	inline size_t size() const {return mSize;}
+	inline const Entry& at(const size_t index) const {return mEntries[index];}
+
+	/** The order of the entries: by value, then by protocol. */
+	static constexpr bool less(const Entry& a, const Entry& b) {
+		return a.value < b.value || (a.value == b.value && a.protocol < b.protocol);
+	}
+
+	/** For a static_assert on a table populated at compile time. */
+	template<size_t N> static constexpr bool isSorted(const Entry (&entries)[N], const size_t index = 1) {
+		return index >= N || (less(entries[index - 1], entries[index]) && isSorted(entries, index + 1));
+	}
+
+protected:
+	const Entry* mEntries;
+	size_t mSize;
+
+	/** Return the index of the first entry not less than (protocol, value). */
+	size_t lowerBound(const int protocol, const receivedValue_t value) const;
+
+	/** Insert or update an entry of the CAPACITY entries at 'entries'. */
+	bool insert(Entry* entries, const size_t capacity, const Entry& entry);
+	bool remove(Entry* entries, const int protocol, const receivedValue_t value);
+};
+
+/**
+ * A button map that stores up to CAPACITY entries in RAM, e.g. for
+ * buttons learned at runtime. Entries are kept sorted on insertion.
+ */
+template<size_t CAPACITY> class RcButtonMapStore : public RcButtonMap {
+	Entry mStore[CAPACITY];
+
+public:
+	RcButtonMapStore() : RcButtonMap(mStore, 0) {
+	}
+
+	/* The base class refers to mStore, hence no copies. */
+	RcButtonMapStore(const RcButtonMapStore&) = delete;
+	RcButtonMapStore& operator=(const RcButtonMapStore&) = delete;
+
+	/**
+	 * Map the value received with the protocol to the button code. An
+	 * existing mapping of the value is changed. Returns false, if the
+	 * store is full.
+	 */
+	bool add(const int protocol, const receivedValue_t value, const rcButtonCode_t buttonCode) {
+		return insert(mStore, CAPACITY, Entry{protocol, value, buttonCode});
+	}
+
+	/** Returns false, if the value was not mapped. */
+	bool remove(const int protocol, const receivedValue_t value) {
+		return RcButtonMap::remove(mStore, protocol, value);
+	}
+
+	void clear() {mSize = 0;}
+	static constexpr size_t capacity() {return CAPACITY;}
+};
+
+#endif /* RCSWITCH_RCBUTTONMAP_API_HPP_ */
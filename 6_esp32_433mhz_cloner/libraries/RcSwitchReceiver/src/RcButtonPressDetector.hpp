@@ -29,30 +29,41 @@
 #define RCSWITCH_RCBUTTONPRESSDETECTOR_API_HPP_
 
 #include "internal/RcSwitch.hpp"
+#include "RcButtonMap.hpp"
+
 /**
  * The Remote control transmitter typically repeats sending the message
  * packet for a button as long as the button is pressed. This class
  * filters out the repeated message packages and signals a signal pressed
  * remote control button only once.
+ *
+ * Up to MAX_ACTIVE_BUTTONS buttons are tracked at the same time, each with
+ * its own release timeout. Hence two remotes in use at once, whose packets
+ * alternate, signal each button only once. Optionally a button held down
+ * signals a long press and then repeats, see setHoldTime().
  */
 class RcButtonPressDetector {
 public:
 	using receivedValue_t = RcSwitch::receivedValue_t;
 	using rcButtonCode_t = int;
 	static constexpr rcButtonCode_t NO_BUTTON = -1;
+	static constexpr size_t MAX_ACTIVE_BUTTONS = 4;
 
 private:
-	enum class STATE {
-		OFF,
-		OFF_DELAY,
-		ON,
+	struct ActiveButton {
+		rcButtonCode_t buttonCode;	// NO_BUTTON for an unused slot
+		uint32_t msecPressed;		// time of the first packet
+		uint32_t msecLastSeen;		// time of the latest packet
+		uint32_t msecNextEvent;		// time of the next hold or repeat event
+		unsigned int repeatCount;	// events after the press, 1 is the hold
 	};
 
 	const unsigned int mDebounceDelayTime; // in milliseconds
+	unsigned int mHoldTime;		// in milliseconds, 0 for no hold events
+	unsigned int mRepeatInterval;	// in milliseconds, 0 for no repeat events
 	RcSwitch::Receiver* mRcSwitchReceiver;
-	STATE mRcButtonState = STATE::OFF;
-	rcButtonCode_t mLastPressedButton;
-	uint32_t mOffDelayStartTime;
+	const RcButtonMap* mButtonMap;
+	ActiveButton mActiveButtons[MAX_ACTIVE_BUTTONS];
 
 	rcButtonCode_t testRcButtonData();
 
@@ -81,6 +92,26 @@ private:
 	 */
 	virtual void onButtonPressed(rcButtonCode_t buttonCode) const = 0;
 
+	/**
+	 * Called once, when a button has been held down for the hold time
+	 * of setHoldTime(), e.g. for a long press action. Does nothing by
+	 * default.
+	 */
+	virtual void onButtonHeld(rcButtonCode_t buttonCode) const {}
+
+	/**
+	 * Called every repeat interval of setHoldTime() after onButtonHeld(),
+	 * while the button stays held down. 'repeatCount' starts at 1.
+	 * Does nothing by default.
+	 */
+	virtual void onButtonRepeated(rcButtonCode_t buttonCode, unsigned int repeatCount) const {}
+
+	/**
+	 * Called when no packet of a pressed button was received for the
+	 * debounce delay time. Does nothing by default.
+	 */
+	virtual void onButtonReleased(rcButtonCode_t buttonCode) const {}
+
 protected:
 	/**
 	 * This virtual function must be overridden, and provide positive button
@@ -131,7 +162,55 @@ protected:
 
 public:
 	RcButtonPressDetector(unsigned int msecDebounceDelayTime = 250);
+
+	/**
+	 * Evaluate a received message packet and the timers of the pressed
+	 * buttons, call on every loop(). All events are called from here.
+	 */
 	void scanRcButtons();
+	void scanRcButtons(uint32_t msecNow);
+
+	/**
+	 * Signal onButtonHeld() after a button has been held down for
+	 * 'msecHoldTime', then onButtonRepeated() every 'msecRepeatInterval'.
+	 * 0 disables the events, which is the default. The hold time should be
+	 * well above the debounce delay time, the repeat interval above the
+	 * packet repeat time of the remote control.
+	 */
+	void setHoldTime(unsigned int msecHoldTime, unsigned int msecRepeatInterval = 0) {
+		mHoldTime = msecHoldTime;
+		mRepeatInterval = msecRepeatInterval;
+	}
+
+	/**
+	 * Number of buttons currently held down.
+	 */
+	size_t activeButtonCount() const;
+
+	/**
+	 * True if 'buttonCode' is currently held down.
+	 */
+	bool isPressed(rcButtonCode_t buttonCode) const;
+
+	/**
+	 * Return the time in milliseconds until scanRcButtons() must be called
+	 * again, unless a message packet arrives earlier. NO_SCAN_TIMEOUT, if
+	 * only a message packet needs a scan. Together with the available
+	 * callback of the receiver, a consumer can sleep between the scans
+	 * instead of calling scanRcButtons() on every loop().
+	 */
+	uint32_t msecScanTimeout() const;
+	uint32_t msecScanTimeout(uint32_t msecNow) const;
+
+	/**
+	 * Look up the button codes in a map instead of calling rcDataToButton().
+	 * A lookup is a binary search, which is faster than a switch statement
+	 * over hundreds of buttons and needs no virtual function call.
+	 * nullptr to use rcDataToButton() again. The map must outlive this
+	 * detector. For an example refer to DetectMultipleRemoteButtonPress.ino.
+	 */
+	void setButtonMap(const RcButtonMap* buttonMap) {mButtonMap = buttonMap;}
+	static constexpr uint32_t NO_SCAN_TIMEOUT = UINT32_MAX;
 
 	/**
 	 * Attach the RcSwitchReceiver to this button detector.
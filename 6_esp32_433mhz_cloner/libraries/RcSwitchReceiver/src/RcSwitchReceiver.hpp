@@ -29,6 +29,7 @@
 
 #include "internal/ISR_ATTR.hpp"
 #include "internal/RcSwitch.hpp"
+#include "internal/EdgeCapture.hpp"
 #include "ProtocolDefinition.hpp"
 #include <Arduino.h>
 
@@ -60,11 +61,16 @@ public:
 	using basicReceiver_t = RcSwitch::Receiver;
 private:
 	static receiver_t mReceiverDelegate;
+	static RcSwitch::EdgeCapture mEdgeCapture;
 
 	TEXT_ISR_ATTR_0 static void handleInterrupt() {
 		const unsigned long time = micros();
 		const int pinLevel = digitalRead(IOPIN);
-		mReceiverDelegate.handleInterrupt(pinLevel, time);
+		if(mEdgeCapture.active()) {
+			mEdgeCapture.push(pinLevel, time);
+		} else {
+			mReceiverDelegate.handleInterrupt(pinLevel, time);
+		}
 	}
 public:
 	/**
@@ -74,6 +80,7 @@ public:
 	static void begin(const RxTimingSpecTable& rxTimingSpecTable) {
 		pinMode(IOPIN, INPUT_PULLUP);
 		mReceiverDelegate.setRxTimingSpecTable(rxTimingSpecTable);
+		mEdgeCapture.setWakePulse(rxTimingSpecTable);
 		attachInterrupt(digitalPinToInterrupt(IOPIN), handleInterrupt, CHANGE);
 	}
 
@@ -100,6 +107,16 @@ public:
 	 */
 	static inline size_t receivedBitsCount() {return mReceiverDelegate.receivedBitsCount();}
 
+	/**
+	 * Return the data bits received after the first MAX_MSG_PACKET_BITS,
+	 * the first of them reflected as the highest significant bit of
+	 * receivedBitsCount() - MAX_MSG_PACKET_BITS bits. At most another
+	 * MAX_MSG_PACKET_BITS are kept, e.g. the serial number and buttons
+	 * of a 66 bit KeeLoq frame following its 32 bit hopping code.
+	 * Must not be called, when available returns false.
+	 */
+	static inline receivedValue_t receivedOverflowValue() {return mReceiverDelegate.receivedOverflowValue();}
+
 	/**
 	 * Return the number of protocols that matched the synch and
 	 * data pulses for the received value.
@@ -139,6 +156,65 @@ public:
 	static inline int receivedProtocol(const size_t index = 0)
 		{return mReceiverDelegate.receivedProtocol(index);}
 
+	/**
+	 * Return the protocol number that matched the synch and data
+	 * pulses of the received value best. When multiple protocols
+	 * matched (refer to receivedProtocolCount()), the protocol whose
+	 * nominal pulse durations have the smallest accumulated deviation
+	 * from the received pulse durations is returned. -1 is returned
+	 * if no value is available.
+	 */
+	static inline int bestProtocol() {return mReceiverDelegate.bestProtocol();}
+
+	/**
+	 * Return the residual timing error of the best protocol. That is
+	 * the average deviation of a received pulse from the protocol's
+	 * nominal pulse duration in microseconds. 0 is returned if no
+	 * value is available.
+	 */
+	static inline uint32_t bestProtocolTimingError() {return mReceiverDelegate.bestProtocolTimingError();}
+
+	/**
+	 * Return the largest deviation of a received data pulse from the
+	 * best protocol's nominal pulse duration in microseconds. 0 is
+	 * returned if no value is available.
+	 */
+	static inline uint32_t bestProtocolMaxDeviation() {return mReceiverDelegate.bestProtocolMaxDeviation();}
+
+	/**
+	 * Return the jitter of the received data pulses in microseconds.
+	 * That is the average change of the deviation from the best
+	 * protocol's nominal pulse duration between subsequent data pulses
+	 * of the same level and nominal duration. A slow or fast clock and a
+	 * constant offset of the receiver's edges add no jitter. 0 is
+	 * returned if no value is available.
+	 */
+	static inline uint32_t bestProtocolJitter() {return mReceiverDelegate.bestProtocolJitter();}
+
+	/**
+	 * Return bestProtocolMaxDeviation() and bestProtocolJitter() in
+	 * percent of the nominal duration of each pulse. Unlike the
+	 * microseconds these compare across protocols with a short and a
+	 * long clock. 0 is returned if no value is available.
+	 */
+	static inline uint32_t bestProtocolMaxDeviationPercent() {return mReceiverDelegate.bestProtocolMaxDeviationPercent();}
+	static inline uint32_t bestProtocolJitterPercent() {return mReceiverDelegate.bestProtocolJitterPercent();}
+
+	/**
+	 * Return the sum of the durations of the received data pulses in
+	 * microseconds. Together with bestProtocolDataDuration() this gives
+	 * the actual clock of the transmitter relative to the protocol's
+	 * nominal clock. 0 is returned if no value is available.
+	 */
+	static inline uint32_t receivedDataDuration() {return mReceiverDelegate.receivedDataDuration();}
+
+	/**
+	 * Return the sum of the nominal durations of the received data
+	 * pulses in microseconds, according to the best protocol. 0 is
+	 * returned if no value is available.
+	 */
+	static inline uint32_t bestProtocolDataDuration() {return mReceiverDelegate.bestProtocolDataDuration();}
+
 	/**
 	 * Clear the last received value in order to receive a new one.
 	 * Will also clear the received protocols that the last
@@ -146,6 +222,16 @@ public:
 	 */
 	static inline void resetAvailable() {mReceiverDelegate.resetAvailable();}
 
+	/**
+	 * Set a function to be called when a message packet becomes
+	 * available, nullptr for none. It is called from the interrupt
+	 * handler, hence it must be short and interrupt safe, e.g. give
+	 * a FreeRTOS task notification, so that the consumer can sleep
+	 * instead of polling available().
+	 */
+	static void setAvailableCallback(basicReceiver_t::availableCallback_t callback)
+		{mReceiverDelegate.setAvailableCallback(callback);}
+
 	/**
 	 * Suspend receiving new message packets.
 	 */
@@ -156,6 +242,86 @@ public:
 	 */
 	static void resume() {mReceiverDelegate.resume();}
 
+	/**
+	 * Begin a transmit window. Call this right before an own transmitter
+	 * starts sending. The pulses received during the window are regarded
+	 * as echo of the own transmission and are ignored. Unlike suspend(),
+	 * an available message packet is kept.
+	 * Can be called from interrupt context.
+	 */
+	static void beginTransmitWindow() {mReceiverDelegate.beginTransmitWindow();}
+
+	/**
+	 * End a transmit window. Call this right after an own transmitter
+	 * has finished sending. The receiver goes back to synch state with
+	 * the next pulse, hence it receives the next complete message packet.
+	 * Can be called from interrupt context.
+	 */
+	static void endTransmitWindow() {mReceiverDelegate.endTransmitWindow();}
+
+	/**
+	 * Let the decoder sleep, e.g. while the CPU is idle on a battery
+	 * powered device. The interrupt handler only buffers the received
+	 * edges then, which takes less time than decoding them. The first
+	 * pulse that can be a synchronization pulse requests the wake up
+	 * and calls the wake callback, e.g. to give a task notification.
+	 * Call wake() then, the buffered edges are decoded without losing
+	 * the synchronization pulse pair of the first message packet.
+	 */
+	static void sleep() {mEdgeCapture.start();}
+
+	/**
+	 * Set a function to be called from the interrupt handler, when a
+	 * pulse requests to wake up the sleeping decoder. nullptr for none.
+	 */
+	static void setWakeCallback(RcSwitch::EdgeCapture::wakeCallback_t callback)
+		{mEdgeCapture.setWakeCallback(callback);}
+
+	/**
+	 * Return true, if the sleeping decoder has been requested to wake up.
+	 */
+	static inline bool wakeRequested() {return mEdgeCapture.wakeRequested();}
+
+	/**
+	 * Decode the buffered edges and continue with the live edges. Without
+	 * a wake request, the buffered edges are dropped, they don't contain
+	 * a synchronization pulse. Does nothing, if the decoder is not asleep.
+	 */
+	static void wake() {
+		if(!mEdgeCapture.active()) {
+			return;
+		}
+		RcSwitch::CapturedEdge edge;
+		while(mEdgeCapture.pop(edge)) {
+			mReceiverDelegate.handleInterrupt(edge.pinLevel, edge.usec);
+		}
+		/* Edges pushed meanwhile must be decoded before the live ones. */
+		noInterrupts();
+		while(mEdgeCapture.pop(edge)) {
+			mReceiverDelegate.handleInterrupt(edge.pinLevel, edge.usec);
+		}
+		mEdgeCapture.stop(micros());
+		interrupts();
+	}
+
+	/**
+	 * Return the wake up statistics: wake latency and message packets
+	 * missed because the edge buffer was full.
+	 */
+	static inline const RcSwitch::EdgeCapture::Statistics& wakeStatistics()
+		{return mEdgeCapture.statistics();}
+
+	/**
+	 * Return the number of pulses that have been ignored during
+	 * transmit windows.
+	 */
+	static inline uint32_t selfEchoPulseCount() {return mReceiverDelegate.selfEchoPulseCount();}
+
+	/**
+	 * Return the number of transmit windows.
+	 */
+	static inline uint32_t transmitWindowCount() {return mReceiverDelegate.transmitWindowCount();}
+
 	/**
 	 * Dump the oldest to the youngest pulse as well as pulse statistics.
 	 */
@@ -193,4 +359,8 @@ private:
 template<int IOPIN, size_t PULSE_TRACES_COUNT> typename RcSwitchReceiver<IOPIN, PULSE_TRACES_COUNT>::receiver_t
 	RcSwitchReceiver<IOPIN, PULSE_TRACES_COUNT>::mReceiverDelegate;
 
+/** The edge buffer of the sleeping decoder for this IO pin. */
+template<int IOPIN, size_t PULSE_TRACES_COUNT> RcSwitch::EdgeCapture
+	RcSwitchReceiver<IOPIN, PULSE_TRACES_COUNT>::mEdgeCapture;
+
 #endif /* RCSWITCH_RECEIVER_API_HPP_ */
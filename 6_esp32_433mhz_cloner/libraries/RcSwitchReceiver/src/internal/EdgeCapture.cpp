@@ -0,0 +1,89 @@
+/*
+  RcSwitchReceiver - Arduino libary for remote control receiver Copyright (c)
+  2024 Wolfgang Schmieder.  All right reserved.
+
+  Contributors:
+  - Wolfgang Schmieder
+
+  Project home: https://github.com/dac1e/RcSwitchReceiver/
+
+  This library is free software; you can redistribute it and/or modify it
+  the terms of the GNU Lesser General Public License as under published
+  by the Free Software Foundation; either version 3.0 of the License,
+  or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+*/
+
+
+#include "EdgeCapture.hpp"
+#include "ProtocolTimingSpec.hpp"
+
+namespace RcSwitch {
+
+EdgeCapture::EdgeCapture()
+	: mPushCount(0), mPopCount(0), mActive(false), mWakeRequested(false)
+	, mHasLastEdge(false), mUsecLastEdge(0), mUsecWakeEdge(0), mUsecWakePulse(UINT32_MAX)
+	, mMissedPackets(0), mDroppedEdges(0), mWakeCallback(nullptr)
+	, mStatistics{0, 0, 0, 0, 0, 0} {
+}
+
+void EdgeCapture::setWakePulse(const RxTimingSpecTable& rxTimingSpecTable) {
+	uint32_t usecWakePulse = UINT32_MAX;
+	for(size_t i = 0; i < rxTimingSpecTable.size; i++) {
+		const RxPulsePairTimeRanges& synch = rxTimingSpecTable.start[i].synchronizationPulsePair;
+		const uint32_t usecLongPulse = synch.durationA.lowerBound > synch.durationB.lowerBound ?
+				synch.durationA.lowerBound : synch.durationB.lowerBound;
+		if(usecLongPulse < usecWakePulse) {
+			usecWakePulse = usecLongPulse;
+		}
+	}
+	mUsecWakePulse = usecWakePulse;
+}
+
+void EdgeCapture::start() {
+	mPushCount = 0;
+	mPopCount = 0;
+	mWakeRequested = false;
+	mHasLastEdge = false;
+	mMissedPackets = 0;
+	mDroppedEdges = 0;
+	/* Changing this flag must be the last action here, because the
+	 * interrupt handler starts to push with it. */
+	mActive = true;
+}
+
+bool EdgeCapture::pop(CapturedEdge& edge) {
+	if(!mWakeRequested || mPopCount == mPushCount) {
+		return false;
+	}
+	edge = mEdges[mPopCount % EDGE_CAPTURE_SIZE];
+	/* Free the slot after it has been read. */
+	mPopCount = mPopCount + 1;
+	return true;
+}
+
+void EdgeCapture::stop(const uint32_t usecNow) {
+	mActive = false;
+	if(mWakeRequested) {
+		const uint32_t usecLatency = usecNow - mUsecWakeEdge;
+		mStatistics.wakeCount++;
+		mStatistics.usecLastWakeLatency = usecLatency;
+		if(usecLatency > mStatistics.usecMaxWakeLatency) {
+			mStatistics.usecMaxWakeLatency = usecLatency;
+		}
+		mStatistics.lastWakeMissedPackets = mMissedPackets;
+		mStatistics.missedPackets += mMissedPackets;
+		mStatistics.droppedEdges += mDroppedEdges;
+	}
+	mWakeRequested = false;
+}
+
+} /* namespace RcSwitch */
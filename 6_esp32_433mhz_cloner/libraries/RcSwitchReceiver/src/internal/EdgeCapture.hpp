@@ -0,0 +1,193 @@
+/*
+  RcSwitchReceiver - Arduino libary for remote control receiver Copyright (c)
+  2024 Wolfgang Schmieder.  All right reserved.
+
+  Contributors:
+  - Wolfgang Schmieder
+
+  Project home: https://github.com/dac1e/RcSwitchReceiver/
+
+  This library is free software; you can redistribute it and/or modify it
+  the terms of the GNU Lesser General Public License as under published
+  by the Free Software Foundation; either version 3.0 of the License,
+  or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+*/
+
+
+#pragma once
+
+#ifndef RCSWITCH_RECEIVER_INTERNAL_EDGECAPTURE_HPP_
+#define RCSWITCH_RECEIVER_INTERNAL_EDGECAPTURE_HPP_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "ISR_ATTR.hpp"
+#include "RxTimingSpecTable.hpp"
+
+namespace RcSwitch {
+
+/**
+ * Number of edges the capture buffer can hold. Must be a power of 2.
+ * A message packet of 24 bits has 50 edges.
+ */
+constexpr size_t EDGE_CAPTURE_SIZE = 64;
+
+/**
+ * Number of edges kept before the edge that requested the wake up. The
+ * pulses ending with them complete the synchronization pulse pair.
+ */
+constexpr size_t EDGES_BEFORE_WAKE_EDGE = 2;
+
+struct CapturedEdge {
+	uint32_t usec;
+	int pinLevel;
+};
+
+/**
+ * Buffers the edges received while the decoder sleeps, so that the
+ * decoder can process them when it is woken up. Nothing received
+ * before the wake up gets lost, in particular not the synchronization
+ * pulse pair of the first message packet.
+ *
+ * While the decoder sleeps, the buffer keeps only the latest edges.
+ * The first pulse at least as long as the shortest synchronization
+ * pulse is the qualifying pulse: the edge ending it requests the wake
+ * up. From then on, edges are buffered until the decoder has caught up.
+ * Edges that don't fit into the buffer are dropped, and every qualifying
+ * pulse among them is counted as a missed message packet.
+ *
+ * push() is called from interrupt context, the other functions from the
+ * decoder's task. The buffer has a single producer and a single consumer,
+ * hence it needs no lock.
+ */
+class EdgeCapture {
+public:
+	/** Function to be called from interrupt context, when a wake up is requested. */
+	using wakeCallback_t = void (*)();
+
+	struct Statistics {
+		uint32_t wakeCount;
+		/* From the wake edge until the decoder caught up with the live edges. */
+		uint32_t usecLastWakeLatency;
+		uint32_t usecMaxWakeLatency;
+		/* Qualifying pulses dropped because the buffer was full. */
+		uint32_t lastWakeMissedPackets;
+		uint32_t missedPackets;
+		uint32_t droppedEdges;
+	};
+
+private:
+	CapturedEdge mEdges[EDGE_CAPTURE_SIZE];
+	/* Count of pushed and of popped edges, the difference is the fill level. */
+	volatile size_t mPushCount;
+	volatile size_t mPopCount;
+
+	volatile bool mActive;
+	volatile bool mWakeRequested;
+	bool mHasLastEdge;
+	uint32_t mUsecLastEdge;
+	uint32_t mUsecWakeEdge;
+	uint32_t mUsecWakePulse;
+	volatile uint32_t mMissedPackets;
+	volatile uint32_t mDroppedEdges;
+	wakeCallback_t mWakeCallback;
+
+	Statistics mStatistics;
+
+	TEXT_ISR_ATTR_2 void store(const int pinLevel, const uint32_t usec) {
+		CapturedEdge& edge = mEdges[mPushCount % EDGE_CAPTURE_SIZE];
+		edge.usec = usec;
+		edge.pinLevel = pinLevel;
+		/* Publish the edge after it has been written. */
+		mPushCount = mPushCount + 1;
+	}
+
+	static_assert((EDGE_CAPTURE_SIZE & (EDGE_CAPTURE_SIZE - 1)) == 0,
+			"Error: EDGE_CAPTURE_SIZE must be a power of 2.");
+
+public:
+	EdgeCapture();
+
+	/**
+	 * Set the duration of the qualifying pulse to the shortest
+	 * synchronization pulse of the protocols in the table. The longer
+	 * pulse of each synchronization pulse pair is considered.
+	 */
+	void setWakePulse(const RxTimingSpecTable& rxTimingSpecTable);
+	void setWakePulse(const uint32_t usecWakePulse) {mUsecWakePulse = usecWakePulse;}
+	inline uint32_t wakePulse() const {return mUsecWakePulse;}
+
+	void setWakeCallback(wakeCallback_t callback) {mWakeCallback = callback;}
+
+	/** Start buffering instead of decoding, the decoder goes to sleep. */
+	void start();
+
+	/**
+	 * Buffer an edge. Will only be called from within interrupt context.
+	 * Calls the wake callback, when the edge requests the wake up.
+	 */
+	TEXT_ISR_ATTR_1 void push(const int pinLevel, const uint32_t usec) {
+		const bool bQualifying = mHasLastEdge && usec - mUsecLastEdge >= mUsecWakePulse;
+		mHasLastEdge = true;
+		mUsecLastEdge = usec;
+
+		if(mWakeRequested) {
+			if(mPushCount - mPopCount >= EDGE_CAPTURE_SIZE) {
+				mDroppedEdges = mDroppedEdges + 1;
+				if(bQualifying) {
+					mMissedPackets = mMissedPackets + 1;
+				}
+				return;
+			}
+			store(pinLevel, usec);
+			return;
+		}
+
+		/* Asleep, nobody pops: drop the oldest edge. */
+		if(mPushCount - mPopCount >= EDGE_CAPTURE_SIZE) {
+			mPopCount = mPopCount + 1;
+		}
+		store(pinLevel, usec);
+		if(bQualifying) {
+			if(mPushCount - mPopCount > EDGES_BEFORE_WAKE_EDGE + 1) {
+				mPopCount = mPushCount - (EDGES_BEFORE_WAKE_EDGE + 1);
+			}
+			mUsecWakeEdge = usec;
+			mWakeRequested = true;
+			if(mWakeCallback) {
+				mWakeCallback();
+			}
+		}
+	}
+
+	/**
+	 * Take the oldest buffered edge once a wake up has been requested.
+	 * Returns false, if there is none.
+	 */
+	bool pop(CapturedEdge& edge);
+
+	/**
+	 * Stop buffering, the decoder processes the edges live again. Must be
+	 * called after all buffered edges have been popped, and with
+	 * interrupts disabled, so that no edge is pushed in between.
+	 */
+	void stop(const uint32_t usecNow);
+
+	inline bool active() const {return mActive;}
+	inline bool wakeRequested() const {return mWakeRequested;}
+	inline const Statistics& statistics() const {return mStatistics;}
+};
+
+} // namespace RcSwitch
+
+#endif /* RCSWITCH_RECEIVER_INTERNAL_EDGECAPTURE_HPP_ */
@@ -0,0 +1,195 @@
+/*
+  RcSwitchReceiver - Arduino libary for remote control receiver Copyright (c)
+  2024 Wolfgang Schmieder.  All right reserved.
+
+  Contributors:
+  - Wolfgang Schmieder
+
+  Project home: https://github.com/dac1e/RcSwitchReceiver/
+
+  This library is free software; you can redistribute it and/or modify it
+  the terms of the GNU Lesser General Public License as under published
+  by the Free Software Foundation; either version 3.0 of the License,
+  or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+*/
+
+
+
+#include "ProtocolTimingSpec.hpp"
+#include "RcSwitch.hpp"
+
+namespace RcSwitch {
+
+ManchesterDecoder::ManchesterDecoder()
+	: mUsecDataPulses(0), mOneLevel(PULSE_LEVEL::HI), mPendingHalfBit(PULSE_LEVEL::UNKNOWN) {
+}
+
+void ManchesterDecoder::reset() {
+	mProtocolCandidates.reset();
+	mMessagePacket.reset();
+	mUsecDataPulses = 0;
+	mPendingHalfBit = PULSE_LEVEL::UNKNOWN;
+}
+
+/**
+ * Collect the Manchester protocols whose synch pulses match. The first
+ * half bit of the message packet extends synch pulse B, if it has the
+ * same level. All candidates must agree on that.
+ */
+void ManchesterDecoder::collectProtocolCandidates(const RxTimingSpecTable& protocols,
+		const Pulse& pulseA, const Pulse& pulseB) {
+	bool bExtendedSynch = false;
+	for(size_t i = 0; i < protocols.size; i++) {
+		const RxTimingSpec& prot = protocols.start[i];
+		if(pulseA.getDuration() < prot.synchronizationPulsePair.durationA.lowerBound) {
+			/* Protocols are sorted in ascending order of synchronization
+			 * pulseA lower bound. */
+			break;
+		}
+		if(prot.lineCode != LINE_CODE::MANCHESTER
+				|| prot.synchronizationPulsePair.durationA.compare(pulseA.getDuration()) != TimeRange::IS_WITHIN) {
+			continue;
+		}
+		const TimeRange& halfBit = prot.data0pulsePair.durationA;
+		const TimeRange& synchB = prot.synchronizationPulsePair.durationB;
+		uint32_t usecSynchB = pulseB.getDuration();
+		bool bExtended = false;
+		if(synchB.compare(usecSynchB) != TimeRange::IS_WITHIN) {
+			if(usecSynchB <= halfBit.center()
+					|| synchB.compare(usecSynchB - halfBit.center()) != TimeRange::IS_WITHIN) {
+				continue;
+			}
+			usecSynchB -= halfBit.center();
+			bExtended = true;
+		}
+		if(mProtocolCandidates.size() == 0) {
+			bExtendedSynch = bExtended;
+		} else if(bExtended != bExtendedSynch) {
+			continue;
+		}
+		mProtocolCandidates.push(i, prot.synchronizationPulsePair.durationA.deviation(pulseA.getDuration())
+				+ synchB.deviation(usecSynchB));
+	}
+	if(mProtocolCandidates.size()) {
+		mOneLevel = pulseA.getLevel();
+		if(bExtendedSynch) {
+			mPendingHalfBit = pulseB.getLevel();
+			const RxTimingSpec& prot = protocols.start[mProtocolCandidates.at(0)];
+			mUsecDataPulses = prot.data0pulsePair.durationA.center();
+		}
+	}
+}
+
+/**
+ * Add a half bit. Every second one completes a data bit.
+ *
+ * Return false on a coding violation, i.e. no level change in the middle
+ * of a data bit.
+ */
+bool ManchesterDecoder::addHalfBit(const PULSE_LEVEL level) {
+	if(mPendingHalfBit == PULSE_LEVEL::UNKNOWN) {
+		mPendingHalfBit = level;
+		return true;
+	}
+	if(mPendingHalfBit == level) {
+		return false;
+	}
+	mMessagePacket.push(mPendingHalfBit == mOneLevel ? DATA_BIT::LOGICAL_1 : DATA_BIT::LOGICAL_0);
+	mPendingHalfBit = PULSE_LEVEL::UNKNOWN;
+	return true;
+}
+
+/**
+ * The pulse is no data pulse, it ends the message packet. The last
+ * half bit extends it, if it has the same level.
+ */
+ManchesterDecoder::RESULT ManchesterDecoder::finish(const RxTimingSpecTable& protocols, const Pulse& pulse) {
+	if(mPendingHalfBit != PULSE_LEVEL::UNKNOWN && mPendingHalfBit != pulse.getLevel()) {
+		addHalfBit(pulse.getLevel());
+		const RxTimingSpec& prot = protocols.start[mProtocolCandidates.at(0)];
+		mUsecDataPulses += prot.data0pulsePair.durationA.center();
+	}
+	if(mMessagePacket.size() >= MIN_MSG_PACKET_BITS) {
+		return COMPLETE;
+	}
+	reset();
+	return DECODING;
+}
+
+ManchesterDecoder::RESULT ManchesterDecoder::decode(const RxTimingSpecTable& normal,
+		const RxTimingSpecTable& inverse, const Pulse& pulse) {
+	const Pulse previousPulse = mPreviousPulse;
+	mPreviousPulse = pulse;
+
+	if(mProtocolCandidates.size()) {
+		const RxTimingSpecTable& protocols =
+				mProtocolCandidates.getProtocolGroup() == INVERSE_LEVEL_PROTOCOLS ? inverse : normal;
+		const uint32_t usecDuration = pulse.getDuration();
+
+		/* The number of half bits as the first matching candidate sees it. */
+		size_t halfBits = 0;
+		for(size_t i = 0; i < mProtocolCandidates.size() && halfBits == 0; i++) {
+			const RxTimingSpec& prot = protocols.start[mProtocolCandidates.at(i)];
+			if(prot.data0pulsePair.durationA.compare(usecDuration) == TimeRange::IS_WITHIN) {
+				halfBits = 1;
+			} else if(prot.data0pulsePair.durationB.compare(usecDuration) == TimeRange::IS_WITHIN) {
+				halfBits = 2;
+			}
+		}
+
+		if(halfBits) {
+			/* Drop the candidates that see it differently, rate the others. */
+			size_t i = mProtocolCandidates.size();
+			while(i > 0) {
+				--i;
+				const RxTimingSpec& prot = protocols.start[mProtocolCandidates.at(i)];
+				const TimeRange& range = halfBits == 1 ? prot.data0pulsePair.durationA : prot.data0pulsePair.durationB;
+				if(range.compare(usecDuration) == TimeRange::IS_WITHIN) {
+					mProtocolCandidates.rateDataPulse(i, range.center(), pulse.getLevel(), usecDuration);
+				} else {
+					mProtocolCandidates.remove(i);
+				}
+			}
+			bool bValid = addHalfBit(pulse.getLevel());
+			if(bValid && halfBits == 2) {
+				bValid = addHalfBit(pulse.getLevel());
+			}
+			if(bValid) {
+				if(mMessagePacket.overflowCount() == 0) {
+					mUsecDataPulses += usecDuration;
+				}
+				return DECODING;
+			}
+		}
+
+		if(finish(protocols, pulse) == COMPLETE) {
+			return COMPLETE;
+		}
+	}
+
+	/* Synchronization phase */
+	if(previousPulse.getLevel() != pulse.getLevel()) {
+		if(previousPulse.getLevel() == PULSE_LEVEL::HI) {
+			mProtocolCandidates.setProtocolGroup(NORMAL_LEVEL_PROTOCOLS);
+			collectProtocolCandidates(normal, previousPulse, pulse);
+		} else if(previousPulse.getLevel() == PULSE_LEVEL::LO) {
+			mProtocolCandidates.setProtocolGroup(INVERSE_LEVEL_PROTOCOLS);
+			collectProtocolCandidates(inverse, previousPulse, pulse);
+		}
+		if(mProtocolCandidates.size() == 0) {
+			mProtocolCandidates.reset();
+		}
+	}
+	return DECODING;
+}
+
+} // namespace RcSwitch
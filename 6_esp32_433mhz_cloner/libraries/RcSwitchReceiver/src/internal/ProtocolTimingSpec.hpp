@@ -49,6 +49,20 @@ struct TimeRange {
 	};
 
 	COMPARE_RESULT compare(uint32_t value) const;
+
+	/**
+	 * Return the nominal duration. The tolerance is symmetric, hence
+	 * the nominal duration is in the middle of the range.
+	 */
+	inline unsigned int center() const {
+		return static_cast<unsigned int>((static_cast<uint32_t>(lowerBound) + upperBound) / 2);
+	}
+
+	/**
+	 * Return the absolute difference between value and the nominal
+	 * duration.
+	 */
+	uint32_t deviation(uint32_t value) const;
 };
 
 inline TimeRange::COMPARE_RESULT TimeRange::compare(uint32_t value) const {
@@ -57,17 +71,34 @@ inline TimeRange::COMPARE_RESULT TimeRange::compare(uint32_t value) const {
 	return IS_WITHIN;
 }
 
+inline uint32_t TimeRange::deviation(uint32_t value) const {
+	const uint32_t nominal = center();
+	return value < nominal ? nominal - value : value - nominal;
+}
+
 struct RxPulsePairTimeRanges {
 	TimeRange durationA;
 	TimeRange durationB;
 };
 
+/**
+ * How the data bits are coded into pulses.
+ */
+enum class LINE_CODE : uint8_t {
+	/* A pulse pair per data bit, e.g. pulse width or pulse distance coding. */
+	PULSE_PAIR = 0,
+	/* A level change in the middle of each data bit. data0pulsePair holds
+	 * the time ranges of a half bit and a full bit, data1pulsePair the same. */
+	MANCHESTER,
+};
+
 struct RxTimingSpec {
 	unsigned int   protocolNumber;
 	bool bInverseLevel;
 	RxPulsePairTimeRanges  synchronizationPulsePair;
 	RxPulsePairTimeRanges  data0pulsePair;
 	RxPulsePairTimeRanges  data1pulsePair;
+	LINE_CODE lineCode;
 };
 
 struct TxPulsePairTiming {
@@ -136,6 +167,7 @@ struct makeTimingSpec { // Calculate the timing specification from the protocol
 			/* LOGICAL_1 data bit pulses */
 			{uSecData1_A_lowerBound, uSecData1_A_upperBound}, {uSecData1_B_lowerBound, uSecData1_B_upperBound}
 		},
+		RcSwitch::LINE_CODE::PULSE_PAIR
 	};
 
 	template<typename T> struct IS_RX_LOWER {
@@ -145,6 +177,50 @@ struct makeTimingSpec { // Calculate the timing specification from the protocol
 };
 
 
+/**
+ * makeManchesterTimingSpec
+ */
+template<
+	unsigned int protocolNumber,
+	unsigned int usecClock,
+	unsigned percentTolerance,
+	unsigned int synchA,  unsigned int synchB,
+	bool inverseLevel>
+
+struct makeManchesterTimingSpec { // Calculate the timing specification from the protocol definition.
+	static constexpr unsigned int PROTOCOL_NUMBER = protocolNumber;
+	static constexpr bool INVERSE_LEVEL = inverseLevel;
+
+	static constexpr unsigned int uSecSynchA = usecClock * synchA;
+	static constexpr unsigned int uSecSynchB = usecClock * synchB;
+	static constexpr unsigned int usecSynchA_lowerBound = static_cast<uint32_t>(uSecSynchA) * (100-percentTolerance) / 100;
+	static constexpr unsigned int usecSynchA_upperBound = static_cast<uint32_t>(uSecSynchA) * (100+percentTolerance) / 100;
+	static constexpr unsigned int usecSynchB_lowerBound = static_cast<uint32_t>(uSecSynchB) * (100-percentTolerance) / 100;
+	static constexpr unsigned int usecSynchB_upperBound = static_cast<uint32_t>(uSecSynchB) * (100+percentTolerance) / 100;
+
+	static constexpr unsigned int uSecHalfBit = usecClock;
+	static constexpr unsigned int uSecFullBit = 2 * usecClock;
+	static constexpr unsigned int uSecHalfBit_lowerBound = static_cast<uint32_t>(uSecHalfBit) * (100-percentTolerance) / 100;
+	static constexpr unsigned int uSecHalfBit_upperBound = static_cast<uint32_t>(uSecHalfBit) * (100+percentTolerance) / 100;
+	static constexpr unsigned int uSecFullBit_lowerBound = static_cast<uint32_t>(uSecFullBit) * (100-percentTolerance) / 100;
+	static constexpr unsigned int uSecFullBit_upperBound = static_cast<uint32_t>(uSecFullBit) * (100+percentTolerance) / 100;
+	static_assert(uSecHalfBit_upperBound <= uSecFullBit_lowerBound, "Tolerance too high to tell half and full bits apart.");
+
+	typedef RcSwitch::RxTimingSpec rx_spec_t;
+	static constexpr rx_spec_t RX = {PROTOCOL_NUMBER, INVERSE_LEVEL,
+		{	/* synch pulses */
+			{usecSynchA_lowerBound, usecSynchA_upperBound},     {usecSynchB_lowerBound, usecSynchB_upperBound}
+		},
+		{   /* half bit and full bit pulses */
+			{uSecHalfBit_lowerBound, uSecHalfBit_upperBound}, {uSecFullBit_lowerBound, uSecFullBit_upperBound}
+		},
+		{
+			{uSecHalfBit_lowerBound, uSecHalfBit_upperBound}, {uSecFullBit_lowerBound, uSecFullBit_upperBound}
+		},
+		RcSwitch::LINE_CODE::MANCHESTER
+	};
+};
+
 /**
  * RxProtocolTable
  */
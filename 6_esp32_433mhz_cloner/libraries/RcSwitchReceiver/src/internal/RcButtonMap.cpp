@@ -0,0 +1,79 @@
+/*
+  RcSwitchReceiver - Arduino libary for remote control receiver Copyright (c)
+  2024 Wolfgang Schmieder.  All right reserved.
+
+  Contributors:
+  - Wolfgang Schmieder
+
+  Project home: https://github.com/dac1e/RcSwitchReceiver/
+
+  This library is free software; you can redistribute it and/or modify it
+  the terms of the GNU Lesser General Public License as under published
+  by the Free Software Foundation; either version 3.0 of the License,
+  or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+*/
+
+
+#include "../RcButtonMap.hpp"
+
+size_t RcButtonMap::lowerBound(const int protocol, const receivedValue_t value) const {
+	const Entry key = {protocol, value, NO_BUTTON};
+	size_t first = 0;
+	size_t count = mSize;
+	while(count > 0) {
+		const size_t half = count / 2;
+		if(less(mEntries[first + half], key)) {
+			first += half + 1;
+			count -= half + 1;
+		} else {
+			count = half;
+		}
+	}
+	return first;
+}
+
+RcButtonMap::rcButtonCode_t RcButtonMap::find(const int protocol, const receivedValue_t value) const {
+	const size_t i = lowerBound(protocol, value);
+	if(i < mSize && mEntries[i].value == value && mEntries[i].protocol == protocol) {
+		return mEntries[i].buttonCode;
+	}
+	return NO_BUTTON;
+}
+
+bool RcButtonMap::insert(Entry* entries, const size_t capacity, const Entry& entry) {
+	const size_t i = lowerBound(entry.protocol, entry.value);
+	if(i < mSize && entries[i].value == entry.value && entries[i].protocol == entry.protocol) {
+		entries[i].buttonCode = entry.buttonCode;
+		return true;
+	}
+	if(mSize >= capacity) {
+		return false;
+	}
+	for(size_t j = mSize; j > i; j--) {
+		entries[j] = entries[j - 1];
+	}
+	entries[i] = entry;
+	mSize++;
+	return true;
+}
+
+bool RcButtonMap::remove(Entry* entries, const int protocol, const receivedValue_t value) {
+	const size_t i = lowerBound(protocol, value);
+	if(i >= mSize || entries[i].value != value || entries[i].protocol != protocol) {
+		return false;
+	}
+	for(size_t j = i + 1; j < mSize; j++) {
+		entries[j - 1] = entries[j];
+	}
+	mSize--;
+	return true;
+}
@@ -41,7 +41,8 @@ RcButtonPressDetector::rcButtonCode_t RcButtonPressDetector::testRcButtonData()
 			if(rcProtocol < 0) {
 				break;
 			}
-			const rcButtonCode_t rcButtonCode = rcDataToButton(rcProtocol, rcButtonValue);
+			const rcButtonCode_t rcButtonCode = mButtonMap ?
+					mButtonMap->find(rcProtocol, rcButtonValue) : rcDataToButton(rcProtocol, rcButtonValue);
 			if(rcButtonCode != RcButtonPressDetector::NO_BUTTON) {
 				result = rcButtonCode;
 				break;
@@ -60,68 +61,124 @@ RcButtonPressDetector::rcButtonCode_t RcButtonPressDetector::rcDataToButton(
 
 RcButtonPressDetector::RcButtonPressDetector(unsigned int msecDebounceDelayTime)
 	: mDebounceDelayTime(msecDebounceDelayTime)
+	, mHoldTime(0)
+	, mRepeatInterval(0)
 	, mRcSwitchReceiver(nullptr)
-	, mLastPressedButton(NO_BUTTON)
-	, mOffDelayStartTime(0)
+	, mButtonMap(nullptr)
 {
+	for (ActiveButton& activeButton : mActiveButtons) {
+		activeButton.buttonCode = NO_BUTTON;
+	}
+}
+
+size_t RcButtonPressDetector::activeButtonCount() const {
+	size_t count = 0;
+	for (const ActiveButton& activeButton : mActiveButtons) {
+		if (activeButton.buttonCode != NO_BUTTON) {
+			++count;
+		}
+	}
+	return count;
+}
+
+bool RcButtonPressDetector::isPressed(rcButtonCode_t buttonCode) const {
+	for (const ActiveButton& activeButton : mActiveButtons) {
+		if (buttonCode != NO_BUTTON && activeButton.buttonCode == buttonCode) {
+			return true;
+		}
+	}
+	return false;
+}
+
+uint32_t RcButtonPressDetector::msecScanTimeout() const {
+	return msecScanTimeout(millis());
+}
+
+uint32_t RcButtonPressDetector::msecScanTimeout(uint32_t msecNow) const {
+	// Only the releases need a scan without a packet, the hold and repeat
+	// events are signaled on the packets of the held button.
+	uint32_t timeout = NO_SCAN_TIMEOUT;
+	for (const ActiveButton& activeButton : mActiveButtons) {
+		if (activeButton.buttonCode == NO_BUTTON) {
+			continue;
+		}
+		const uint32_t elapsed = msecNow - activeButton.msecLastSeen;
+		const uint32_t remaining = elapsed > mDebounceDelayTime ? 0 : mDebounceDelayTime - elapsed + 1;
+		if (remaining < timeout) {
+			timeout = remaining;
+		}
+	}
+	return timeout;
 }
 
 void RcButtonPressDetector::scanRcButtons() {
+	scanRcButtons(millis());
+}
+
+void RcButtonPressDetector::scanRcButtons(uint32_t msecNow) {
 	const rcButtonCode_t button = testRcButtonData();
-	switch (mRcButtonState) {
-		case STATE::OFF: {
-			if (button != NO_BUTTON) {
-				// Button pressed, signal it.
-				onButtonPressed(button);
-				mLastPressedButton = button;
-				// Move to ON state
-				mRcButtonState = STATE::ON;
-			}
-			break;
+
+	// Release all buttons without a packet for the debounce delay time.
+	// A button pressed again afterwards is signaled again.
+	ActiveButton* oldestButton = nullptr;
+	ActiveButton* freeSlot = nullptr;
+	ActiveButton* pressedButton = nullptr;
+	for (ActiveButton& activeButton : mActiveButtons) {
+		if (activeButton.buttonCode != NO_BUTTON
+				&& (msecNow - activeButton.msecLastSeen) > mDebounceDelayTime) {
+			const rcButtonCode_t releasedButton = activeButton.buttonCode;
+			activeButton.buttonCode = NO_BUTTON;
+			onButtonReleased(releasedButton);
 		}
-		case STATE::ON: {
-			if (button != NO_BUTTON) {
-				// Button still pressed
-				if (button != mLastPressedButton) {
-					// It is a different button, signal it.
-					onButtonPressed(button);
-					mLastPressedButton = button;
-				}
-				// Stay in ON state.
-			} else {
-				// Button released. Record release time and move to off delay state.
-				mOffDelayStartTime = millis();
-				mRcButtonState = STATE::OFF_DELAY;
+		if (activeButton.buttonCode == NO_BUTTON) {
+			if (freeSlot == nullptr) {
+				freeSlot = &activeButton;
 			}
-			break;
+		} else if (activeButton.buttonCode == button) {
+			pressedButton = &activeButton;
+		} else if (oldestButton == nullptr
+				|| (msecNow - activeButton.msecLastSeen) > (msecNow - oldestButton->msecLastSeen)) {
+			oldestButton = &activeButton;
 		}
-		case STATE::OFF_DELAY: {
-			if (button != NO_BUTTON) {
-				// Button pressed again while in OFF_DELAY state.
-				if (button != mLastPressedButton) {
-					// It is a different button, signal it
-					onButtonPressed(button);
-					mLastPressedButton = button;
-				} else {
-					const uint32_t time = millis();
-					if ((time - mOffDelayStartTime) > mDebounceDelayTime) {
-						// The same button was pressed again after off
-						// delay has expired, signal it.
-						onButtonPressed(button);
-					}
-				}
-				// Either a different button was pressed, or the same button
-				// was pressed after off delay time expired. Move to ON state.
-				mRcButtonState = STATE::ON;
-			} else {
-				// All buttons still released in OFF delay state.
-				const uint32_t time = millis();
-				if ((time - mOffDelayStartTime) > mDebounceDelayTime) {
-					// Off delay time expired, move to OFF state.
-					mRcButtonState = STATE::OFF;
-				}
-			}
-			break;
+	}
+	if (button == NO_BUTTON) {
+		return;
+	}
+
+	if (pressedButton == nullptr) {
+		// Newly pressed button, signal it. If all slots are in use, the
+		// button seen longest ago is most likely released already.
+		if (freeSlot == nullptr) {
+			freeSlot = oldestButton;
+			const rcButtonCode_t releasedButton = freeSlot->buttonCode;
+			freeSlot->buttonCode = NO_BUTTON;
+			onButtonReleased(releasedButton);
 		}
+		freeSlot->buttonCode = button;
+		freeSlot->msecPressed = msecNow;
+		freeSlot->msecLastSeen = msecNow;
+		freeSlot->msecNextEvent = msecNow + mHoldTime;
+		freeSlot->repeatCount = 0;
+		onButtonPressed(button);
+		return;
+	}
+
+	// Button still held down. Signal hold and repeat events only on its
+	// packets, so a released button never signals them while its release
+	// timeout runs.
+	pressedButton->msecLastSeen = msecNow;
+	if (mHoldTime == 0 || (pressedButton->repeatCount > 0 && mRepeatInterval == 0)) {
+		return;
+	}
+	if (static_cast<int32_t>(msecNow - pressedButton->msecNextEvent) < 0) {
+		return;
+	}
+	if (pressedButton->repeatCount == 0) {
+		onButtonHeld(button);
+	} else {
+		onButtonRepeated(button, pressedButton->repeatCount);
 	}
+	++pressedButton->repeatCount;
+	// A late scan signals one event, no burst to catch up.
+	pressedButton->msecNextEvent = msecNow + mRepeatInterval;
 }
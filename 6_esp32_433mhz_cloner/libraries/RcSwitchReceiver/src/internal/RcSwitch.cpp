@@ -48,21 +48,6 @@ static TEXT_ISR_ATTR_2 PulseTypes pulseAtoPulseTypes(const RxTimingSpec& protoco
 			result.mPulseTypeSynch = PULSE_TYPE::SYNCH_FIRST_PULSE;
 		}
 	}
-
-	{
-		const TimeRange::COMPARE_RESULT log0Compare =
-				protocol.data0pulsePair.durationA.compare(pulse.getDuration());
-
-		if (log0Compare == TimeRange::IS_WITHIN) {
-			result.mPulseTypeData = PULSE_TYPE::DATA_LOGICAL_00;
-		} else {
-			const TimeRange::COMPARE_RESULT log1Compare =
-					protocol.data1pulsePair.durationA.compare(pulse.getDuration());
-			if (log1Compare == TimeRange::IS_WITHIN) {
-				result.mPulseTypeData = PULSE_TYPE::DATA_LOGICAL_01;
-			}
-		}
-	}
 	return result;
 }
 
@@ -77,23 +62,45 @@ static PulseTypes TEXT_ISR_ATTR_2 pulseBtoPulseTypes(const RxTimingSpec& protoco
 			result.mPulseTypeSynch = PULSE_TYPE::SYNCH_SECOND_PULSE;
 		}
 	}
+	return result;
+}
 
-	{
-		const TimeRange::COMPARE_RESULT log0Compare =
-				protocol.data0pulsePair.durationB.compare(pulse.getDuration());
-
-		if (log0Compare == TimeRange::IS_WITHIN) {
-			result.mPulseTypeData = PULSE_TYPE::DATA_LOGICAL_00;
-		} else {
-			const TimeRange::COMPARE_RESULT log1Compare =
-					protocol.data1pulsePair.durationB.compare(
-					pulse.getDuration());
-			if (log1Compare == TimeRange::IS_WITHIN) {
-				result.mPulseTypeData = PULSE_TYPE::DATA_LOGICAL_01;
-			}
-		}
+/**
+ * Data pulses must be checked as a pair. Some protocols use the same
+ * pulse A duration or the same pulse B duration for a logical 0 and a
+ * logical 1 (e.g. Conrad RS-200).
+ */
+static TEXT_ISR_ATTR_2 PULSE_TYPE dataPulsePairType(const RxTimingSpec& protocol,
+		const Pulse &pulseA, const Pulse &pulseB) {
+	if(protocol.data0pulsePair.durationA.compare(pulseA.getDuration()) == TimeRange::IS_WITHIN
+			&& protocol.data0pulsePair.durationB.compare(pulseB.getDuration()) == TimeRange::IS_WITHIN) {
+		return PULSE_TYPE::DATA_LOGICAL_00;
 	}
-	return result;
+	if(protocol.data1pulsePair.durationA.compare(pulseA.getDuration()) == TimeRange::IS_WITHIN
+			&& protocol.data1pulsePair.durationB.compare(pulseB.getDuration()) == TimeRange::IS_WITHIN) {
+		return PULSE_TYPE::DATA_LOGICAL_01;
+	}
+	return PULSE_TYPE::UNKNOWN;
+}
+
+/**
+ * A data pulse A followed by a pause longer than the synch pulse pair,
+ * e.g. the guard time after the last data bit. The pulse pair is no data
+ * bit, hence the last data bit is lost.
+ */
+static TEXT_ISR_ATTR_2 bool isPauseAfterDataPulse(const RxTimingSpec& protocol,
+		const Pulse &pulseA, const Pulse &pulseB) {
+	const uint32_t usecSynch = static_cast<uint32_t>(protocol.synchronizationPulsePair.durationA.upperBound)
+			+ protocol.synchronizationPulsePair.durationB.upperBound;
+	return pulseB.getDuration() >= usecSynch
+			&& (protocol.data0pulsePair.durationA.compare(pulseA.getDuration()) == TimeRange::IS_WITHIN
+			|| protocol.data1pulsePair.durationA.compare(pulseA.getDuration()) == TimeRange::IS_WITHIN);
+}
+
+static TEXT_ISR_ATTR_2_INLINE uint32_t pulsePairTimingError(const RxPulsePairTimeRanges& timeRanges,
+		const Pulse&  pulseA, const Pulse&  pulseB) {
+	return timeRanges.durationA.deviation(pulseA.getDuration())
+			+ timeRanges.durationB.deviation(pulseB.getDuration());
 }
 
 static TEXT_ISR_ATTR_2_INLINE void collectProtocolCandidates(const RxTimingSpecTable& protocol,
@@ -110,19 +117,60 @@ static TEXT_ISR_ATTR_2_INLINE void collectProtocolCandidates(const RxTimingSpecT
 			return;
 		}
 
+		if(prot.lineCode != LINE_CODE::PULSE_PAIR) {
+			/* Decoded by the ManchesterDecoder */
+			continue;
+		}
+
 		if(pulseA.getDuration() <
 				prot.synchronizationPulsePair.durationA.upperBound) {
 			if(pulseB.getDuration() >=
 					prot.synchronizationPulsePair.durationB.lowerBound) {
 				if(pulseB.getDuration() <
 						prot.synchronizationPulsePair.durationB.upperBound) {
-					protocolCandidates.push(i);
+					protocolCandidates.push(i,
+							pulsePairTimingError(prot.synchronizationPulsePair, pulseA, pulseB));
 				}
 			}
 		}
 	}
 }
 
+// ======== ProtocolCandidates =========
+size_t ProtocolCandidates::bestCandidateIndex() const {
+	RCSWITCH_ASSERT(size() > 0);
+	size_t result = 0;
+	for(size_t i = 1; i < size(); i++) {
+		if(mUsecTimingError[i] < mUsecTimingError[result]) {
+			result = i;
+		}
+	}
+	return result;
+}
+
+uint32_t ProtocolCandidates::jitterChanges(const size_t index) const {
+	/* The first data pulse of each class has nothing to compare with. */
+	uint32_t changes = 0;
+	for(size_t level = 0; level < 2; level++) {
+		for(size_t pulseClass = 0; pulseClass < PULSE_CLASSES_PER_LEVEL; pulseClass++) {
+			if(mDataPulses[index][level][pulseClass] > 1) {
+				changes += mDataPulses[index][level][pulseClass] - 1;
+			}
+		}
+	}
+	return changes;
+}
+
+uint32_t ProtocolCandidates::jitter(const size_t index) const {
+	const uint32_t changes = jitterChanges(index);
+	return changes ? mUsecJitter[index] / changes : 0;
+}
+
+uint32_t ProtocolCandidates::jitterPercent(const size_t index) const {
+	const uint32_t changes = jitterChanges(index);
+	return changes ? (mJitterPermille[index] / changes + 5) / 10 : 0;
+}
+
 // ======== Receiver ===================
 unsigned int Receiver::getProtcolNumber(const size_t protocolCandidateIndex) const {
 	 const RxTimingSpecTable& protocol = getRxTimingTable(mProtocolCandidates.getProtocolGroup());
@@ -168,13 +216,26 @@ PULSE_TYPE Receiver::analyzePulsePair(const Pulse& pulseA, const Pulse& pulseB)
 			/* The pulses match the protocol for synch pulses. */
 			return PULSE_TYPE::SYCH_PULSE;
 		}
+		if(isPauseAfterDataPulse(protocol, pulseA, pulseB)) {
+			/* The guard time of a protocol that sends the synch in front of
+			 * the data. It ends the message packet like a synch. */
+			return PULSE_TYPE::SYCH_PULSE;
+		}
 
-		if(pulseTypesPulseB.mPulseTypeData == pulseTypesPulseA.mPulseTypeData
-				&& pulseTypesPulseB.mPulseTypeData !=  PULSE_TYPE::UNKNOWN) {
+		const PULSE_TYPE dataPulseType = dataPulsePairType(protocol, pulseA, pulseB);
+		if(dataPulseType != PULSE_TYPE::UNKNOWN) {
 			/* The pulses match the protocol for data pulses */
 			if(result == PULSE_TYPE::UNKNOWN) { /* keep the first match */
-				result = pulseTypesPulseB.mPulseTypeData;
+				result = dataPulseType;
 			}
+			/* Rate how well the pulses match this protocol. */
+			const RxPulsePairTimeRanges& dataPulsePair =
+					dataPulseType == PULSE_TYPE::DATA_LOGICAL_00 ?
+							protocol.data0pulsePair : protocol.data1pulsePair;
+			mProtocolCandidates.rateDataPulse(protocolCandidatesIndex, dataPulsePair.durationA.center(),
+					pulseA.getLevel(), pulseA.getDuration());
+			mProtocolCandidates.rateDataPulse(protocolCandidatesIndex, dataPulsePair.durationB.center(),
+					pulseB.getLevel(), pulseB.getDuration());
 		} else {
 			// The pulses do not match the protocol
 			mProtocolCandidates.remove(protocolCandidatesIndex);
@@ -184,10 +245,31 @@ PULSE_TYPE Receiver::analyzePulsePair(const Pulse& pulseA, const Pulse& pulseB)
 }
 
 void Receiver::handleInterrupt(const int pinLevel, const uint32_t uescInterruptEntry) {
-	if(!mSuspended) {
+	if(mTransmitWindow) {
+		/* The pulse has been caused by our own transmitter. Ignore it, but
+		 * keep track of the time, so that the first pulse after the transmit
+		 * window gets a proper duration. */
+		mSelfEchoPulseCount++;
+	} else if(!mSuspended) {
+		if(mResynchronize) {
+			mResynchronize = false;
+			resynchronize();
+		}
+
 		const uint32_t usecDuration = uescInterruptEntry - mUsecLastInterrupt;
 		push(usecDuration, pinLevel);
 
+		if(mManchesterProtocolCount && !mMessageAvailable) {
+			/* Decode Manchester protocols in parallel on the same pulse. */
+			if(mManchesterDecoder.decode(mRxTimingSpecTableNormal, mRxTimingSpecTableInverse, at(size()-1))
+					== ManchesterDecoder::COMPLETE) {
+				mProtocolCandidates = mManchesterDecoder.protocolCandidates();
+				mReceivedMessagePacket = mManchesterDecoder.messagePacket();
+				mUsecDataPulses = mManchesterDecoder.usecDataPulses();
+				setAvailable();
+			}
+		}
+
 		switch(state()) {
 			case SYNC_STATE:
 				if(size() > 1) {
@@ -218,7 +300,7 @@ void Receiver::handleInterrupt(const int pinLevel, const uint32_t uescInterruptE
 							/* The 2 pulses are a new sync start, we are finished
 							 * with the current message package */
 							if(mReceivedMessagePacket.size() >= MIN_MSG_PACKET_BITS) {
-								mMessageAvailable = true;
+								setAvailable();
 							} else {
 								/* Insufficient number of bits received, hence start from
 								 * scratch. Current pulses might be the synch start, but
@@ -235,6 +317,9 @@ void Receiver::handleInterrupt(const int pinLevel, const uint32_t uescInterruptE
 							const DATA_BIT dataBit = pulseType == PULSE_TYPE::DATA_LOGICAL_00 ?
 											DATA_BIT::LOGICAL_0 : DATA_BIT::LOGICAL_1;
 							mReceivedMessagePacket.push(dataBit);
+							if(mReceivedMessagePacket.overflowCount() == 0) {
+								mUsecDataPulses += pulseA.getDuration() + pulseB.getDuration();
+							}
 						}
 					}
 				}
@@ -262,12 +347,33 @@ Receiver::STATE Receiver::state() const {
 
 void Receiver::retry() {
 	mReceivedMessagePacket.reset();
+	mUsecDataPulses = 0;
 	baseClass::reset();
 }
 
+void Receiver::resynchronize() {
+	/* Pulses received before the transmit window can't be continued.
+	 * Go back to synch state, but keep an available message packet. */
+	mDataModePulseCount = 0;
+	if(!mMessageAvailable) {
+		mProtocolCandidates.reset();
+		mManchesterDecoder.reset();
+		retry();
+	}
+}
+
+void Receiver::setAvailable() {
+	mMessageAvailable = true;
+	if(mAvailableCallback) {
+		mAvailableCallback();
+	}
+}
+
 void Receiver::reset() {
 	mProtocolCandidates.reset();
+	mManchesterDecoder.reset();
 	mReceivedMessagePacket.reset();
+	mUsecDataPulses = 0;
 	baseClass::reset();
 	/* Changing this flag must be the last action here,
 	 * because it will change the state. That must not
@@ -286,6 +392,13 @@ unsigned int Receiver::receivedBitsCount() const {
 	return 0;
 }
 
+receivedValue_t Receiver::receivedOverflowValue() const {
+	if(available()) {
+		return mReceivedMessagePacket.overflowValue();
+	}
+	return 0;
+}
+
 receivedValue_t Receiver::receivedValue() const {
 	receivedValue_t result = 0;
 	if(available()) {
@@ -308,6 +421,75 @@ int Receiver::receivedProtocol(const size_t index) const {
 	return -1;
 }
 
+int Receiver::bestProtocol() const {
+	if(available() && mProtocolCandidates.size()) {
+		return getProtcolNumber(mProtocolCandidates.bestCandidateIndex());
+	}
+	return -1;
+}
+
+uint32_t Receiver::bestProtocolTimingError() const {
+	if(available() && mProtocolCandidates.size()) {
+		const size_t index = mProtocolCandidates.bestCandidateIndex();
+		return mProtocolCandidates.timingError(index) / mProtocolCandidates.ratedPulses(index);
+	}
+	return 0;
+}
+
+uint32_t Receiver::bestProtocolMaxDeviation() const {
+	if(available() && mProtocolCandidates.size()) {
+		return mProtocolCandidates.maxDeviation(mProtocolCandidates.bestCandidateIndex());
+	}
+	return 0;
+}
+
+uint32_t Receiver::bestProtocolJitter() const {
+	if(available() && mProtocolCandidates.size()) {
+		return mProtocolCandidates.jitter(mProtocolCandidates.bestCandidateIndex());
+	}
+	return 0;
+}
+
+uint32_t Receiver::bestProtocolMaxDeviationPercent() const {
+	if(available() && mProtocolCandidates.size()) {
+		return mProtocolCandidates.maxDeviationPercent(mProtocolCandidates.bestCandidateIndex());
+	}
+	return 0;
+}
+
+uint32_t Receiver::bestProtocolJitterPercent() const {
+	if(available() && mProtocolCandidates.size()) {
+		return mProtocolCandidates.jitterPercent(mProtocolCandidates.bestCandidateIndex());
+	}
+	return 0;
+}
+
+uint32_t Receiver::receivedDataDuration() const {
+	if(available()) {
+		return mUsecDataPulses;
+	}
+	return 0;
+}
+
+uint32_t Receiver::bestProtocolDataDuration() const {
+	uint32_t result = 0;
+	if(available() && mProtocolCandidates.size()) {
+		const RxTimingSpecTable& protocols = getRxTimingTable(mProtocolCandidates.getProtocolGroup());
+		const RxTimingSpec& protocol = protocols.start[mProtocolCandidates.at(mProtocolCandidates.bestCandidateIndex())];
+		uint32_t usecData0 = protocol.data0pulsePair.durationA.center() + protocol.data0pulsePair.durationB.center();
+		uint32_t usecData1 = protocol.data1pulsePair.durationA.center() + protocol.data1pulsePair.durationB.center();
+		if(protocol.lineCode == LINE_CODE::MANCHESTER) {
+			/* Two half bits per data bit */
+			usecData0 = usecData1 = 2 * protocol.data0pulsePair.durationA.center();
+		}
+		const MessagePacket& messagePacket = mReceivedMessagePacket;
+		for(size_t i=0; i < messagePacket.size(); i++) {
+			result += messagePacket.at(i) == DATA_BIT::LOGICAL_1 ? usecData1 : usecData0;
+		}
+	}
+	return result;
+}
+
 RxTimingSpecTable Receiver::getRxTimingTable(PROTOCOL_GROUP_ID protocolGroup) const {
 	switch (protocolGroup) {
 	case PROTOCOL_GROUP_ID::NORMAL_LEVEL_PROTOCOLS:
@@ -336,6 +518,13 @@ void Receiver::setRxTimingSpecTable(const RxTimingSpecTable& rxTimingSpecTable)
 	mRxTimingSpecTableNormal.size = i;
 	mRxTimingSpecTableInverse.start = &rxTimingSpecTable.start[i];
 	mRxTimingSpecTableInverse.size = rxTimingSpecTable.size - i;
+
+	mManchesterProtocolCount = 0;
+	for (i = 0; i < rxTimingSpecTable.size; i++) {
+		if (rxTimingSpecTable.start[i].lineCode == LINE_CODE::MANCHESTER) {
+			mManchesterProtocolCount++;
+		}
+	}
 }
 
 } /* namespace RcSwitch */
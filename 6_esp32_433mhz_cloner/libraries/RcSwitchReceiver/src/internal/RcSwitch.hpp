@@ -109,10 +109,62 @@ typedef size_t PROTOCOL_CANDIDATE;
 /**
  * This container stores the all the protocols that match the
  * synchronization pulses during the synchronization phase.
+ * Along with each protocol candidate, the accumulated timing error
+ * is stored. That is the sum of the absolute differences between the
+ * received pulse durations and the nominal pulse durations of the
+ * candidate's protocol.
+ *
+ * For the data pulses, the largest deviation and the jitter are
+ * collected as well. The jitter is the change of the signed deviation
+ * from one data pulse to the next one of the same class, i.e. of the
+ * same level and nominal duration. Neither a receiver that lengthens
+ * all high pulses by the same amount nor a remote with a slow clock,
+ * which lengthens the long pulses more than the short ones, adds jitter.
+ *
+ * Both are collected in microseconds and relative to the nominal duration
+ * of each pulse. A long pulse deviates by more microseconds than a short
+ * one for the same clock error, hence only the relative values can be
+ * compared with a threshold.
  */
 class ProtocolCandidates : public StackBuffer<PROTOCOL_CANDIDATE, MAX_PROTOCOL_CANDIDATES> {
 	using baseClass = StackBuffer<PROTOCOL_CANDIDATE, MAX_PROTOCOL_CANDIDATES>;
 	PROTOCOL_GROUP_ID mProtocolGroupId;
+	uint32_t mUsecTimingError[MAX_PROTOCOL_CANDIDATES];
+	uint32_t mUsecMaxDeviation[MAX_PROTOCOL_CANDIDATES];
+	uint32_t mUsecJitter[MAX_PROTOCOL_CANDIDATES];
+	/* The same relative to the nominal duration of each pulse. */
+	uint8_t mMaxDeviationPercent[MAX_PROTOCOL_CANDIDATES];
+	uint32_t mJitterPermille[MAX_PROTOCOL_CANDIDATES];
+	/* Number of the rated pulses, the synch pulse pair included. */
+	uint16_t mRatedPulses[MAX_PROTOCOL_CANDIDATES];
+
+	/* A protocol has a short and a long data pulse of each level at most. */
+	static constexpr size_t PULSE_CLASSES_PER_LEVEL = 2;
+	/* Nominal duration of each pulse class, 0 for an unused class. */
+	unsigned int mUsecClassNominal[MAX_PROTOCOL_CANDIDATES][2][PULSE_CLASSES_PER_LEVEL];
+	/* Signed deviation of the last data pulse, per pulse class. */
+	int mUsecLastDeviation[MAX_PROTOCOL_CANDIDATES][2][PULSE_CLASSES_PER_LEVEL];
+	/* Number of the rated data pulses, per pulse class. */
+	uint16_t mDataPulses[MAX_PROTOCOL_CANDIDATES][2][PULSE_CLASSES_PER_LEVEL];
+
+	/* Number of the deviation changes summed up as jitter. */
+	uint32_t jitterChanges(const size_t index) const;
+
+	TEXT_ISR_ATTR_2 void move(const size_t to, const size_t from) {
+		mUsecTimingError[to] = mUsecTimingError[from];
+		mUsecMaxDeviation[to] = mUsecMaxDeviation[from];
+		mUsecJitter[to] = mUsecJitter[from];
+		mMaxDeviationPercent[to] = mMaxDeviationPercent[from];
+		mJitterPermille[to] = mJitterPermille[from];
+		mRatedPulses[to] = mRatedPulses[from];
+		for(size_t level = 0; level < 2; level++) {
+			for(size_t pulseClass = 0; pulseClass < PULSE_CLASSES_PER_LEVEL; pulseClass++) {
+				mUsecClassNominal[to][level][pulseClass] = mUsecClassNominal[from][level][pulseClass];
+				mUsecLastDeviation[to][level][pulseClass] = mUsecLastDeviation[from][level][pulseClass];
+				mDataPulses[to][level][pulseClass] = mDataPulses[from][level][pulseClass];
+			}
+		}
+	}
 
 public:
 	inline ProtocolCandidates() : mProtocolGroupId(UNKNOWN_PROTOCOL) {
@@ -122,9 +174,125 @@ public:
 	TEXT_ISR_ATTR_1_INLINE void reset();
 
 	/**
-	 * Push another protocol candidate onto the stack.
+	 * Push another protocol candidate along with its initial
+	 * timing error onto the stack.
+	 */
+	TEXT_ISR_ATTR_2 bool push(const PROTOCOL_CANDIDATE protocolCandidate, const uint32_t usecTimingError = 0) {
+		if(baseClass::canGrow()) {
+			const size_t index = baseClass::size();
+			mUsecTimingError[index] = usecTimingError;
+			mUsecMaxDeviation[index] = 0;
+			mUsecJitter[index] = 0;
+			mMaxDeviationPercent[index] = 0;
+			mJitterPermille[index] = 0;
+			mRatedPulses[index] = 2;
+			for(size_t level = 0; level < 2; level++) {
+				for(size_t pulseClass = 0; pulseClass < PULSE_CLASSES_PER_LEVEL; pulseClass++) {
+					mUsecClassNominal[index][level][pulseClass] = 0;
+					mDataPulses[index][level][pulseClass] = 0;
+				}
+			}
+		}
+		return baseClass::push(protocolCandidate);
+	}
+
+	/**
+	 * Remove the protocol candidate at the specified index
+	 * together with its timing error.
+	 */
+	TEXT_ISR_ATTR_2 void remove(const size_t index) {
+		for(size_t i = index+1; i < baseClass::size(); i++) {
+			move(i-1, i);
+		}
+		baseClass::remove(index);
+	}
+
+	/**
+	 * Rate a received data pulse for the protocol candidate at the
+	 * specified index: add its deviation from the nominal duration
+	 * to the timing error and to the statistics.
+	 */
+	TEXT_ISR_ATTR_2 void rateDataPulse(const size_t index, const unsigned int usecNominal,
+			const PULSE_LEVEL pulseLevel, const uint32_t usecDuration) {
+		const int usecDeviation = static_cast<int>(usecDuration) - static_cast<int>(usecNominal);
+		const uint32_t usecAbsDeviation = usecDeviation < 0 ? -usecDeviation : usecDeviation;
+		mUsecTimingError[index] += usecAbsDeviation;
+		if(usecAbsDeviation > mUsecMaxDeviation[index]) {
+			mUsecMaxDeviation[index] = usecAbsDeviation;
+		}
+		/* Within the tolerance of the protocol, hence below 100%. */
+		const uint32_t deviationPercent = 100 * usecAbsDeviation / usecNominal;
+		if(deviationPercent > mMaxDeviationPercent[index]) {
+			mMaxDeviationPercent[index] = deviationPercent > 255 ? 255 : deviationPercent;
+		}
+		mRatedPulses[index]++;
+
+		const size_t level = pulseLevel == PULSE_LEVEL::HI ? 0 : 1;
+		size_t pulseClass = 0;
+		while(mUsecClassNominal[index][level][pulseClass] != 0
+				&& mUsecClassNominal[index][level][pulseClass] != usecNominal) {
+			if(++pulseClass == PULSE_CLASSES_PER_LEVEL) {
+				return;	// a third nominal duration of this level adds no jitter
+			}
+		}
+		mUsecClassNominal[index][level][pulseClass] = usecNominal;
+		if(mDataPulses[index][level][pulseClass] > 0) {
+			const int usecChange = usecDeviation - mUsecLastDeviation[index][level][pulseClass];
+			const uint32_t usecAbsChange = usecChange < 0 ? -usecChange : usecChange;
+			mUsecJitter[index] += usecAbsChange;
+			mJitterPermille[index] += 1000 * usecAbsChange / usecNominal;
+		}
+		mUsecLastDeviation[index][level][pulseClass] = usecDeviation;
+		mDataPulses[index][level][pulseClass]++;
+	}
+
+	/** Return the accumulated timing error of the protocol candidate at the specified index. */
+	inline uint32_t timingError(const size_t index) const {
+		return mUsecTimingError[index];
+	}
+
+	/**
+	 * Return the number of pulses rated for the protocol candidate at the
+	 * specified index: the synch pulse pair and the rated data pulses.
+	 * Manchester coding rates a pulse per one or two half bits, hence it is
+	 * not a fixed number per data bit.
+	 */
+	inline uint32_t ratedPulses(const size_t index) const {
+		return mRatedPulses[index];
+	}
+
+	/** Return the largest deviation of a data pulse of the protocol candidate at the specified index. */
+	inline uint32_t maxDeviation(const size_t index) const {
+		return mUsecMaxDeviation[index];
+	}
+
+	/**
+	 * Return the largest deviation of a data pulse of the protocol candidate
+	 * at the specified index in percent of the pulse's nominal duration.
+	 */
+	inline uint32_t maxDeviationPercent(const size_t index) const {
+		return mMaxDeviationPercent[index];
+	}
+
+	/**
+	 * Return the average jitter of the data pulses of the protocol
+	 * candidate at the specified index, 0 if there are too few.
+	 */
+	uint32_t jitter(const size_t index) const;
+
+	/**
+	 * Return the same as jitter() in percent of the nominal duration of
+	 * each pulse, rounded.
+	 */
+	uint32_t jitterPercent(const size_t index) const;
+
+	/**
+	 * Return the index of the protocol candidate with the lowest
+	 * accumulated timing error. If several protocol candidates have
+	 * the same timing error, the one with the lowest index is
+	 * returned. Must not be called when the container is empty.
 	 */
-	using baseClass::push; // Just make the base class push() method public.
+	size_t bestCandidateIndex() const;
 
 	TEXT_ISR_ATTR_2 void setProtocolGroup(const PROTOCOL_GROUP_ID protocolGroup) {
 		mProtocolGroupId = protocolGroup;
@@ -137,20 +305,91 @@ public:
 /**
  * This container stores the received data bits of a single message packet.
  * If the transmitter sends more data bits than MAX_MSG_PACKET_BITS,
- * the overflow counter of this container will be incremented.
+ * the overflow counter of this container will be incremented. The first
+ * MAX_MSG_PACKET_BITS of the overflowing data bits are kept as a value,
+ * e.g. for the fixed part of a long rolling code frame.
  */
 class MessagePacket : public StackBuffer<DATA_BIT, MAX_MSG_PACKET_BITS> {
 	using baseClass = StackBuffer<DATA_BIT, MAX_MSG_PACKET_BITS>;
+	receivedValue_t mOverflowValue;
 
 public:
 	/** Default constructor */
-	inline MessagePacket() {}
+	inline MessagePacket() : mOverflowValue(0) {}
 
 	/**
 	 * Remove all data bits from this message packet container.
 	 */
-	// Make the base class reset() method public.
-	using baseClass::reset;
+	TEXT_ISR_ATTR_2 inline void reset() {baseClass::reset(); mOverflowValue = 0;}
+
+	/**
+	 * Push a data bit. If the container is full, shift it into
+	 * the overflow value instead.
+	 */
+	TEXT_ISR_ATTR_1 inline bool push(const DATA_BIT dataBit) {
+		if(baseClass::push(dataBit)) {
+			return true;
+		}
+		if(overflowCount() <= MAX_MSG_PACKET_BITS) {
+			mOverflowValue = (mOverflowValue << 1) | (dataBit == DATA_BIT::LOGICAL_1 ? 1 : 0);
+		}
+		return false;
+	}
+
+	/**
+	 * The overflowing data bits, the first one as the highest significant
+	 * bit of overflowCount() bits, at most MAX_MSG_PACKET_BITS.
+	 */
+	inline receivedValue_t overflowValue() const {return mOverflowValue;}
+};
+
+/**
+ * Decodes Manchester coded message packets. It runs in parallel to the
+ * pulse pair decoding of the receiver, on the same pulses, and collects
+ * its own protocol candidates from the Manchester protocols of the timing
+ * spec table. A pulse is a half or a full data bit long. The half bits are
+ * paired to data bits, a pair of equal levels is a coding violation.
+ */
+class ManchesterDecoder {
+	friend class RcSwitch_test;
+public:
+	enum RESULT {
+		DECODING,
+		/* A message packet has been received, until reset() is called. */
+		COMPLETE,
+	};
+
+private:
+	ProtocolCandidates mProtocolCandidates;
+	MessagePacket mMessagePacket;
+	uint32_t mUsecDataPulses;
+	Pulse mPreviousPulse;
+	/* The level of the first half of a logical 1. */
+	PULSE_LEVEL mOneLevel;
+	/* The first half of the current data bit, UNKNOWN at a bit boundary. */
+	PULSE_LEVEL mPendingHalfBit;
+
+	TEXT_ISR_ATTR_2 void collectProtocolCandidates(const RxTimingSpecTable& protocols,
+			const Pulse& pulseA, const Pulse& pulseB);
+	TEXT_ISR_ATTR_2 bool addHalfBit(const PULSE_LEVEL level);
+	TEXT_ISR_ATTR_2 RESULT finish(const RxTimingSpecTable& protocols, const Pulse& pulse);
+
+public:
+	ManchesterDecoder();
+
+	/** Remove the protocol candidates and all data bits. */
+	TEXT_ISR_ATTR_1 void reset();
+
+	/**
+	 * Evaluate a new pulse. 'normal' and 'inverse' are the timing spec
+	 * tables of the normal and the inverse level protocols.
+	 */
+	TEXT_ISR_ATTR_1 RESULT decode(const RxTimingSpecTable& normal, const RxTimingSpecTable& inverse,
+			const Pulse& pulse);
+
+	inline const ProtocolCandidates& protocolCandidates() const {return mProtocolCandidates;}
+	inline const MessagePacket& messagePacket() const {return mMessagePacket;}
+	inline uint32_t usecDataPulses() const {return mUsecDataPulses;}
 };
 
 /**
@@ -165,6 +404,10 @@ public:
  * is called.
  */
 class Receiver : public RingBuffer<Pulse, DATA_PULSES_PER_BIT> {
+public:
+	/** Function to be called from interrupt context, when a message packet is available. */
+	using availableCallback_t = void (*)();
+
 private:
 	/** =========================================================================== */
 	/** == Privately used types, enumerations, variables and methods ============== */
@@ -178,10 +421,24 @@ private:
 	RxTimingSpecTable mRxTimingSpecTableInverse;
 
 	MessagePacket mReceivedMessagePacket;
+	/* Sum of the durations of the data pulses stored in mReceivedMessagePacket */
+	uint32_t mUsecDataPulses;
 
 	volatile bool mMessageAvailable;
 	volatile bool mSuspended;
 
+	/* Pulses during a transmit window are caused by our own transmitter. */
+	volatile bool mTransmitWindow;
+	volatile bool mResynchronize;
+	volatile uint32_t mSelfEchoPulseCount;
+	uint32_t mTransmitWindowCount;
+
+	availableCallback_t mAvailableCallback;
+
+	/* Manchester protocols in the timing spec tables, 0 to skip the decoder. */
+	size_t mManchesterProtocolCount;
+	ManchesterDecoder mManchesterDecoder;
+
 	ProtocolCandidates mProtocolCandidates;
 	size_t mDataModePulseCount;
 
@@ -193,6 +450,8 @@ private:
 	TEXT_ISR_ATTR_1 void push(uint32_t usecDuration, const int pinLevel);
 	TEXT_ISR_ATTR_1 PULSE_TYPE analyzePulsePair(const Pulse& firstPulse, const Pulse& secondPulse);
 	TEXT_ISR_ATTR_1 void retry();
+	TEXT_ISR_ATTR_1 void resynchronize();
+	TEXT_ISR_ATTR_1 void setAvailable();
 
 protected:
 	uint32_t mUsecLastInterrupt;
@@ -211,7 +470,10 @@ protected:
 	 */
 	Receiver()
 		    : mRxTimingSpecTableNormal{nullptr, 0}, mRxTimingSpecTableInverse{nullptr, 0}
-		    , mMessageAvailable(false), mSuspended(false)
+		    , mUsecDataPulses(0), mMessageAvailable(false), mSuspended(false)
+		    , mTransmitWindow(false), mResynchronize(false)
+		    , mSelfEchoPulseCount(0), mTransmitWindowCount(0), mAvailableCallback(nullptr)
+		    , mManchesterProtocolCount(0)
 			, mDataModePulseCount(0), mUsecLastInterrupt(0)	{
 	}
 
@@ -237,12 +499,26 @@ public:
 	inline bool available() const {return state() == AVAILABLE_STATE;}
 	receivedValue_t receivedValue() const;
 	size_t receivedBitsCount() const;
+	receivedValue_t receivedOverflowValue() const;
 	inline size_t receivedProtocolCount() const {return mProtocolCandidates.size();}
 	int receivedProtocol(const size_t index) const;
+	int bestProtocol() const;
+	uint32_t bestProtocolTimingError() const;
+	uint32_t bestProtocolMaxDeviation() const;
+	uint32_t bestProtocolJitter() const;
+	uint32_t bestProtocolMaxDeviationPercent() const;
+	uint32_t bestProtocolJitterPercent() const;
+	uint32_t receivedDataDuration() const;
+	uint32_t bestProtocolDataDuration() const;
 	void suspend() {mSuspended = true;}
 	void resume() {if(mSuspended) {reset(); mSuspended=false;}}
+	void beginTransmitWindow() {mTransmitWindowCount++; mTransmitWindow = true;}
+	void endTransmitWindow() {if(mTransmitWindow) {mResynchronize = true; mTransmitWindow = false;}}
+	inline uint32_t selfEchoPulseCount() const {return mSelfEchoPulseCount;}
+	inline uint32_t transmitWindowCount() const {return mTransmitWindowCount;}
 	unsigned int getProtcolNumber(const size_t protocolCandidateIndex) const;
 	void resetAvailable() {if(available()) {reset();}}
+	void setAvailableCallback(availableCallback_t callback) {mAvailableCallback = callback;}
 
 };
 
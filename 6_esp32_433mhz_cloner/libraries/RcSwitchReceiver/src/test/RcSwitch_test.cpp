@@ -24,11 +24,15 @@
 
 #include "RcSwitch_test.hpp"
 #include "../ProtocolDefinition.hpp"
+#include "../RcButtonMap.hpp"
+#include "../RcButtonPressDetector.hpp"
+#include "../RcSwitchReceiver.hpp"
 
 #if ENABLE_RCSWITCH_TEST
 
 #include <limits.h>
 #include <assert.h>
+#include <string.h>
 
 namespace RcSwitch {
 
@@ -167,6 +171,28 @@ template<> struct PulseLength<1> {
 	static constexpr uint32_t firstPulseEndLevel  =     0;
 };
 
+template<> struct PulseLength<10> {
+	static constexpr uint32_t synchShortPulseLength =  1 * 270;
+	static constexpr uint32_t synchLongPulseLength  = 36 * 270;
+	static constexpr uint32_t dataShortPulseLength  =  1 * 270;
+	static constexpr uint32_t dataLongPulseLength   =  2 * 270;
+	/**
+	 * Inverse level protocol, the first pulse ends with a rising edge.
+	 */
+	static constexpr uint32_t firstPulseEndLevel  =     1;
+};
+
+template<> struct PulseLength<11> {
+	static constexpr uint32_t synchShortPulseLength =  1 * 320;
+	static constexpr uint32_t synchLongPulseLength  = 36 * 320;
+	static constexpr uint32_t dataShortPulseLength  =  1 * 320;
+	static constexpr uint32_t dataLongPulseLength   =  2 * 320;
+	/**
+	 * Inverse level protocol, the first pulse ends with a rising edge.
+	 */
+	static constexpr uint32_t firstPulseEndLevel  =     1;
+};
+
 void RcSwitch_test::sendDataPulse(uint32_t &usec, Receiver &receiver, const uint32_t firstPulse
 		, const uint32_t secondPulse, const uint32_t firstPulseEndLevel) {
 
@@ -235,15 +261,16 @@ template<unsigned int protocolNumber> struct Protocol {
 	}
 };
 
+template<unsigned int protocolNumber>
 void RcSwitch_test::sendMessagePacket(uint32_t &usec, Receiver &receiver
 		, const TxDataBit* const dataBits, const size_t count) const {
 
 	for(size_t i = 0; i < count; i++) {
-		Protocol<1>::sendSynchPulses(usec, receiver);
+		Protocol<protocolNumber>::sendSynchPulses(usec, receiver);
 
 		if(!receiver.available()) {
 			for(size_t j = 0; dataBits[j].mDataBit != DATA_BIT::UNKNOWN; j++) {
-				Protocol<1>::sendDataBit(usec, receiver, &dataBits[j]);
+				Protocol<protocolNumber>::sendDataBit(usec, receiver, &dataBits[j]);
 			}
 		}
 	}
@@ -306,6 +333,612 @@ void RcSwitch_test::testFaultyDataRx() const {
 	receiver.reset();
 }
 
+void RcSwitch_test::testBestProtocol() const {
+	Receiver receiver;
+	receiver.setRxTimingSpecTable(rxProtocolTable.toTimingSpecTable());
+	uint32_t usec = 0;
+
+	usec += 100; // start lo pulse 100 usec duration.
+	receiver.handleInterrupt(not PulseLength<11>::firstPulseEndLevel, usec);
+
+	assert(receiver.bestProtocol() == -1);						// Nothing received yet.
+
+	{ // Send with the timing of protocol #11. The pulses also match protocol #10.
+		sendMessagePacket<11>(usec, receiver, validMessagePacket_A, MIN_MSG_PACKET_REPEATS + 1);
+		assert(receiver.available());
+		assert(receiver.receivedValue() == 0x13 /* binary: 010011 */);
+		assert(receiver.receivedProtocolCount() == 2);			// Match protocol #10 and #11
+		assert(receiver.bestProtocol() == 11);
+		assert(receiver.bestProtocolTimingError() == 0);		// Nominal timing has been sent.
+		assert(receiver.receivedDataDuration() == receiver.bestProtocolDataDuration());
+		receiver.reset();
+	}
+
+	{ // Send with the timing of protocol #10. The pulses also match protocol #11.
+		sendMessagePacket<10>(usec, receiver, validMessagePacket_B, MIN_MSG_PACKET_REPEATS + 1);
+		assert(receiver.available());
+		assert(receiver.receivedValue() == 0x2C /* binary: 101100 */);
+		assert(receiver.receivedProtocolCount() == 2);			// Match protocol #10 and #11
+		assert(receiver.bestProtocol() == 10);
+		assert(receiver.bestProtocolTimingError() == 0);		// Nominal timing has been sent.
+		receiver.reset();
+	}
+
+	{ // Send protocol #1 with deviating pulses.
+		static const TxDataBit deviatingMessagePacket[] = {
+				{DATA_BIT::LOGICAL_0, 1.1, 1.0},
+				{DATA_BIT::LOGICAL_1},
+				{DATA_BIT::LOGICAL_0},
+				{DATA_BIT::LOGICAL_0},
+				{DATA_BIT::LOGICAL_1},
+				{DATA_BIT::LOGICAL_1, 1.0, 1.1},
+				// delimiter
+				{DATA_BIT::UNKNOWN},
+		};
+		usec += 100;
+		receiver.handleInterrupt(not PulseLength<1>::firstPulseEndLevel, usec);
+		sendMessagePacket(usec, receiver, deviatingMessagePacket, MIN_MSG_PACKET_REPEATS + 1);
+		assert(receiver.available());
+		assert(receiver.bestProtocol() == 1);
+		/* 35usec deviation for 2 pulses out of 14 rated pulses. */
+		assert(receiver.bestProtocolTimingError() == 2 * 35 / 14);
+		/* Pulse A of the first and pulse B of the last data bit are 35usec longer.
+		 * Each of the 4 pulse classes has 3 pulses and 2 changes, the short high
+		 * and the short low pulses change by 35usec once. */
+		assert(receiver.bestProtocolMaxDeviation() == 35);
+		assert(receiver.bestProtocolJitter() == 2 * 35 / 8);
+		/* 35usec are 10% of a short pulse, the 2 changes average 2.5%. */
+		assert(receiver.bestProtocolMaxDeviationPercent() == 10);
+		assert(receiver.bestProtocolJitterPercent() == 3);
+		/* 6 data bits of 4 * 350usec, 2 pulses 35usec longer. */
+		assert(receiver.bestProtocolDataDuration() == 6 * 4 * 350);
+		assert(receiver.receivedDataDuration() == 6 * 4 * 350 + 2 * 35);
+		receiver.reset();
+	}
+
+	{ // Send protocol #1 with a clock 10% slow: 385usec instead of 350usec.
+		static const TxDataBit slowMessagePacket[] = {
+				{DATA_BIT::LOGICAL_0, 1.1, 1.1}, {DATA_BIT::LOGICAL_1, 1.1, 1.1},
+				{DATA_BIT::LOGICAL_0, 1.1, 1.1}, {DATA_BIT::LOGICAL_1, 1.1, 1.1},
+				{DATA_BIT::LOGICAL_0, 1.1, 1.1}, {DATA_BIT::LOGICAL_1, 1.1, 1.1},
+				{DATA_BIT::LOGICAL_0, 1.1, 1.1}, {DATA_BIT::LOGICAL_1, 1.1, 1.1},
+				{DATA_BIT::LOGICAL_0, 1.1, 1.1}, {DATA_BIT::LOGICAL_1, 1.1, 1.1},
+				{DATA_BIT::LOGICAL_0, 1.1, 1.1}, {DATA_BIT::LOGICAL_1, 1.1, 1.1},
+				{DATA_BIT::LOGICAL_0, 1.1, 1.1}, {DATA_BIT::LOGICAL_1, 1.1, 1.1},
+				{DATA_BIT::LOGICAL_0, 1.1, 1.1}, {DATA_BIT::LOGICAL_1, 1.1, 1.1},
+				{DATA_BIT::LOGICAL_0, 1.1, 1.1}, {DATA_BIT::LOGICAL_1, 1.1, 1.1},
+				{DATA_BIT::LOGICAL_0, 1.1, 1.1}, {DATA_BIT::LOGICAL_1, 1.1, 1.1},
+				{DATA_BIT::LOGICAL_0, 1.1, 1.1}, {DATA_BIT::LOGICAL_1, 1.1, 1.1},
+				{DATA_BIT::LOGICAL_0, 1.1, 1.1}, {DATA_BIT::LOGICAL_1, 1.1, 1.1},
+				// delimiter
+				{DATA_BIT::UNKNOWN},
+		};
+		usec += 100;
+		receiver.handleInterrupt(not PulseLength<1>::firstPulseEndLevel, usec);
+		sendMessagePacket(usec, receiver, slowMessagePacket, MIN_MSG_PACKET_REPEATS + 1);
+		assert(receiver.available());
+		assert(receiver.receivedValue() == 0x555555 /* binary: 0101...01 */);
+		assert(receiver.bestProtocol() == 1);
+		/* The short and the long pulses alternate, they are 35usec and
+		 * 105usec longer. Within each pulse class they don't change. */
+		assert(receiver.bestProtocolMaxDeviation() == 3 * 35);
+		assert(receiver.bestProtocolJitter() == 0);
+		/* Relative to its own nominal duration each pulse is 10% longer. */
+		assert(receiver.bestProtocolMaxDeviationPercent() == 10);
+		assert(receiver.bestProtocolJitterPercent() == 0);
+		assert(receiver.receivedDataDuration() == 24 * 4 * 385);
+	}
+}
+
+void RcSwitch_test::testTransmitWindow() const {
+	Receiver receiver;
+	receiver.setRxTimingSpecTable(rxProtocolTable.toTimingSpecTable());
+	uint32_t usec = 0;
+
+	usec += 100; // start hi pulse 100 usec duration.
+	receiver.handleInterrupt(not PulseLength<1>::firstPulseEndLevel, usec);
+
+	{ // A transmit window interrupts the reception of a message packet.
+		sendMessagePacket(usec, receiver, invalidMessagePacket_tooLessMessagePackteBits, 1);
+		assert(receiver.state() == Receiver::DATA_STATE);
+
+		receiver.beginTransmitWindow();
+		for(size_t i = 0; i < 10; i++) { // Echo of the own transmission.
+			sendDataPulse(usec, receiver, 350, 1050, PulseLength<1>::firstPulseEndLevel);
+		}
+		assert(receiver.selfEchoPulseCount() == 20);
+		assert(receiver.state() == Receiver::DATA_STATE);		// Echo pulses have been ignored.
+		receiver.endTransmitWindow();
+
+		usec += 100;
+		receiver.handleInterrupt(not PulseLength<1>::firstPulseEndLevel, usec);
+		assert(receiver.state() == Receiver::SYNC_STATE);		// Back to synch state.
+
+		sendMessagePacket(usec, receiver, validMessagePacket_A, MIN_MSG_PACKET_REPEATS + 1);
+		assert(receiver.available());
+		assert(receiver.receivedValue() == 0x13 /* binary: 010011 */);
+	}
+
+	{ // A transmit window keeps an available message packet.
+		receiver.beginTransmitWindow();
+		for(size_t i = 0; i < 10; i++) { // Echo of the own transmission.
+			sendDataPulse(usec, receiver, 350, 1050, PulseLength<1>::firstPulseEndLevel);
+		}
+		receiver.endTransmitWindow();
+
+		usec += 100;
+		receiver.handleInterrupt(not PulseLength<1>::firstPulseEndLevel, usec);
+		assert(receiver.available());
+		assert(receiver.receivedValue() == 0x13 /* binary: 010011 */);
+		assert(receiver.selfEchoPulseCount() == 40);
+		assert(receiver.transmitWindowCount() == 2);
+	}
+}
+
+static size_t availableCallbackCount = 0;
+
+static void onAvailable() {
+	availableCallbackCount++;
+}
+
+void RcSwitch_test::testAvailableCallback() const {
+	Receiver receiver;
+	receiver.setRxTimingSpecTable(rxProtocolTable.toTimingSpecTable());
+	receiver.setAvailableCallback(&onAvailable);
+	availableCallbackCount = 0;
+	uint32_t usec = 0;
+
+	usec += 100; // start hi pulse 100 usec duration.
+	receiver.handleInterrupt(not PulseLength<1>::firstPulseEndLevel, usec);
+
+	{ // Called once, when the message packet becomes available.
+		sendMessagePacket(usec, receiver, validMessagePacket_A, MIN_MSG_PACKET_REPEATS + 1);
+		assert(receiver.available());
+		assert(availableCallbackCount == 1);
+		sendMessagePacket(usec, receiver, validMessagePacket_A, MIN_MSG_PACKET_REPEATS + 1);
+		assert(availableCallbackCount == 1);
+	}
+
+	{ // Called again for the next message packet.
+		receiver.resetAvailable();
+		sendMessagePacket(usec, receiver, validMessagePacket_B, MIN_MSG_PACKET_REPEATS + 1);
+		assert(receiver.available());
+		assert(availableCallbackCount == 2);
+	}
+
+	{ // Not called for faulty pulses.
+		receiver.resetAvailable();
+		sendMessagePacket(usec, receiver, invalidMessagePacket_firstPulseTooShort, 1);
+		assert(!receiver.available());
+		assert(availableCallbackCount == 2);
+	}
+}
+
+/**
+ * Send the edges of message packets of protocol #1 to a sink, either the
+ * edge capture of a sleeping decoder or the receiver. Returns the number
+ * of edges sent.
+ */
+template<typename SINK>
+static size_t sendCapturedMessagePackets(uint32_t& usec, SINK sink
+		, const TxDataBit* const dataBits, const size_t count) {
+	size_t edgeCount = 0;
+	auto sendPulsePair = [&](const uint32_t firstPulse, const uint32_t secondPulse) {
+		usec += firstPulse;
+		sink(PulseLength<1>::firstPulseEndLevel, usec);
+		usec += secondPulse;
+		sink(not PulseLength<1>::firstPulseEndLevel, usec);
+		edgeCount += 2;
+	};
+	for(size_t i = 0; i < count; i++) {
+		sendPulsePair(PulseLength<1>::synchShortPulseLength, PulseLength<1>::synchLongPulseLength);
+		for(size_t j = 0; dataBits[j].mDataBit != DATA_BIT::UNKNOWN; j++) {
+			if(dataBits[j].mDataBit == DATA_BIT::LOGICAL_0) {
+				sendPulsePair(PulseLength<1>::dataShortPulseLength, PulseLength<1>::dataLongPulseLength);
+			} else {
+				sendPulsePair(PulseLength<1>::dataLongPulseLength, PulseLength<1>::dataShortPulseLength);
+			}
+		}
+	}
+	return edgeCount;
+}
+
+/* Noise a receiver module outputs without a signal, short random pulses. */
+template<typename SINK>
+static void sendNoise(uint32_t& usec, SINK sink, const size_t count) {
+	int pinLevel = 1;
+	for(size_t i = 0; i < count; i++) {
+		usec += 80 + (i * 37) % 200;
+		sink(pinLevel, usec);
+		pinLevel = not pinLevel;
+	}
+}
+
+/* Decode the buffered edges, like RcSwitchReceiver::wake() does. */
+static void drainEdgeCapture(EdgeCapture& capture, Receiver& receiver, const uint32_t usecNow) {
+	CapturedEdge edge;
+	while(capture.pop(edge)) {
+		RcSwitch_test::handleInterrupt(receiver, edge.pinLevel, edge.usec);
+	}
+	capture.stop(usecNow);
+}
+
+static size_t wakeCallbackCount = 0;
+
+static void onWake() {
+	wakeCallbackCount++;
+}
+
+/**
+ * Scripted sleep and wake: the decoder sleeps during noise, the first
+ * message packet requests the wake up, and the CPU needs some time to
+ * wake up while the packet goes on.
+ */
+void RcSwitch_test::testEdgeCapture() const {
+	Receiver receiver;
+	receiver.setRxTimingSpecTable(rxProtocolTable.toTimingSpecTable());
+	EdgeCapture capture;
+	capture.setWakePulse(rxProtocolTable.toTimingSpecTable());
+	/* The shortest synchronization pulse is the long pulse of protocol #4. */
+	assert(capture.wakePulse() == 6 * 380 * 80 / 100);
+	capture.setWakeCallback(&onWake);
+	wakeCallbackCount = 0;
+	uint32_t usec = 0;
+	auto toCapture = [&capture](const int pinLevel, const uint32_t usecEdge) {
+		capture.push(pinLevel, usecEdge);
+	};
+	auto toReceiver = [&receiver](const int pinLevel, const uint32_t usecEdge) {
+		RcSwitch_test::handleInterrupt(receiver, pinLevel, usecEdge);
+	};
+
+	capture.start();
+	assert(capture.active());
+	sendNoise(usec, toCapture, 3 * EDGE_CAPTURE_SIZE);
+	assert(!capture.wakeRequested());
+	assert(wakeCallbackCount == 0);
+	CapturedEdge edge;
+	assert(!capture.pop(edge));	// Nothing to decode while asleep.
+
+	/* The long synchronization pulse requests the wake up. */
+	usec += PulseLength<1>::synchShortPulseLength;
+	capture.push(PulseLength<1>::firstPulseEndLevel, usec);
+	assert(!capture.wakeRequested());
+	usec += PulseLength<1>::synchLongPulseLength;
+	capture.push(not PulseLength<1>::firstPulseEndLevel, usec);
+	const uint32_t usecWakeEdge = usec;
+	assert(capture.wakeRequested());
+	assert(wakeCallbackCount == 1);
+
+	/* The CPU wakes up, while the rest of the packet and a repetition arrive. */
+	for(size_t j = 0; validMessagePacket_A[j].mDataBit != DATA_BIT::UNKNOWN; j++) {
+		const bool bOne = validMessagePacket_A[j].mDataBit == DATA_BIT::LOGICAL_1;
+		usec += bOne ? PulseLength<1>::dataLongPulseLength : PulseLength<1>::dataShortPulseLength;
+		capture.push(PulseLength<1>::firstPulseEndLevel, usec);
+		usec += bOne ? PulseLength<1>::dataShortPulseLength : PulseLength<1>::dataLongPulseLength;
+		capture.push(not PulseLength<1>::firstPulseEndLevel, usec);
+	}
+	sendCapturedMessagePackets(usec, toCapture, validMessagePacket_A, 1);
+	assert(wakeCallbackCount == 1);
+
+	const uint32_t usecWakeLatency = usec + 500 - usecWakeEdge;
+	drainEdgeCapture(capture, receiver, usec + 500);
+	assert(!capture.active());
+	assert(receiver.available());
+	assert(receiver.receivedValue() == 0x13 /* binary: 010011 */);
+	assert(receiver.bestProtocol() == 1);
+
+	const EdgeCapture::Statistics& statistics = capture.statistics();
+	assert(statistics.wakeCount == 1);
+	assert(statistics.usecLastWakeLatency == usecWakeLatency);
+	assert(statistics.usecMaxWakeLatency == usecWakeLatency);
+	assert(statistics.lastWakeMissedPackets == 0);
+	assert(statistics.droppedEdges == 0);
+
+	/* Back to live decoding. */
+	receiver.reset();
+	sendCapturedMessagePackets(usec, toReceiver, validMessagePacket_B, MIN_MSG_PACKET_REPEATS + 1);
+	assert(receiver.available());
+	assert(receiver.receivedValue() == 0x2C /* binary: 101100 */);
+
+	/* A wake up without wake request drops the noise. */
+	receiver.reset();
+	capture.start();
+	sendNoise(usec, toCapture, 10);
+	drainEdgeCapture(capture, receiver, usec);
+	assert(receiver.state() == Receiver::SYNC_STATE);
+	assert(capture.statistics().wakeCount == 1);
+}
+
+/* The CPU wakes up too late, the edge buffer overflows. */
+void RcSwitch_test::testEdgeCaptureOverflow() const {
+	Receiver receiver;
+	receiver.setRxTimingSpecTable(rxProtocolTable.toTimingSpecTable());
+	EdgeCapture capture;
+	capture.setWakePulse(rxProtocolTable.toTimingSpecTable());
+	uint32_t usec = 0;
+	auto toCapture = [&capture](const int pinLevel, const uint32_t usecEdge) {
+		capture.push(pinLevel, usecEdge);
+	};
+	auto toReceiver = [&receiver](const int pinLevel, const uint32_t usecEdge) {
+		RcSwitch_test::handleInterrupt(receiver, pinLevel, usecEdge);
+	};
+
+	capture.start();
+	sendNoise(usec, toCapture, 20);
+	const size_t edgeCount = sendCapturedMessagePackets(usec, toCapture, validMessagePacket_A, 10);
+	assert(capture.wakeRequested());
+	assert(edgeCount > EDGE_CAPTURE_SIZE);
+	drainEdgeCapture(capture, receiver, usec);
+
+	const EdgeCapture::Statistics& statistics = capture.statistics();
+	/* The buffer holds the first packets, the later ones are missed. */
+	assert(receiver.available());
+	assert(receiver.receivedValue() == 0x13 /* binary: 010011 */);
+	/* The buffer holds one noise edge before the packets. */
+	assert(statistics.droppedEdges == edgeCount - (EDGE_CAPTURE_SIZE - 1));
+	assert(statistics.lastWakeMissedPackets > 0);
+	assert(statistics.lastWakeMissedPackets <= 10);
+	assert(statistics.missedPackets == statistics.lastWakeMissedPackets);
+
+	/* The next packets are decoded live. */
+	receiver.reset();
+	sendCapturedMessagePackets(usec, toReceiver, validMessagePacket_B, MIN_MSG_PACKET_REPEATS + 2);
+	assert(receiver.available());
+	assert(receiver.receivedValue() == 0x2C /* binary: 101100 */);
+}
+
+static constexpr RcButtonMap::Entry testButtons[] = {
+	{ 1, 5592323, 'C'},
+	{ 1, 5592332, 'A'},
+	{12, 5592332, 'X'},	// Same value, different protocol
+	{ 1, 5592368, 'D'},
+	{ 1, 5592512, 'B'},
+	{12, 2171105792, 1},
+	{12, 2389209600, 2},
+};
+static_assert(RcButtonMap::isSorted(testButtons), "testButtons must be sorted");
+
+static constexpr RcButtonMap::Entry unsortedButtons[] = {
+	{ 1, 5592332, 'A'},
+	{ 1, 5592323, 'C'},
+};
+static_assert(!RcButtonMap::isSorted(unsortedButtons), "isSorted() must detect the wrong order");
+
+void RcSwitch_test::testButtonMap() const {
+	const RcButtonMap buttonMap(testButtons);
+	assert(buttonMap.size() == sizeof(testButtons) / sizeof(testButtons[0]));
+	for(size_t i = 0; i < buttonMap.size(); i++) {
+		assert(buttonMap.find(testButtons[i].protocol, testButtons[i].value) == testButtons[i].buttonCode);
+	}
+	assert(buttonMap.find(1, 5592332) == 'A');
+	assert(buttonMap.find(12, 5592332) == 'X');
+	assert(buttonMap.find(2, 5592332) == RcButtonMap::NO_BUTTON);
+	assert(buttonMap.find(1, 0) == RcButtonMap::NO_BUTTON);
+	assert(buttonMap.find(1, 5592333) == RcButtonMap::NO_BUTTON);
+	assert(buttonMap.find(12, UINT32_MAX) == RcButtonMap::NO_BUTTON);
+
+	const RcButtonMap emptyMap(nullptr, 0);
+	assert(emptyMap.find(1, 5592332) == RcButtonMap::NO_BUTTON);
+}
+
+void RcSwitch_test::testButtonMapStore() const {
+	RcButtonMapStore<100> store;
+	assert(store.size() == 0);
+	assert(store.find(1, 1) == RcButtonMap::NO_BUTTON);
+
+	/* Learned in any order, kept sorted. */
+	for(size_t i = 0; i < store.capacity(); i++) {
+		const receivedValue_t value = (i * 7919) % store.capacity();
+		assert(store.add(1 + i % 2, value, static_cast<int>(i)));
+	}
+	assert(store.size() == store.capacity());
+	for(size_t i = 1; i < store.size(); i++) {
+		assert(RcButtonMap::less(store.at(i - 1), store.at(i)));
+	}
+	for(size_t i = 0; i < store.capacity(); i++) {
+		const receivedValue_t value = (i * 7919) % store.capacity();
+		assert(store.find(1 + i % 2, value) == static_cast<int>(i));
+		assert(store.find(2 - i % 2, value) == RcButtonMap::NO_BUTTON);
+	}
+
+	/* Full: new values are refused, mapped values can be changed. */
+	assert(!store.add(3, 1, 1000));
+	const receivedValue_t value = (5 * 7919) % store.capacity();
+	assert(store.add(2, value, 1000));
+	assert(store.find(2, value) == 1000);
+	assert(store.size() == store.capacity());
+
+	assert(store.remove(2, value));
+	assert(!store.remove(2, value));
+	assert(store.find(2, value) == RcButtonMap::NO_BUTTON);
+	assert(store.size() == store.capacity() - 1);
+	assert(store.add(3, 1, 1001));
+	assert(store.find(3, 1) == 1001);
+
+	store.clear();
+	assert(store.size() == 0);
+	assert(store.find(3, 1) == RcButtonMap::NO_BUTTON);
+}
+
+/* The pins of the receivers the button press detector tests begin() with,
+ * each has a receiver delegate of its own. They are never attached. */
+static constexpr int BUTTON_TEST_PIN = 2;
+static constexpr int BUTTON_OVERFLOW_TEST_PIN = 3;
+
+/** Records the events of a button press detector in a string. */
+class ButtonEventRecorder : public RcButtonPressDetector {
+public:
+	static constexpr size_t MAX_EVENTS = 32;
+	mutable char mEvents[MAX_EVENTS + 1] = {};
+	mutable size_t mEventCount = 0;
+	mutable unsigned int mLastRepeatCount = 0;
+
+	ButtonEventRecorder() : RcButtonPressDetector(250) {}
+
+	/* One event is the button code, lower case for a release */
+	void record(char event) const {
+		if(mEventCount < MAX_EVENTS) {
+			mEvents[mEventCount++] = event;
+		}
+	}
+	void onButtonPressed(rcButtonCode_t buttonCode) const override {
+		record(static_cast<char>(buttonCode));
+	}
+	void onButtonHeld(rcButtonCode_t buttonCode) const override {
+		record('+');
+	}
+	void onButtonRepeated(rcButtonCode_t buttonCode, unsigned int repeatCount) const override {
+		record('*');
+		mLastRepeatCount = repeatCount;
+	}
+	void onButtonReleased(rcButtonCode_t buttonCode) const override {
+		record(static_cast<char>(buttonCode - 'A' + 'a'));
+	}
+	bool eventsAre(const char* events) const {
+		return strcmp(mEvents, events) == 0;
+	}
+};
+
+void RcSwitch_test::testButtonPressDetector() const {
+	/* The detector gets the receiver like in a sketch, the packets are fed
+	 * to the receiver delegate of the pin. */
+	RcSwitchReceiver<BUTTON_TEST_PIN> rcSwitchReceiver;
+	Receiver& receiver = rcSwitchReceiver.getReceiverDelegate();
+	receiver.setRxTimingSpecTable(rxProtocolTable.toTimingSpecTable());
+	uint32_t usec = 0;
+
+	usec += 100; // start hi pulse 100 usec duration.
+	receiver.handleInterrupt(not PulseLength<1>::firstPulseEndLevel, usec);
+
+	RcButtonMapStore<2> buttons;
+	buttons.add(1, 0x13, 'A');
+	buttons.add(1, 0x2C, 'B');
+	ButtonEventRecorder detector;
+	detector.begin(rcSwitchReceiver);
+	detector.setButtonMap(&buttons);
+	detector.setHoldTime(1000, 200);
+
+	auto receive = [&](const TxDataBit* packet, uint32_t msec) {
+		sendMessagePacket(usec, receiver, packet, MIN_MSG_PACKET_REPEATS + 1);
+		assert(receiver.available());
+		detector.scanRcButtons(msec);
+	};
+
+	assert(detector.msecScanTimeout(0) == RcButtonPressDetector::NO_SCAN_TIMEOUT);
+
+	{ // Two remotes in use at once, their packets alternate.
+		for(uint32_t msec = 0; msec <= 400; msec += 100) {
+			receive(validMessagePacket_A, msec);
+			receive(validMessagePacket_B, msec + 50);
+		}
+		assert(detector.eventsAre("AB"));
+		assert(detector.activeButtonCount() == 2);
+		assert(detector.isPressed('A') && detector.isPressed('B'));
+		assert(detector.msecScanTimeout(500) == 250 - 100 + 1);	// release of A
+	}
+
+	{ // B released, A held down and repeated.
+		for(uint32_t msec = 500; msec <= 1600; msec += 100) {
+			receive(validMessagePacket_A, msec);
+		}
+		assert(detector.eventsAre("ABb+***"));
+		assert(detector.mLastRepeatCount == 3);
+		assert(!detector.isPressed('B'));
+	}
+
+	{ // Released after the debounce time without packets.
+		detector.scanRcButtons(1600 + 250);
+		assert(detector.isPressed('A'));
+		detector.scanRcButtons(1600 + 251);
+		assert(detector.eventsAre("ABb+***a"));
+		assert(detector.activeButtonCount() == 0);
+		assert(detector.msecScanTimeout(2000) == RcButtonPressDetector::NO_SCAN_TIMEOUT);
+	}
+
+	{ // Pressed again, a short press signals no hold even when its
+	  // release time is past the hold time.
+		detector.setHoldTime(300);
+		receive(validMessagePacket_A, 2000);
+		receive(validMessagePacket_A, 2100);
+		detector.scanRcButtons(2400);
+		assert(detector.eventsAre("ABb+***aAa"));
+	}
+}
+
+void RcSwitch_test::testButtonPressDetectorOverflow() const {
+	static const TxDataBit packets[][7] = {
+		{{DATA_BIT::LOGICAL_0}, {DATA_BIT::LOGICAL_0}, {DATA_BIT::LOGICAL_0},
+		 {DATA_BIT::LOGICAL_1}, {DATA_BIT::LOGICAL_1}, {DATA_BIT::LOGICAL_1}, {DATA_BIT::UNKNOWN}},
+		{{DATA_BIT::LOGICAL_1}, {DATA_BIT::LOGICAL_1}, {DATA_BIT::LOGICAL_1},
+		 {DATA_BIT::LOGICAL_0}, {DATA_BIT::LOGICAL_0}, {DATA_BIT::LOGICAL_0}, {DATA_BIT::UNKNOWN}},
+		{{DATA_BIT::LOGICAL_1}, {DATA_BIT::LOGICAL_1}, {DATA_BIT::LOGICAL_0},
+		 {DATA_BIT::LOGICAL_0}, {DATA_BIT::LOGICAL_1}, {DATA_BIT::LOGICAL_1}, {DATA_BIT::UNKNOWN}},
+		{{DATA_BIT::LOGICAL_0}, {DATA_BIT::LOGICAL_1}, {DATA_BIT::LOGICAL_0},
+		 {DATA_BIT::LOGICAL_1}, {DATA_BIT::LOGICAL_0}, {DATA_BIT::LOGICAL_1}, {DATA_BIT::UNKNOWN}},
+		{{DATA_BIT::LOGICAL_1}, {DATA_BIT::LOGICAL_0}, {DATA_BIT::LOGICAL_1},
+		 {DATA_BIT::LOGICAL_0}, {DATA_BIT::LOGICAL_1}, {DATA_BIT::LOGICAL_0}, {DATA_BIT::UNKNOWN}},
+	};
+	static constexpr size_t PACKET_COUNT = sizeof(packets) / sizeof(packets[0]);
+	static_assert(PACKET_COUNT > RcButtonPressDetector::MAX_ACTIVE_BUTTONS, "No overflow");
+
+	RcSwitchReceiver<BUTTON_OVERFLOW_TEST_PIN> rcSwitchReceiver;
+	Receiver& receiver = rcSwitchReceiver.getReceiverDelegate();
+	receiver.setRxTimingSpecTable(rxProtocolTable.toTimingSpecTable());
+	uint32_t usec = 0;
+
+	usec += 100; // start hi pulse 100 usec duration.
+	receiver.handleInterrupt(not PulseLength<1>::firstPulseEndLevel, usec);
+
+	RcButtonMapStore<PACKET_COUNT> buttons;
+	buttons.add(1, 0x07, 'A');
+	buttons.add(1, 0x38, 'B');
+	buttons.add(1, 0x33, 'C');
+	buttons.add(1, 0x15, 'D');
+	buttons.add(1, 0x2A, 'E');
+	ButtonEventRecorder detector;
+	detector.begin(rcSwitchReceiver);
+	detector.setButtonMap(&buttons);
+
+	/* The fifth button replaces the one seen longest ago. */
+	for(size_t i = 0; i < PACKET_COUNT; i++) {
+		sendMessagePacket(usec, receiver, packets[i], MIN_MSG_PACKET_REPEATS + 1);
+		assert(receiver.available());
+		detector.scanRcButtons(10 * i);
+	}
+	assert(detector.eventsAre("ABCDaE"));
+	assert(detector.activeButtonCount() == RcButtonPressDetector::MAX_ACTIVE_BUTTONS);
+	assert(!detector.isPressed('A'));
+	assert(detector.isPressed('E'));
+}
+
+void RcSwitch_test::testEqualDataPulseDuration() const {
+	/* Protocol #8 (Conrad RS-200) uses the same pulse B duration
+	 * for a logical 0 and a logical 1. */
+	static constexpr uint32_t CLK = 200;
+	Receiver receiver;
+	receiver.setRxTimingSpecTable(rxProtocolTable.toTimingSpecTable());
+	uint32_t usec = 0;
+
+	usec += 100; // start hi pulse 100 usec duration.
+	receiver.handleInterrupt(1, usec);
+
+	for(size_t i = 0; i < MIN_MSG_PACKET_REPEATS + 1; i++) {
+		sendDataPulse(usec, receiver, 3 * CLK, 130 * CLK, 0);	// synch
+		for(size_t j = 0; validMessagePacket_A[j].mDataBit != DATA_BIT::UNKNOWN; j++) {
+			if(validMessagePacket_A[j].mDataBit == DATA_BIT::LOGICAL_0) {
+				sendDataPulse(usec, receiver, 7 * CLK, 16 * CLK, 0);
+			} else {
+				sendDataPulse(usec, receiver, 3 * CLK, 16 * CLK, 0);
+			}
+		}
+	}
+	sendDataPulse(usec, receiver, 3 * CLK, 130 * CLK, 0);	// synch
+
+	assert(receiver.available());
+	assert(receiver.receivedValue() == 0x13 /* binary: 010011 */);
+	assert(receiver.bestProtocol() == 8);
+}
+
 void RcSwitch_test::testDataRx() const {
 	Receiver receiver;
 	receiver.setRxTimingSpecTable(rxProtocolTable.toTimingSpecTable());
@@ -338,6 +971,230 @@ void RcSwitch_test::testDataRx() const {
 		const uint32_t receivedValue = receiver.receivedValue();
 		assert(receivedValue == 0x2C /* binary: 101100 */); // Confirm new received value.
 	}
+
+	{ // A single message packet, ended by a pause instead of the next synch.
+		receiver.reset();
+		sendMessagePacket(usec, receiver, validMessagePacket_A, 1);
+		Protocol<1>::sendLogical1(usec, receiver, 1.0, 1.0);
+		assert(!receiver.available());
+		/* The pause after the data pulse A is longer than the synch pulse pair. */
+		sendDataPulse(usec, receiver, PulseLength<1>::dataShortPulseLength, 40 * 350,
+				PulseLength<1>::firstPulseEndLevel);
+		assert(receiver.available());
+		assert(receiver.receivedValue() == 0x27 /* binary: 0100111, the last bit is lost */);
+		assert(receiver.receivedBitsCount() == 7);
+		assert(receiver.bestProtocol() == 1);
+		receiver.reset();
+
+		/* A pause after too few data bits is no message packet. */
+		Protocol<1>::sendSynchPulses(usec, receiver);
+		for(size_t i = 0; i < MIN_MSG_PACKET_BITS - 1; i++) {
+			Protocol<1>::sendLogical0(usec, receiver, 1.0, 1.0);
+		}
+		sendDataPulse(usec, receiver, PulseLength<1>::dataShortPulseLength, 40 * 350,
+				PulseLength<1>::firstPulseEndLevel);
+		assert(!receiver.available());
+		assert(receiver.state() == Receiver::SYNC_STATE);
+	}
+}
+
+void RcSwitch_test::testLongDataRx() const {
+	static constexpr DATA_BIT L = DATA_BIT::LOGICAL_0;
+	static constexpr DATA_BIT H = DATA_BIT::LOGICAL_1;
+	static const TxDataBit longMessagePacket[] = {
+		H,L,H,L, L,H,L,H, H,L,H,L, L,H,L,H, H,L,H,L, L,H,L,H, H,L,H,L, L,H,L,H,
+		H,H,L,L, L,L,H,H,
+		// delimiter
+		DATA_BIT::UNKNOWN,
+	};
+	static_assert(sizeof(longMessagePacket) / sizeof(longMessagePacket[0]) == MAX_MSG_PACKET_BITS + 8 + 1,
+			"8 data bits more than a received value can take.");
+
+	Receiver receiver;
+	receiver.setRxTimingSpecTable(rxProtocolTable.toTimingSpecTable());
+	uint32_t usec = 0;
+
+	usec += 100; // start hi pulse 100 usec duration.
+	receiver.handleInterrupt(not PulseLength<1>::firstPulseEndLevel, usec);
+
+	/* The bits beyond the received value are kept as overflow value. */
+	sendMessagePacket(usec, receiver, longMessagePacket, MIN_MSG_PACKET_REPEATS + 1);
+	assert(receiver.available());
+	assert(receiver.receivedBitsCount() == MAX_MSG_PACKET_BITS + 8);
+	assert(receiver.receivedValue() == 0xA5A5A5A5);
+	assert(receiver.receivedOverflowValue() == 0xC3);
+
+	/* No overflow for a short message packet. */
+	receiver.reset();
+	sendMessagePacket(usec, receiver, validMessagePacket_A, MIN_MSG_PACKET_REPEATS + 1);
+	assert(receiver.available());
+	assert(receiver.receivedOverflowValue() == 0);
+}
+
+/** One protocol for each line code, decoded in parallel. */
+static const RxProtocolTable <
+	//                         #, clk,  %, syA,  syB,  d0A,d0B,  d1A,d1B, inverseLevel
+	makeTimingSpec<            1, 350, 20,   1,   31,    1,  3,    3,  1, false>, // pulse width (PT2262)
+	makeTimingSpec<           20, 560, 20,  16,    8,    1,  1,    1,  3, false>, // pulse distance
+	makeManchesterTimingSpec< 21, 500, 20,   6,    4,                     false>, // Manchester
+	makeManchesterTimingSpec< 22, 400, 20,   8,    4,                     true>   // Manchester, inverse level
+> lineCodeProtocolTable;
+
+/* Send a pulse of the given level, the interrupt is at its end. */
+static void sendPulse(uint32_t& usec, Receiver& receiver, const uint32_t usecDuration, const PULSE_LEVEL level) {
+	usec += usecDuration;
+	RcSwitch_test::handleInterrupt(receiver, level == PULSE_LEVEL::HI ? 0 : 1, usec);
+}
+
+/**
+ * Send a Manchester coded message packet: the synch pulses, the data bits
+ * highest first and a pause. Subsequent half bits of the same level merge
+ * into one pulse, also with the synch pulse B and the pause.
+ */
+static void sendManchesterPacket(uint32_t& usec, Receiver& receiver, const uint32_t usecHalfBit,
+		const unsigned int synchA, const unsigned int synchB, const bool inverseLevel,
+		const uint32_t value, const size_t bitCount) {
+	const PULSE_LEVEL one = inverseLevel ? PULSE_LEVEL::LO : PULSE_LEVEL::HI;
+	const PULSE_LEVEL zero = inverseLevel ? PULSE_LEVEL::HI : PULSE_LEVEL::LO;
+	PULSE_LEVEL level = one;
+	uint32_t usecDuration = synchA * usecHalfBit;
+	auto add = [&](const PULSE_LEVEL nextLevel, const uint32_t usecNext) {
+		if(nextLevel == level) {
+			usecDuration += usecNext;
+		} else {
+			sendPulse(usec, receiver, usecDuration, level);
+			level = nextLevel;
+			usecDuration = usecNext;
+		}
+	};
+
+	sendPulse(usec, receiver, 5000, zero); // idle
+	add(zero, synchB * usecHalfBit);
+	for(size_t i = bitCount; i > 0; i--) {
+		const bool bOne = (value >> (i - 1)) & 1;
+		add(bOne ? one : zero, usecHalfBit);
+		add(bOne ? zero : one, usecHalfBit);
+	}
+	add(zero, 20 * usecHalfBit); // pause
+	sendPulse(usec, receiver, usecDuration, level);
+}
+
+void RcSwitch_test::testLineCodes() const {
+	Receiver receiver;
+	receiver.setRxTimingSpecTable(lineCodeProtocolTable.toTimingSpecTable());
+	uint32_t usec = 0;
+
+	usec += 100; // start hi pulse 100 usec duration.
+	receiver.handleInterrupt(not PulseLength<1>::firstPulseEndLevel, usec);
+
+	{ // Pulse width coding
+		sendMessagePacket(usec, receiver, validMessagePacket_A, MIN_MSG_PACKET_REPEATS + 1);
+		assert(receiver.available());
+		assert(receiver.receivedValue() == 0x13 /* binary: 010011 */);
+		assert(receiver.bestProtocol() == 1);
+		receiver.reset();
+	}
+
+	{ // Pulse distance coding: the same pulse A, a longer pulse B for a logical 1.
+		static constexpr uint32_t CLK = 560;
+		const uint32_t value = 0x96; /* binary: 10010110 */
+		for(size_t i = 0; i < MIN_MSG_PACKET_REPEATS + 1; i++) {
+			sendDataPulse(usec, receiver, 16 * CLK, 8 * CLK, 0);	// synch
+			for(size_t j = 8; j > 0; j--) {
+				sendDataPulse(usec, receiver, CLK, ((value >> (j - 1)) & 1) ? 3 * CLK : CLK, 0);
+			}
+		}
+		sendDataPulse(usec, receiver, 16 * CLK, 8 * CLK, 0);	// synch
+		assert(receiver.available());
+		assert(receiver.receivedValue() == value);
+		assert(receiver.receivedBitsCount() == 8);
+		assert(receiver.bestProtocol() == 20);
+		receiver.reset();
+	}
+
+	{ // Manchester coding, starting with a logical 1.
+		sendManchesterPacket(usec, receiver, 500, 6, 4, false, 0xA5, 8);
+		assert(receiver.available());
+		assert(receiver.receivedValue() == 0xA5);
+		assert(receiver.receivedBitsCount() == 8);
+		assert(receiver.bestProtocol() == 21);
+		assert(receiver.receivedProtocolCount() == 1);
+		assert(receiver.bestProtocolTimingError() == 0);		// Nominal timing has been sent.
+		assert(receiver.bestProtocolMaxDeviation() == 0);
+		assert(receiver.bestProtocolJitter() == 0);
+		assert(receiver.receivedDataDuration() == 8 * 1000);
+		assert(receiver.receivedDataDuration() == receiver.bestProtocolDataDuration());
+		receiver.reset();
+	}
+
+	{ // Manchester coding, the first half bit extends synch pulse B.
+		sendManchesterPacket(usec, receiver, 500, 6, 4, false, 0x5A, 8);
+		assert(receiver.available());
+		assert(receiver.receivedValue() == 0x5A);
+		assert(receiver.receivedBitsCount() == 8);
+		assert(receiver.bestProtocol() == 21);
+		assert(receiver.receivedDataDuration() == receiver.bestProtocolDataDuration());
+		receiver.reset();
+	}
+
+	{ // Manchester coding, inverse level, long message packet.
+		sendManchesterPacket(usec, receiver, 400, 8, 4, true, 0x3C0FF, 20);
+		assert(receiver.available());
+		assert(receiver.receivedValue() == 0x3C0FF);
+		assert(receiver.receivedBitsCount() == 20);
+		assert(receiver.bestProtocol() == 22);
+		receiver.reset();
+	}
+
+	{ // Slow Manchester coding, within the tolerance.
+		sendManchesterPacket(usec, receiver, 560, 6, 4, false, 0x2D, 7);
+		assert(receiver.available());
+		assert(receiver.receivedValue() == 0x2D);
+		assert(receiver.bestProtocol() == 21);
+		/* Synch A is 360usec long, synch B less the first half bit 300usec.
+		 * Of the 7 data pulses, 5 span two half bits and are 120usec long,
+		 * 2 span one half bit and are 60usec long. 9 pulses are rated. */
+		assert(receiver.bestProtocolTimingError() == (360 + 300 + 5 * 120 + 2 * 60) / 9);
+		/* A slow clock: every pulse is longer by the same share, no jitter. */
+		assert(receiver.bestProtocolMaxDeviation() == 2 * 60);
+		assert(receiver.bestProtocolJitter() == 0);
+		receiver.reset();
+	}
+}
+
+void RcSwitch_test::testManchesterViolation() const {
+	Receiver receiver;
+	receiver.setRxTimingSpecTable(lineCodeProtocolTable.toTimingSpecTable());
+	uint32_t usec = 0;
+
+	usec += 100;
+	receiver.handleInterrupt(1, usec);
+
+	{ // A missing level change in the middle of the 4th data bit.
+		sendPulse(usec, receiver, 3000, PULSE_LEVEL::HI);	// synch A
+		sendPulse(usec, receiver, 2000, PULSE_LEVEL::LO);	// synch B
+		sendPulse(usec, receiver, 500, PULSE_LEVEL::HI);	// 1
+		sendPulse(usec, receiver, 1000, PULSE_LEVEL::LO);	// 1, 0
+		sendPulse(usec, receiver, 1000, PULSE_LEVEL::HI);	// 0, half of 1
+		sendPulse(usec, receiver, 1500, PULSE_LEVEL::LO);	// neither a half nor a full bit
+		sendPulse(usec, receiver, 10000, PULSE_LEVEL::HI);
+		assert(!receiver.available());
+		assert(receiver.mManchesterDecoder.protocolCandidates().size() == 0);
+	}
+
+	{ // Decoding resumes with the next message packet.
+		sendManchesterPacket(usec, receiver, 500, 6, 4, false, 0x33, 8);
+		assert(receiver.available());
+		assert(receiver.receivedValue() == 0x33);
+	}
+
+	{ // The decoder is skipped without Manchester protocols.
+		receiver.setRxTimingSpecTable(rxProtocolTable.toTimingSpecTable());
+		receiver.reset();
+		sendManchesterPacket(usec, receiver, 500, 6, 4, false, 0x33, 8);
+		assert(!receiver.available());
+		assert(receiver.mManchesterDecoder.protocolCandidates().size() == 0);
+	}
 }
 
 void RcSwitch_test::testSynchRx() const {
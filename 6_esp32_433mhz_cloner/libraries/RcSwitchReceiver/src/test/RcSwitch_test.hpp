@@ -32,6 +32,7 @@
 #if ENABLE_RCSWITCH_TEST
 
 #include "../internal/RcSwitch.hpp"
+#include "../internal/EdgeCapture.hpp"
 
 namespace RcSwitch {
 
@@ -63,6 +64,15 @@ public:
 		return receiver.handleInterrupt(pinLevel, usecInterruptEntry);
 	}
 
+	/** Run 'function' on a receiver of its own, e.g. to benchmark a protocol table. */
+	static void withReceiver(const RxTimingSpecTable& rxTimingSpecTable
+		, void (*function)(Receiver& receiver, void* context), void* context)
+	{
+		Receiver receiver;
+		receiver.setRxTimingSpecTable(rxTimingSpecTable);
+		function(receiver, context);
+	}
+
 	static void sendDataPulse(uint32_t &usec
 		, Receiver &receiver
 		, const uint32_t firstPulse
@@ -71,6 +81,7 @@ public:
 
 private:
 	/* Send a message package multiple times */
+	template<unsigned int protocolNumber = 1>
 	void sendMessagePacket(uint32_t &usec, Receiver &receiver
 		, const TxDataBit* const dataBits
 		, const size_t count) const;
@@ -85,7 +96,20 @@ private:
 	void testProtocolCandidates() const;
 	void testSynchRx() const;
 	void testDataRx() const;
+	void testLongDataRx() const;
+	void testLineCodes() const;
+	void testManchesterViolation() const;
 	void testFaultyDataRx() const;
+	void testBestProtocol() const;
+	void testTransmitWindow() const;
+	void testEqualDataPulseDuration() const;
+	void testAvailableCallback() const;
+	void testEdgeCapture() const;
+	void testEdgeCaptureOverflow() const;
+	void testButtonMap() const;
+	void testButtonMapStore() const;
+	void testButtonPressDetector() const;
+	void testButtonPressDetectorOverflow() const;
 
 public:
 	void run() const{
@@ -94,7 +118,20 @@ public:
 		testProtocolCandidates();
 		testSynchRx();
 		testDataRx();
+		testLongDataRx();
+		testLineCodes();
+		testManchesterViolation();
 		testFaultyDataRx();
+		testBestProtocol();
+		testTransmitWindow();
+		testEqualDataPulseDuration();
+		testAvailableCallback();
+		testEdgeCapture();
+		testEdgeCaptureOverflow();
+		testButtonMap();
+		testButtonMapStore();
+		testButtonPressDetector();
+		testButtonPressDetectorOverflow();
 	}
 
 	static RcSwitch_test theTest;
@@ -33,6 +33,7 @@
 */
 
 #include "RCSwitch.h"
+#include <limits.h>
 
 #ifdef RaspberryPi
     // PROGMEM and _P functions are for AVR based microprocessors,
@@ -108,8 +109,130 @@ const unsigned int RCSwitch::nSeparationLimit = 4300;
 // according to discussion on issue #14 it might be more suitable to set the separation
 // limit to the same time as the 'low' part of the sync signal for the current protocol.
 unsigned int RCSwitch::timings[RCSWITCH_MAX_CHANGES];
+volatile bool RCSwitch::bReceiveResync = false;
+volatile bool RCSwitch::bDeferredDecode = false;
+unsigned int RCSwitch::deferredTimings[RCSWITCH_MAX_CHANGES];
+volatile unsigned int RCSwitch::nDeferredChangeCount = 0;
+volatile uint8_t RCSwitch::nDeferredStartLevel = 0;
+volatile unsigned long RCSwitch::nReceivedFrameCount = 0;
+volatile unsigned long RCSwitch::nProtocolsTriedCount = 0;
+volatile unsigned long RCSwitch::nSelfEchoCount = 0;
+unsigned long RCSwitch::nTransmitWindowCount = 0;
+volatile int RCSwitch::nRawCapturePin = -1;
+RCSwitch::RawFrame RCSwitch::rawFrames[RCSWITCH_RAW_FRAMES];
+volatile unsigned int RCSwitch::nRawFrameNext = 0;
+volatile unsigned int RCSwitch::nRawFrameCount = 0;
+volatile uint8_t RCSwitch::nRawFrameVersion = 0;
+
+/*
+ * Per protocol acceptance windows, derived from proto[] and the receive
+ * tolerance by updateReceiveFilters(). They let decodeTimings() skip
+ * protocols that can't match before running the bit loop:
+ * - timings[0] must be within the sync length of the protocol.
+ * - the ratio of the first data pulse pair, scaled by 256, must be within
+ *   the ratios of a zero or a one bit. This is implied by the bit loop, so
+ *   it never rejects a frame that receiveProtocol() would accept.
+ */
+struct ReceiveFilter {
+  unsigned int firstDataTiming;
+  unsigned long syncMin;
+  unsigned long syncMax;
+  unsigned long ratioMin;
+  unsigned long ratioMax;
+};
+static VAR_ISR_ATTR ReceiveFilter receiveFilters[numProto];
+
+/* helper function for updateReceiveFilters(), the range of h/l scaled by 256 */
+static void pulseRatioRange(const RCSwitch::HighLow& pulses, int nPercent,
+                            unsigned long& ratioMin, unsigned long& ratioMax) {
+  const long high = 100L * pulses.high;
+  const long low = 100L * pulses.low;
+  const unsigned long rmin = (high > nPercent) ? (high - nPercent) * 256 / (low + nPercent) : 0;
+  const unsigned long rmax = (low > nPercent) ? ((high + nPercent) * 256 + (low - nPercent) - 1) / (low - nPercent) : ULONG_MAX;
+  if (rmin < ratioMin) ratioMin = rmin;
+  if (rmax > ratioMax) ratioMax = rmax;
+}
+
+static void updateReceiveFilters(int nPercent) {
+  for (unsigned int i = 0; i < numProto; i++) {
+#if defined(ESP8266) || defined(ESP32)
+    const RCSwitch::Protocol &pro = proto[i];
+#else
+    RCSwitch::Protocol pro;
+    memcpy_P(&pro, &proto[i], sizeof(RCSwitch::Protocol));
+#endif
+    const unsigned long syncLengthInPulses = ((pro.syncFactor.low) > (pro.syncFactor.high)) ? (pro.syncFactor.low) : (pro.syncFactor.high);
+    const unsigned long nominal = syncLengthInPulses * pro.pulseLength;
+    ReceiveFilter& filter = receiveFilters[i];
+    filter.firstDataTiming = (pro.invertedSignal) ? (2) : (1);
+    filter.syncMin = (nPercent < 100) ? nominal * (100 - nPercent) / 100 : 0;
+    filter.syncMax = nominal * (100 + nPercent) / 100;
+    filter.ratioMin = ULONG_MAX;
+    filter.ratioMax = 0;
+    pulseRatioRange(pro.zero, nPercent, filter.ratioMin, filter.ratioMax);
+    pulseRatioRange(pro.one, nPercent, filter.ratioMin, filter.ratioMax);
+  }
+}
+#endif
+
+#if defined(ESP32)
+static hw_timer_t* pTransmitHwTimer = NULL;
+static VAR_ISR_ATTR uint64_t nTransmitHwTimerAlarm = 0;
+
+static void RECEIVE_ATTR armTransmitHwTimer() {
+  // An alarm in the past would never fire, so make sure we're ahead of the counter.
+  const uint64_t now = timerRead(pTransmitHwTimer);
+  if (nTransmitHwTimerAlarm <= now) {
+    nTransmitHwTimerAlarm = now + 1;
+  }
+#if defined(ESP_ARDUINO_VERSION_MAJOR) && ESP_ARDUINO_VERSION_MAJOR >= 3
+  timerAlarm(pTransmitHwTimer, nTransmitHwTimerAlarm, false, 0);
+#else
+  timerAlarmWrite(pTransmitHwTimer, nTransmitHwTimerAlarm, false);
+  timerAlarmEnable(pTransmitHwTimer);
+#endif
+}
+
+static void RECEIVE_ATTR onTransmitHwTimer() {
+  RCSwitch::handleTransmitTimer();
+}
+
+static void startTransmitHwTimer(unsigned int nMicroseconds) {
+  if (pTransmitHwTimer == NULL) {
+    // The timer counts microseconds.
+#if defined(ESP_ARDUINO_VERSION_MAJOR) && ESP_ARDUINO_VERSION_MAJOR >= 3
+    pTransmitHwTimer = timerBegin(1000000);
+    timerAttachInterrupt(pTransmitHwTimer, &onTransmitHwTimer);
+#else
+    pTransmitHwTimer = timerBegin(RCSWITCH_TRANSMIT_TIMER, getApbFrequency() / 1000000, true);
+    timerAttachInterrupt(pTransmitHwTimer, &onTransmitHwTimer, true);
+#endif
+  }
+  nTransmitHwTimerAlarm = timerRead(pTransmitHwTimer) + nMicroseconds;
+  armTransmitHwTimer();
+}
+
+static void RECEIVE_ATTR nextTransmitHwTimer(unsigned int nMicroseconds) {
+  nTransmitHwTimerAlarm += nMicroseconds;
+  armTransmitHwTimer();
+}
+
+static const RCSwitch::TransmitTimer transmitHwTimer = { &startTransmitHwTimer, &nextTransmitHwTimer };
+const RCSwitch::TransmitTimer* RCSwitch::pTransmitTimer = &transmitHwTimer;
+#else
+// No default transmit timer, sendAsync() falls back to send().
+const RCSwitch::TransmitTimer* RCSwitch::pTransmitTimer = NULL;
 #endif
 
+RCSwitch::TransmitCompleteCallback RCSwitch::pTransmitCompleteCallback = NULL;
+RCSwitch::Waveform RCSwitch::transmitWaveform;
+volatile unsigned int RCSwitch::nTransmitPulseIndex = 0;
+volatile int RCSwitch::nTransmitRepeatsLeft = 0;
+int RCSwitch::nTransmitPin = -1;
+volatile bool RCSwitch::bTransmitBusy = false;
+RCSwitch::TransmitWindowCallback RCSwitch::pTransmitWindowCallback = NULL;
+volatile bool RCSwitch::bTransmitWindow = false;
+
 RCSwitch::RCSwitch() {
   this->nTransmitterPin = -1;
   this->setRepeatTransmit(10);
@@ -171,6 +294,7 @@ void RCSwitch::setRepeatTransmit(int nRepeatTransmit) {
 #if not defined( RCSwitchDisableReceiving )
 void RCSwitch::setReceiveTolerance(int nPercent) {
   RCSwitch::nReceiveTolerance = nPercent;
+  updateReceiveFilters(nPercent);
 }
 #endif
   
@@ -474,6 +598,142 @@ void RCSwitch::sendTriState(const char* sCodeWord) {
   this->send(code, length);
 }
 
+/**
+ * Turn a received code back into its tri-state code word, the inverse of
+ * sendTriState(). Each pair of bits is one symbol, looked up in a table:
+ * 00 is '0', 01 is 'F' and 11 is '1'. The pair 10 is no symbol, such codes
+ * are found with a single mask test before any lookup.
+ *
+ * @param code        the received code, the first received bit highest
+ * @param length      the number of received bits, even
+ * @param sCodeWord   char[length / 2 + 1], the tristate code word
+ *
+ * @return false if the code is no tri-state code word, then sCodeWord is empty
+ */
+bool RCSwitch::getTriState(unsigned long code, unsigned int length, char* sCodeWord) {
+  static const char symbols[4] = { '0', 'F', '\0', '1' };
+  const unsigned long allPairs = (unsigned long)0x5555555555555555ULL;
+
+  sCodeWord[0] = '\0';
+  if (length == 0 || length % 2 != 0 || length > sizeof(code) * 8) {
+    return false;
+  }
+  const unsigned long lowBits = (length < sizeof(code) * 8) ? ((1UL << length) - 1) & allPairs : allPairs;
+  // a pair 10: the high bit set, the low bit clear
+  if ((code >> 1) & ~code & lowBits) {
+    return false;
+  }
+
+  const unsigned int nSymbols = length / 2;
+  for (unsigned int i = 0; i < nSymbols; i++) {
+    sCodeWord[i] = symbols[(code >> (2 * (nSymbols - 1 - i))) & 3];
+  }
+  sCodeWord[nSymbols] = '\0';
+  return true;
+}
+
+/**
+ * Decode the switch address of a 12 symbol tri-state code word, see
+ * getCodeWordA() to getCodeWordD() for the bit patterns. A code word that
+ * fits several types is reported as the type with the most fixed symbols,
+ * in the order D, C, B, A.
+ *
+ * @return false if the code word has none of the patterns
+ */
+bool RCSwitch::decodeCodeWord(const char* sCodeWord, SwitchAddress& address) {
+  if (strlen(sCodeWord) != 12) {
+    return false;
+  }
+  return decodeCodeWordD(sCodeWord, address) || decodeCodeWordC(sCodeWord, address)
+      || decodeCodeWordB(sCodeWord, address) || decodeCodeWordA(sCodeWord, address);
+}
+
+/* Type A: 5 DIP switches group, 5 DIP switches device, on=0F off=F0 */
+bool RCSwitch::decodeCodeWordA(const char* sCodeWord, SwitchAddress& address) {
+  int nBits = 0;
+  for (int i = 0; i < 10; i++) {
+    if (sCodeWord[i] != '0' && sCodeWord[i] != 'F') {
+      return false;
+    }
+    nBits = (nBits << 1) | (sCodeWord[i] == '0');
+  }
+  if (sCodeWord[10] == sCodeWord[11] || (sCodeWord[10] != '0' && sCodeWord[10] != 'F')
+      || (sCodeWord[11] != '0' && sCodeWord[11] != 'F')) {
+    return false;
+  }
+  address.type = 'A';
+  address.sFamily = 0;
+  address.nGroup = nBits >> 5;
+  address.nDevice = nBits & 0x1F;
+  address.bStatus = sCodeWord[10] == '0';
+  return true;
+}
+
+/* Position of the only 'symbol' among 'F's, 1 based, 0 if there is none */
+static int findOnly(const char* sCodeWord, int nLength, char symbol) {
+  int nFound = 0;
+  for (int i = 0; i < nLength; i++) {
+    if (sCodeWord[i] == symbol && nFound == 0) {
+      nFound = i + 1;
+    } else if (sCodeWord[i] != 'F') {
+      return 0;
+    }
+  }
+  return nFound;
+}
+
+/* Type B: group 1=0FFF..4=FFF0, switch 1=0FFF..4=FFF0, FFF, on=F off=0 */
+bool RCSwitch::decodeCodeWordB(const char* sCodeWord, SwitchAddress& address) {
+  const int nGroup = findOnly(sCodeWord, 4, '0');
+  const int nDevice = findOnly(sCodeWord + 4, 4, '0');
+  if (nGroup == 0 || nDevice == 0 || strncmp(sCodeWord + 8, "FFF", 3) != 0
+      || (sCodeWord[11] != 'F' && sCodeWord[11] != '0')) {
+    return false;
+  }
+  address.type = 'B';
+  address.sFamily = 0;
+  address.nGroup = nGroup;
+  address.nDevice = nDevice;
+  address.bStatus = sCodeWord[11] == 'F';
+  return true;
+}
+
+/* Type C: family and device/group bits, lowest bit first, F=1, then 0FF, on=F off=0 */
+bool RCSwitch::decodeCodeWordC(const char* sCodeWord, SwitchAddress& address) {
+  int nBits = 0;
+  for (int i = 7; i >= 0; i--) {
+    if (sCodeWord[i] != '0' && sCodeWord[i] != 'F') {
+      return false;
+    }
+    nBits = (nBits << 1) | (sCodeWord[i] == 'F');
+  }
+  if (strncmp(sCodeWord + 8, "0FF", 3) != 0 || (sCodeWord[11] != 'F' && sCodeWord[11] != '0')) {
+    return false;
+  }
+  address.type = 'C';
+  address.sFamily = 'a' + (nBits & 0x0F);
+  address.nDevice = ((nBits >> 4) & 3) + 1;
+  address.nGroup = ((nBits >> 6) & 3) + 1;
+  address.bStatus = sCodeWord[11] == 'F';
+  return true;
+}
+
+/* Type D: group A=1FFF..D=FFF1, device 1=1FF..3=FF1, 000, on=10 off=01 */
+bool RCSwitch::decodeCodeWordD(const char* sCodeWord, SwitchAddress& address) {
+  const int nGroup = findOnly(sCodeWord, 4, '1');
+  const int nDevice = findOnly(sCodeWord + 4, 3, '1');
+  if (nGroup == 0 || nDevice == 0 || strncmp(sCodeWord + 7, "000", 3) != 0
+      || !((sCodeWord[10] == '1' && sCodeWord[11] == '0') || (sCodeWord[10] == '0' && sCodeWord[11] == '1'))) {
+    return false;
+  }
+  address.type = 'D';
+  address.sFamily = 0;
+  address.nGroup = nGroup;
+  address.nDevice = nDevice;
+  address.bStatus = sCodeWord[10] == '1';
+  return true;
+}
+
 /**
  * @param sCodeWord   a binary code word consisting of the letter 0, 1
  */
@@ -499,13 +759,8 @@ void RCSwitch::send(unsigned long code, unsigned int length) {
   if (this->nTransmitterPin == -1)
     return;
 
-#if not defined( RCSwitchDisableReceiving )
-  // make sure the receiver is disabled while we transmit
-  int nReceiverInterrupt_backup = nReceiverInterrupt;
-  if (nReceiverInterrupt_backup != -1) {
-    this->disableReceive();
-  }
-#endif
+  // make sure the receiver ignores the echo of our transmission
+  RCSwitch::beginTransmitWindow();
 
   for (int nRepeat = 0; nRepeat < nRepeatTransmit; nRepeat++) {
     for (int i = length-1; i >= 0; i--) {
@@ -520,12 +775,7 @@ void RCSwitch::send(unsigned long code, unsigned int length) {
   // Disable transmit after sending (i.e., for inverted protocols)
   digitalWrite(this->nTransmitterPin, LOW);
 
-#if not defined( RCSwitchDisableReceiving )
-  // enable receiver again if we just disabled it
-  if (nReceiverInterrupt_backup != -1) {
-    this->enableReceive(nReceiverInterrupt_backup);
-  }
-#endif
+  RCSwitch::endTransmitWindow();
 }
 
 /**
@@ -541,6 +791,340 @@ void RCSwitch::transmit(HighLow pulses) {
   delayMicroseconds( this->protocol.pulseLength * pulses.low);
 }
 
+/* helper function for compileWaveform(), durations are limited to 16 bit */
+static inline uint16_t toWaveformDuration(unsigned long nMicroseconds) {
+  return (nMicroseconds > 0xFFFF) ? 0xFFFF : nMicroseconds;
+}
+
+/**
+ * Compile the first 'length' bits of the integer 'code' into a waveform,
+ * using the current protocol. The waveform holds a single frame, i.e.
+ * the data bits followed by the sync pulse, like send() transmits it.
+ *
+ * A code has at most 32 bits, the waveform of a longer length is empty
+ * and nothing is sent for it.
+ */
+void RCSwitch::compileWaveform(unsigned long code, unsigned int length, Waveform& waveform) const {
+  waveform.firstLevel = (this->protocol.invertedSignal) ? LOW : HIGH;
+  if (length > 32) {
+    waveform.count = 0;
+    return;
+  }
+  const unsigned long nPulseLength = this->protocol.pulseLength;
+  unsigned int n = 0;
+  // each HighLow contributes two durations, keep space for the sync
+  for (int i = length-1; i >= 0 && n + 4 <= RCSWITCH_MAX_CHANGES; i--) {
+    const HighLow& pulses = (code & (1UL << i)) ? this->protocol.one : this->protocol.zero;
+    waveform.durations[n++] = toWaveformDuration(nPulseLength * pulses.high);
+    waveform.durations[n++] = toWaveformDuration(nPulseLength * pulses.low);
+  }
+  waveform.durations[n++] = toWaveformDuration(nPulseLength * this->protocol.syncFactor.high);
+  waveform.durations[n++] = toWaveformDuration(nPulseLength * this->protocol.syncFactor.low);
+  waveform.count = n;
+}
+
+/*
+ * helper function for sendWaveform(), delayMicroseconds() is only accurate
+ * up to 16383 microseconds on AVR.
+ */
+static void waitUntil(unsigned long nDeadline) {
+  long nLeft;
+  while ((nLeft = (long)(nDeadline - micros())) > 0) {
+    delayMicroseconds((nLeft > 16000) ? 16000 : nLeft);
+  }
+}
+
+/**
+ * Transmit a precompiled waveform nRepeatTransmit times. Blocks like send().
+ *
+ * The edges are scheduled relative to the first one, so the time spent in
+ * digitalWrite() doesn't add up over the frame.
+ */
+void RCSwitch::sendWaveform(const Waveform& waveform) {
+  if (this->nTransmitterPin == -1)
+    return;
+
+  // make sure the receiver ignores the echo of our transmission
+  RCSwitch::beginTransmitWindow();
+
+  const uint8_t secondLevel = !waveform.firstLevel;
+  unsigned long nEdge = micros();
+  for (int nRepeat = 0; nRepeat < nRepeatTransmit; nRepeat++) {
+    for (unsigned int i = 0; i + 1 < waveform.count; i += 2) {
+      digitalWrite(this->nTransmitterPin, waveform.firstLevel);
+      nEdge += waveform.durations[i];
+      waitUntil(nEdge);
+      digitalWrite(this->nTransmitterPin, secondLevel);
+      nEdge += waveform.durations[i + 1];
+      waitUntil(nEdge);
+    }
+  }
+
+  // Disable transmit after sending (i.e., for inverted protocols)
+  digitalWrite(this->nTransmitterPin, LOW);
+
+  RCSwitch::endTransmitWindow();
+}
+
+/**
+ * Scale all durations of a waveform by nPercent, e.g. 105 makes it 5%
+ * slower. Useful to replay a waveform captured from a remote with a
+ * drifting clock.
+ */
+void RCSwitch::stretchWaveform(Waveform& waveform, unsigned int nPercent) {
+  for (unsigned int i = 0; i < waveform.count; i++) {
+    const unsigned long nStretched = ((unsigned long)waveform.durations[i] * nPercent + 50) / 100;
+    waveform.durations[i] = (nStretched == 0) ? 1 : toWaveformDuration(nStretched);
+  }
+}
+
+/*
+ * helper function for normalizeWaveform(), the sum of the distances of the
+ * data durations to their nearest multiple of nClock. The sync gap at the
+ * end is left out, it jitters the most.
+ *
+ * @return false, if a duration is off by more than a quarter clock.
+ */
+static bool fitClock(const RCSwitch::Waveform& waveform, unsigned int nClock, unsigned long& nSumErrors) {
+  nSumErrors = 0;
+  for (unsigned int i = 0; i + 1 < waveform.count; i++) {
+    const unsigned int nDuration = waveform.durations[i];
+    const unsigned int nNearest = (nDuration + nClock / 2) / nClock * nClock;
+    const unsigned int nError = (nDuration > nNearest) ? (nDuration - nNearest) : (nNearest - nDuration);
+    if (nNearest == 0 || nError * 4 > nClock)
+      return false;
+    nSumErrors += nError;
+  }
+  return true;
+}
+
+/**
+ * Snap the durations of a captured waveform to multiples of its clock,
+ * removing the jitter picked up by the receiver.
+ *
+ * Clocks from 5/4 of the average short duration down to 1/8 of it are
+ * tried. Of those all durations are multiples of within a quarter clock,
+ * the one with the smallest error relative to the clock is taken, and
+ * refined to the average over all data durations. This needs the jitter
+ * to stay well below a quarter clock.
+ *
+ * @return the detected clock in microseconds, or 0 if no clock fits. The
+ * waveform is left unchanged then.
+ */
+unsigned int RCSwitch::normalizeWaveform(Waveform& waveform) {
+  if (waveform.count < 2)
+    return 0;
+
+  // the short durations are the ones below 1.5 times the shortest
+  unsigned int nShortest = 0xFFFF;
+  for (unsigned int i = 0; i + 1 < waveform.count; i++) {
+    if (waveform.durations[i] < nShortest) nShortest = waveform.durations[i];
+  }
+  // a zero duration has no clock, and no duration would be short
+  if (nShortest == 0)
+    return 0;
+  unsigned long nSumShort = 0;
+  unsigned int nShortCount = 0;
+  for (unsigned int i = 0; i + 1 < waveform.count; i++) {
+    if (2UL * waveform.durations[i] < 3UL * nShortest) {
+      nSumShort += waveform.durations[i];
+      nShortCount++;
+    }
+  }
+  const unsigned int nShort = nSumShort / nShortCount;
+
+  unsigned int nBestClock = 0;
+  unsigned long nBestErrors = 0;
+  for (unsigned int nClock = nShort + nShort / 4; nClock > 0 && nClock >= nShort / 8; nClock--) {
+    unsigned long nSumErrors;
+    if (!fitClock(waveform, nClock, nSumErrors))
+      continue;
+    // nSumErrors / nClock < nBestErrors / nBestClock, ties go to the larger clock
+    if (nBestClock == 0 || nSumErrors * nBestClock < nBestErrors * nClock) {
+      nBestClock = nClock;
+      nBestErrors = nSumErrors;
+    }
+  }
+  if (nBestClock == 0)
+    return 0;
+
+  unsigned long nSumDurations = 0;
+  unsigned long nSumMultiples = 0;
+  for (unsigned int i = 0; i + 1 < waveform.count; i++) {
+    nSumDurations += waveform.durations[i];
+    nSumMultiples += (waveform.durations[i] + nBestClock / 2) / nBestClock;
+  }
+  unsigned int nClock = (nSumDurations + nSumMultiples / 2) / nSumMultiples;
+  unsigned long nSumErrors;
+  if (!fitClock(waveform, nClock, nSumErrors)) {
+    nClock = nBestClock;
+  }
+
+  for (unsigned int i = 0; i < waveform.count; i++) {
+    const unsigned long nMultiple = (waveform.durations[i] + nClock / 2) / nClock;
+    waveform.durations[i] = toWaveformDuration(((nMultiple == 0) ? 1 : nMultiple) * nClock);
+  }
+  return nClock;
+}
+
+/**
+ * Transmit the first 'length' bits of the integer 'code' like send(), but
+ * return immediately. The code is compiled into a waveform that is played
+ * by the transmit timer interrupt, see sendWaveformAsync().
+ *
+ * @return false, if a transmission is still in progress or no transmitter
+ * pin is enabled.
+ */
+bool RCSwitch::sendAsync(unsigned long code, unsigned int length) {
+  if (this->nTransmitterPin == -1 || this->isBusy())
+    return false;
+
+  Waveform waveform;
+  this->compileWaveform(code, length, waveform);
+  return this->sendWaveformAsync(waveform);
+}
+
+/**
+ * Transmit a precompiled waveform nRepeatTransmit times, but return
+ * immediately. The waveform is copied, so the caller may change it
+ * right away. The frame is played by the transmit timer interrupt. Poll
+ * isBusy() or install a callback with setTransmitCompleteCallback() to
+ * learn when the transmission has finished.
+ *
+ * The receiver ignores the echo of the transmission, see
+ * beginTransmitWindow().
+ *
+ * If there is no transmit timer, the waveform is sent with sendWaveform().
+ *
+ * @return false, if a transmission is still in progress or no transmitter
+ * pin is enabled.
+ */
+bool RCSwitch::sendWaveformAsync(const Waveform& waveform) {
+  if (this->nTransmitterPin == -1 || this->isBusy())
+    return false;
+
+  if (RCSwitch::pTransmitTimer == NULL) {
+    this->sendWaveform(waveform);
+    if (RCSwitch::pTransmitCompleteCallback != NULL) {
+      RCSwitch::pTransmitCompleteCallback();
+    }
+    return true;
+  }
+
+  if (this->nRepeatTransmit <= 0 || waveform.count == 0) {
+    // nothing to send, but the transmission is complete all the same
+    if (RCSwitch::pTransmitCompleteCallback != NULL) {
+      RCSwitch::pTransmitCompleteCallback();
+    }
+    return true;
+  }
+
+  RCSwitch::transmitWaveform = waveform;
+  RCSwitch::nTransmitPulseIndex = 1;
+  RCSwitch::nTransmitRepeatsLeft = this->nRepeatTransmit;
+  RCSwitch::nTransmitPin = this->nTransmitterPin;
+  RCSwitch::bTransmitBusy = true;
+
+  // make sure the receiver ignores the echo of our transmission
+  RCSwitch::beginTransmitWindow();
+  // The first edge is set right here, the timer takes over from there.
+  digitalWrite(RCSwitch::nTransmitPin, RCSwitch::transmitWaveform.firstLevel);
+  RCSwitch::pTransmitTimer->start(RCSwitch::transmitWaveform.durations[0]);
+  return true;
+}
+
+/**
+ * @return true, while a transmission started by sendAsync() is in progress.
+ */
+bool RCSwitch::isBusy() {
+  return RCSwitch::bTransmitBusy;
+}
+
+/**
+ * Install a function to be called from interrupt context when a
+ * transmission started by sendAsync() has finished. Pass NULL to remove it.
+ */
+void RCSwitch::setTransmitCompleteCallback(TransmitCompleteCallback pCallback) {
+  RCSwitch::pTransmitCompleteCallback = pCallback;
+}
+
+/**
+ * Replace the timer that drives sendAsync(). Pass NULL to make sendAsync()
+ * fall back to send(). Must not be called while a transmission is in progress.
+ */
+void RCSwitch::setTransmitTimer(const TransmitTimer* pTimer) {
+  RCSwitch::pTransmitTimer = pTimer;
+}
+
+/**
+ * Set the next transmitter level and arm the timer for its duration.
+ * To be called from the transmit timer on expiry.
+ */
+void RECEIVE_ATTR RCSwitch::handleTransmitTimer() {
+  if (!RCSwitch::bTransmitBusy)
+    return;
+
+  unsigned int i = RCSwitch::nTransmitPulseIndex;
+  if (i >= RCSwitch::transmitWaveform.count) {
+    // frame done
+    if (--RCSwitch::nTransmitRepeatsLeft <= 0) {
+      // Disable transmit after sending (i.e., for inverted protocols)
+      digitalWrite(RCSwitch::nTransmitPin, LOW);
+      RCSwitch::endTransmitWindow();
+      RCSwitch::bTransmitBusy = false;
+      if (RCSwitch::pTransmitCompleteCallback != NULL) {
+        RCSwitch::pTransmitCompleteCallback();
+      }
+      return;
+    }
+    i = 0;
+  }
+
+  // levels alternate, even indices carry the first level of a HighLow
+  const uint8_t firstLevel = RCSwitch::transmitWaveform.firstLevel;
+  digitalWrite(RCSwitch::nTransmitPin, (i & 1) ? !firstLevel : firstLevel);
+  RCSwitch::nTransmitPulseIndex = i + 1;
+  RCSwitch::pTransmitTimer->next(RCSwitch::transmitWaveform.durations[i]);
+}
+
+/**
+ * Install a function to be notified when the transmitter becomes active
+ * and inactive. Pass NULL to remove it.
+ */
+void RCSwitch::setTransmitWindowCallback(TransmitWindowCallback pCallback) {
+  RCSwitch::pTransmitWindowCallback = pCallback;
+}
+
+/**
+ * Open the transmit window. Edges seen by the receiver while the window is
+ * open are the echo of our own transmission and are ignored. Unlike
+ * disableReceive(), this keeps the interrupt attached and a received value
+ * available.
+ */
+void RCSwitch::beginTransmitWindow() {
+#if not defined( RCSwitchDisableReceiving )
+  RCSwitch::nTransmitWindowCount++;
+#endif
+  RCSwitch::bTransmitWindow = true;
+  if (RCSwitch::pTransmitWindowCallback != NULL) {
+    RCSwitch::pTransmitWindowCallback(true);
+  }
+}
+
+/**
+ * Close the transmit window. The receiver drops the timings recorded before
+ * the window and starts over with the next edge, so the first complete
+ * code after the transmission is received.
+ */
+void RECEIVE_ATTR RCSwitch::endTransmitWindow() {
+#if not defined( RCSwitchDisableReceiving )
+  RCSwitch::bReceiveResync = true;
+#endif
+  RCSwitch::bTransmitWindow = false;
+  if (RCSwitch::pTransmitWindowCallback != NULL) {
+    RCSwitch::pTransmitWindowCallback(false);
+  }
+}
 
 #if not defined( RCSwitchDisableReceiving )
 /**
@@ -574,6 +1158,7 @@ void RCSwitch::disableReceive() {
 }
 
 bool RCSwitch::available() {
+  this->decodeReceived();
   return RCSwitch::nReceivedValue != 0;
 }
 
@@ -601,15 +1186,225 @@ unsigned int* RCSwitch::getReceivedRawdata() {
   return RCSwitch::timings;
 }
 
+/**
+ * @return the number of edges ignored because they were the echo of our
+ * own transmissions.
+ */
+unsigned long RCSwitch::getSelfEchoCount() {
+  return RCSwitch::nSelfEchoCount;
+}
+
+/**
+ * @return the number of transmissions the receiver was gated for.
+ */
+unsigned long RCSwitch::getTransmitWindowCount() {
+  return RCSwitch::nTransmitWindowCount;
+}
+
+/**
+ * Select where received frames are decoded. By default the protocols are
+ * matched within the interrupt handler at the end of a frame. In deferred
+ * mode the interrupt handler only saves the timings of the frame, and the
+ * protocols are matched by decodeReceived(). This keeps the interrupt
+ * handler short.
+ */
+void RCSwitch::setDeferredDecode(bool bDeferred) {
+  RCSwitch::bDeferredDecode = bDeferred;
+}
+
+/**
+ * Decode the frame saved by the interrupt handler in deferred decode mode.
+ * Called by available(), but can also be called from a task.
+ *
+ * @return true, if a frame has been decoded to a received value.
+ */
+bool RCSwitch::decodeReceived() {
+  const unsigned int changeCount = RCSwitch::nDeferredChangeCount;
+  if (changeCount == 0)
+    return false;
+
+  const bool bDecoded = decodeTimings(RCSwitch::deferredTimings, changeCount, RCSwitch::nDeferredStartLevel);
+  // hand the buffer back to the interrupt handler
+  RCSwitch::nDeferredChangeCount = 0;
+  return bDecoded;
+}
+
+/**
+ * @return the number of frames the protocols have been matched against.
+ */
+unsigned long RCSwitch::getReceivedFrameCount() {
+  return RCSwitch::nReceivedFrameCount;
+}
+
+/**
+ * @return the number of protocols that passed the acceptance windows and
+ * were decoded bit by bit. Divide by getReceivedFrameCount() to get the
+ * average number of protocols tried per frame.
+ */
+unsigned long RCSwitch::getProtocolsTriedCount() {
+  return RCSwitch::nProtocolsTriedCount;
+}
+
+/**
+ * Enable the raw capture mode: frames that no protocol matches are kept
+ * in a ring of RCSWITCH_RAW_FRAMES raw frames, see getRawFrame().
+ * nReceiverPin is the pin the receiver is attached to, its level is
+ * sampled at the end of each sync gap.
+ */
+void RCSwitch::enableRawCapture(int nReceiverPin) {
+  RCSwitch::nRawCapturePin = nReceiverPin;
+}
+
+void RCSwitch::disableRawCapture() {
+  RCSwitch::nRawCapturePin = -1;
+}
+
+/**
+ * @return the number of raw frames captured, at most RCSWITCH_RAW_FRAMES.
+ */
+unsigned int RCSwitch::getRawFrameCount() {
+  return RCSwitch::nRawFrameCount;
+}
+
+/**
+ * Copy a captured raw frame, nIndex 0 is the most recent one.
+ *
+ * @return false, if there is no such frame.
+ */
+bool RCSwitch::getRawFrame(unsigned int nIndex, RawFrame& frame) {
+  uint8_t nVersion;
+  do {
+    // retry if the interrupt handler wrote a frame meanwhile
+    nVersion = RCSwitch::nRawFrameVersion;
+    if (nVersion & 1)
+      continue;
+    if (nIndex >= RCSwitch::nRawFrameCount)
+      return false;
+    const unsigned int nSlot = (RCSwitch::nRawFrameNext + RCSWITCH_RAW_FRAMES - 1 - nIndex) % RCSWITCH_RAW_FRAMES;
+    frame = RCSwitch::rawFrames[nSlot];
+  } while (nVersion != RCSwitch::nRawFrameVersion || (nVersion & 1));
+  return true;
+}
+
+void RCSwitch::clearRawFrames() {
+  RCSwitch::nRawFrameCount = 0;
+}
+
 /* helper function for the receiveProtocol method */
 static inline unsigned int diff(int A, int B) {
   return abs(A - B);
 }
 
+/*
+ * Similarity hash of a frame: each duration is classified as short or
+ * long, relative to the midpoint of the shortest and longest one.
+ * Repetitions of a frame get the same hash despite jitter.
+ */
+static uint32_t RECEIVE_ATTR rawFrameHash(const unsigned int* timings, unsigned int changeCount) {
+  unsigned int nMin = UINT_MAX;
+  unsigned int nMax = 0;
+  for (unsigned int i = 1; i < changeCount; i++) {
+    if (timings[i] < nMin) nMin = timings[i];
+    if (timings[i] > nMax) nMax = timings[i];
+  }
+  const unsigned int nThreshold = nMin + (nMax - nMin) / 2;
+  // FNV-1a
+  uint32_t hash = 2166136261UL;
+  hash = (hash ^ changeCount) * 16777619UL;
+  for (unsigned int i = 1; i < changeCount; i++) {
+    hash = (hash ^ ((timings[i] > nThreshold) ? 1 : 0)) * 16777619UL;
+  }
+  return hash;
+}
+
+/* helper function for captureRawFrame(), durations are limited to 16 bit */
+static inline uint16_t toRawDuration(unsigned int nMicroseconds) {
+  return (nMicroseconds > 0xFFFF) ? 0xFFFF : nMicroseconds;
+}
+
+/**
+ * Add the timings of an unmatched frame to the raw frame ring, or count
+ * a hit if a similar frame is already in there. Frames are similar if
+ * their hashes are equal and all durations are within the receive
+ * tolerance.
+ */
+void RECEIVE_ATTR RCSwitch::captureRawFrame(const unsigned int* timings, unsigned int changeCount, uint8_t nStartLevel) {
+  // a frame that repeats has an even number of durations
+  if (changeCount & 1)
+    return;
+
+  const uint32_t hash = rawFrameHash(timings, changeCount);
+  for (unsigned int n = 0; n < RCSwitch::nRawFrameCount; n++) {
+    RawFrame& frame = RCSwitch::rawFrames[n];
+    if (frame.hash != hash || frame.waveform.count != changeCount || frame.waveform.firstLevel != nStartLevel)
+      continue;
+    bool bSimilar = true;
+    for (unsigned int i = 0; i < changeCount && bSimilar; i++) {
+      // the gap in timings[0] is the last duration of the waveform
+      const unsigned int nKept = frame.waveform.durations[(i == 0) ? (changeCount - 1) : (i - 1)];
+      bSimilar = diff(toRawDuration(timings[i]), nKept) <= nKept * RCSwitch::nReceiveTolerance / 100;
+    }
+    if (bSimilar) {
+      if (frame.hits < 0xFFFF)
+        frame.hits++;
+      return;
+    }
+  }
+
+  RCSwitch::nRawFrameVersion++;
+  RawFrame& frame = RCSwitch::rawFrames[RCSwitch::nRawFrameNext];
+  for (unsigned int i = 1; i < changeCount; i++) {
+    frame.waveform.durations[i - 1] = toRawDuration(timings[i]);
+  }
+  frame.waveform.durations[changeCount - 1] = toRawDuration(timings[0]);
+  frame.waveform.count = changeCount;
+  frame.waveform.firstLevel = nStartLevel;
+  frame.hash = hash;
+  frame.hits = 1;
+  RCSwitch::nRawFrameNext = (RCSwitch::nRawFrameNext + 1) % RCSWITCH_RAW_FRAMES;
+  if (RCSwitch::nRawFrameCount < RCSWITCH_RAW_FRAMES)
+    RCSwitch::nRawFrameCount++;
+  RCSwitch::nRawFrameVersion++;
+}
+
+/**
+ * Match the timings of a frame against all protocols, skipping protocols
+ * whose acceptance windows don't fit. In raw capture mode, frames that
+ * don't match any protocol are captured. nStartLevel is the level of
+ * timings[1].
+ */
+bool RECEIVE_ATTR RCSwitch::decodeTimings(const unsigned int* timings, unsigned int changeCount, uint8_t nStartLevel) {
+  // ignore very short transmissions: no device sends them, so this must be noise
+  if (changeCount <= 7)
+    return false;
+
+  RCSwitch::nReceivedFrameCount++;
+  const unsigned long sync = timings[0];
+  for (unsigned int i = 1; i <= numProto; i++) {
+    const ReceiveFilter& filter = receiveFilters[i-1];
+    if (sync < filter.syncMin || sync > filter.syncMax)
+      continue;
+    const unsigned long high = timings[filter.firstDataTiming];
+    const unsigned long low = timings[filter.firstDataTiming + 1];
+    if (high * 256 < low * filter.ratioMin || (filter.ratioMax != ULONG_MAX && high * 256 > low * filter.ratioMax))
+      continue;
+
+    RCSwitch::nProtocolsTriedCount++;
+    if (receiveProtocol(i, timings, changeCount)) {
+      // receive succeeded for protocol i
+      return true;
+    }
+  }
+  if (RCSwitch::nRawCapturePin >= 0) {
+    captureRawFrame(timings, changeCount, nStartLevel);
+  }
+  return false;
+}
+
 /**
  *
  */
-bool RECEIVE_ATTR RCSwitch::receiveProtocol(const int p, unsigned int changeCount) {
+bool RECEIVE_ATTR RCSwitch::receiveProtocol(const int p, const unsigned int* timings, unsigned int changeCount) {
 #if defined(ESP8266) || defined(ESP32)
     const Protocol &pro = proto[p-1];
 #else
@@ -620,7 +1415,7 @@ bool RECEIVE_ATTR RCSwitch::receiveProtocol(const int p, unsigned int changeCoun
     unsigned long code = 0;
     //Assuming the longer pulse length is the pulse captured in timings[0]
     const unsigned int syncLengthInPulses =  ((pro.syncFactor.low) > (pro.syncFactor.high)) ? (pro.syncFactor.low) : (pro.syncFactor.high);
-    const unsigned int delay = RCSwitch::timings[0] / syncLengthInPulses;
+    const unsigned int delay = timings[0] / syncLengthInPulses;
     const unsigned int delayTolerance = delay * RCSwitch::nReceiveTolerance / 100;
     
     /* For protocols that start low, the sync period looks like
@@ -644,11 +1439,11 @@ bool RECEIVE_ATTR RCSwitch::receiveProtocol(const int p, unsigned int changeCoun
 
     for (unsigned int i = firstDataTiming; i < changeCount - 1; i += 2) {
         code <<= 1;
-        if (diff(RCSwitch::timings[i], delay * pro.zero.high) < delayTolerance &&
-            diff(RCSwitch::timings[i + 1], delay * pro.zero.low) < delayTolerance) {
+        if (diff(timings[i], delay * pro.zero.high) < delayTolerance &&
+            diff(timings[i + 1], delay * pro.zero.low) < delayTolerance) {
             // zero
-        } else if (diff(RCSwitch::timings[i], delay * pro.one.high) < delayTolerance &&
-                   diff(RCSwitch::timings[i + 1], delay * pro.one.low) < delayTolerance) {
+        } else if (diff(timings[i], delay * pro.one.high) < delayTolerance &&
+                   diff(timings[i + 1], delay * pro.one.low) < delayTolerance) {
             // one
             code |= 1;
         } else {
@@ -669,12 +1464,34 @@ bool RECEIVE_ATTR RCSwitch::receiveProtocol(const int p, unsigned int changeCoun
 }
 
 void RECEIVE_ATTR RCSwitch::handleInterrupt() {
+  RCSwitch::handleEdge(micros(), -1);
+}
+
+/*
+ * The work of handleInterrupt() for an edge at 'time'. 'nLevel' is the
+ * level after the edge, -1 to read it from the pin of the raw capture
+ * when it is needed.
+ */
+void RECEIVE_ATTR RCSwitch::handleEdge(long time, int nLevel) {
 
   static unsigned int changeCount = 0;
   static unsigned long lastTime = 0;
   static unsigned int repeatCount = 0;
+  static uint8_t startLevel = LOW;
+
+  if (RCSwitch::bTransmitWindow) {
+    // The edge is the echo of our own transmission.
+    RCSwitch::nSelfEchoCount++;
+    lastTime = time;
+    return;
+  }
+  if (RCSwitch::bReceiveResync) {
+    // The timings recorded before the transmission can't be continued.
+    RCSwitch::bReceiveResync = false;
+    changeCount = 0;
+    repeatCount = 0;
+  }
 
-  const long time = micros();
   const unsigned int duration = time - lastTime;
 
   if (duration > RCSwitch::nSeparationLimit) {
@@ -688,16 +1505,27 @@ void RECEIVE_ATTR RCSwitch::handleInterrupt() {
       // with roughly the same gap between them).
       repeatCount++;
       if (repeatCount == 2) {
-        for(unsigned int i = 1; i <= numProto; i++) {
-          if (receiveProtocol(i, changeCount)) {
-            // receive succeeded for protocol i
-            break;
+        if (RCSwitch::bDeferredDecode) {
+          // leave the decoding to decodeReceived(), drop the frame if
+          // the previous one hasn't been decoded yet
+          if (RCSwitch::nDeferredChangeCount == 0) {
+            for (unsigned int i = 0; i < changeCount; i++) {
+              RCSwitch::deferredTimings[i] = RCSwitch::timings[i];
+            }
+            RCSwitch::nDeferredStartLevel = startLevel;
+            RCSwitch::nDeferredChangeCount = changeCount;
           }
+        } else {
+          decodeTimings(RCSwitch::timings, changeCount, startLevel);
         }
         repeatCount = 0;
       }
     }
     changeCount = 0;
+    if (RCSwitch::nRawCapturePin >= 0) {
+      // the level of the next frame's first duration
+      startLevel = (nLevel >= 0) ? nLevel : digitalRead(RCSwitch::nRawCapturePin);
+    }
   }
  
   // detect overflow
@@ -60,6 +60,20 @@
 // We can handle up to (unsigned long) => 32 bit * 2 H/L changes per bit + 2 for sync
 #define RCSWITCH_MAX_CHANGES 67
 
+// The hardware timer used by sendAsync() on ESP32.
+#if defined(ESP32) && !defined(RCSWITCH_TRANSMIT_TIMER)
+#define RCSWITCH_TRANSMIT_TIMER 0
+#endif
+
+// Number of unknown frames kept by the raw capture mode.
+#if !defined(RCSWITCH_RAW_FRAMES)
+#if defined(ESP8266) || defined(ESP32)
+#define RCSWITCH_RAW_FRAMES 8
+#else
+#define RCSWITCH_RAW_FRAMES 2
+#endif
+#endif
+
 class RCSwitch {
 
   public:
@@ -79,6 +93,60 @@ class RCSwitch {
     void sendTriState(const char* sCodeWord);
     void send(unsigned long code, unsigned int length);
     void send(const char* sCodeWord);
+
+    /**
+     * The address of a PT2262 family switch, decoded from a received
+     * tri-state code word. The inverse of switchOn() and switchOff().
+     */
+    struct SwitchAddress {
+        /* 'A' to 'D', the type of getCodeWordA() to getCodeWordD() */
+        char type;
+        /* Type C: 'a' to 'p', 0 for the other types */
+        char sFamily;
+        /* Type A: the 5 DIP switches, switch 1 in bit 4. Type B, C: 1 to 4. Type D: 1 ('A') to 4 ('D') */
+        int nGroup;
+        /* Type A: the 5 DIP switches like nGroup. Type B, C: 1 to 4. Type D: 1 to 3 */
+        int nDevice;
+        bool bStatus;
+    };
+
+    static bool getTriState(unsigned long code, unsigned int length, char* sCodeWord);
+    static bool decodeCodeWord(const char* sCodeWord, SwitchAddress& address);
+
+    /**
+     * Called from the transmit timer interrupt when sendAsync() has
+     * finished. Keep it short.
+     */
+    typedef void (*TransmitCompleteCallback)();
+
+    /**
+     * A one-shot microsecond timer that drives sendAsync(). start() arms the
+     * timer to expire nMicroseconds from now, next() arms it to expire
+     * nMicroseconds after the previous expiry, so that interrupt latencies
+     * don't add up. On expiry the timer must call handleTransmitTimer().
+     *
+     * On ESP32 a hardware timer is used by default. A simulated timer can be
+     * installed to run the transmit engine on a host.
+     */
+    struct TransmitTimer {
+        void (*start)(unsigned int nMicroseconds);
+        void (*next)(unsigned int nMicroseconds);
+    };
+
+    /**
+     * Called with true right before the transmitter starts sending and with
+     * false right after it has finished, possibly from interrupt context.
+     * Allows to gate a receiver other than this one, e.g. with
+     * RcSwitchReceiver::beginTransmitWindow()/endTransmitWindow().
+     */
+    typedef void (*TransmitWindowCallback)(bool bActive);
+
+    bool sendAsync(unsigned long code, unsigned int length);
+    bool isBusy();
+    void setTransmitCompleteCallback(TransmitCompleteCallback pCallback);
+    static void setTransmitTimer(const TransmitTimer* pTimer);
+    static void setTransmitWindowCallback(TransmitWindowCallback pCallback);
+    static void handleTransmitTimer();
     
     #if not defined( RCSwitchDisableReceiving )
     void enableReceive(int interrupt);
@@ -92,6 +160,12 @@ class RCSwitch {
     unsigned int getReceivedDelay();
     unsigned int getReceivedProtocol();
     unsigned int* getReceivedRawdata();
+    unsigned long getSelfEchoCount();
+    unsigned long getTransmitWindowCount();
+    void setDeferredDecode(bool bDeferred);
+    bool decodeReceived();
+    unsigned long getReceivedFrameCount();
+    unsigned long getProtocolsTriedCount();
     #endif
   
     void enableTransmit(int nTransmitterPin);
@@ -148,16 +222,69 @@ class RCSwitch {
     void setProtocol(int nProtocol);
     void setProtocol(int nProtocol, int nPulseLength);
 
+    /**
+     * A precompiled frame: the durations in microseconds of the alternating
+     * transmitter levels, starting with firstLevel. Durations are limited
+     * to 65535 microseconds.
+     *
+     * Compile a code once with compileWaveform() and replay it as often as
+     * needed with sendWaveform() or sendWaveformAsync(). Replaying does
+     * not look at the protocol or the code bits anymore.
+     */
+    struct Waveform {
+        uint16_t durations[RCSWITCH_MAX_CHANGES];
+        uint8_t count;
+        uint8_t firstLevel;
+    };
+
+    void compileWaveform(unsigned long code, unsigned int length, Waveform& waveform) const;
+    void sendWaveform(const Waveform& waveform);
+    bool sendWaveformAsync(const Waveform& waveform);
+    static void stretchWaveform(Waveform& waveform, unsigned int nPercent);
+    static unsigned int normalizeWaveform(Waveform& waveform);
+
+    #if not defined( RCSwitchDisableReceiving )
+    /**
+     * A frame no protocol matched, as captured by the raw capture mode.
+     * The waveform starts with the first level after the sync gap and
+     * ends with the gap, so it can be replayed with sendWaveform().
+     * Repeated receptions of a similar frame are counted in hits.
+     */
+    struct RawFrame {
+        Waveform waveform;
+        uint32_t hash;
+        uint16_t hits;
+    };
+
+    void enableRawCapture(int nReceiverPin);
+    void disableRawCapture();
+    unsigned int getRawFrameCount();
+    bool getRawFrame(unsigned int nIndex, RawFrame& frame);
+    void clearRawFrames();
+    #endif
+
   private:
+    friend class RCSwitch_test;
+    friend class RCSwitch_benchmark;
+
     char* getCodeWordA(const char* sGroup, const char* sDevice, bool bStatus);
     char* getCodeWordB(int nGroupNumber, int nSwitchNumber, bool bStatus);
     char* getCodeWordC(char sFamily, int nGroup, int nDevice, bool bStatus);
     char* getCodeWordD(char group, int nDevice, bool bStatus);
+    static bool decodeCodeWordA(const char* sCodeWord, SwitchAddress& address);
+    static bool decodeCodeWordB(const char* sCodeWord, SwitchAddress& address);
+    static bool decodeCodeWordC(const char* sCodeWord, SwitchAddress& address);
+    static bool decodeCodeWordD(const char* sCodeWord, SwitchAddress& address);
     void transmit(HighLow pulses);
+    static void beginTransmitWindow();
+    static void endTransmitWindow();
 
     #if not defined( RCSwitchDisableReceiving )
     static void handleInterrupt();
-    static bool receiveProtocol(const int p, unsigned int changeCount);
+    static void handleEdge(long time, int nLevel);
+    static bool receiveProtocol(const int p, const unsigned int* timings, unsigned int changeCount);
+    static bool decodeTimings(const unsigned int* timings, unsigned int changeCount, uint8_t nStartLevel);
+    static void captureRawFrame(const unsigned int* timings, unsigned int changeCount, uint8_t nStartLevel);
     int nReceiverInterrupt;
     #endif
     int nTransmitterPin;
@@ -165,6 +292,26 @@ class RCSwitch {
     
     Protocol protocol;
 
+    /*
+     * State of the transmission started by sendAsync(). There is only
+     * one transmit timer, hence only one transmission at a time.
+     * transmitWaveform holds the frame being played.
+     */
+    static const TransmitTimer* pTransmitTimer;
+    static TransmitCompleteCallback pTransmitCompleteCallback;
+    static Waveform transmitWaveform;
+    static volatile unsigned int nTransmitPulseIndex;
+    static volatile int nTransmitRepeatsLeft;
+    static int nTransmitPin;
+    static volatile bool bTransmitBusy;
+
+    /*
+     * While the transmitter is active, the receiver ignores the edges,
+     * they are the echo of our own transmission.
+     */
+    static TransmitWindowCallback pTransmitWindowCallback;
+    static volatile bool bTransmitWindow;
+
     #if not defined( RCSwitchDisableReceiving )
     static int nReceiveTolerance;
     volatile static unsigned long nReceivedValue;
@@ -172,10 +319,40 @@ class RCSwitch {
     volatile static unsigned int nReceivedDelay;
     volatile static unsigned int nReceivedProtocol;
     const static unsigned int nSeparationLimit;
+    volatile static bool bReceiveResync;
+    volatile static unsigned long nSelfEchoCount;
+    static unsigned long nTransmitWindowCount;
     /* 
      * timings[0] contains sync timing, followed by a number of bits
      */
     static unsigned int timings[RCSWITCH_MAX_CHANGES];
+
+    /*
+     * In deferred decode mode the interrupt handler only copies timings[]
+     * into deferredTimings[] and leaves the protocol matching to
+     * decodeReceived(). A non-zero nDeferredChangeCount marks the copy as
+     * pending, the interrupt handler doesn't touch it until it is decoded.
+     */
+    volatile static bool bDeferredDecode;
+    static unsigned int deferredTimings[RCSWITCH_MAX_CHANGES];
+    volatile static unsigned int nDeferredChangeCount;
+    volatile static uint8_t nDeferredStartLevel;
+
+    /* frames handed to decodeTimings() and protocols tried on them */
+    volatile static unsigned long nReceivedFrameCount;
+    volatile static unsigned long nProtocolsTriedCount;
+
+    /*
+     * Ring of the frames captured in raw capture mode, rawFrames[nRawFrameNext]
+     * is overwritten next. The interrupt handler samples nRawCapturePin at
+     * the end of a sync gap for the level the frame starts with. While it
+     * writes a frame, nRawFrameVersion is odd.
+     */
+    volatile static int nRawCapturePin;
+    static RawFrame rawFrames[RCSWITCH_RAW_FRAMES];
+    volatile static unsigned int nRawFrameNext;
+    volatile static unsigned int nRawFrameCount;
+    volatile static uint8_t nRawFrameVersion;
     #endif
 
     
@@ -0,0 +1,229 @@
+/*
+  RCSwitch - Arduino libary for remote control outlet switches
+  Copyright (c) 2011 Suat Özgür.  All right reserved.
+
+  Project home: https://github.com/sui77/rc-switch/
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "RCSwitch_benchmark.h"
+
+#if ENABLE_RCSWITCH_BENCHMARK && not defined( RCSwitchDisableReceiving )
+
+#include <stdio.h>
+
+/** Call RCSwitch_benchmark::theBenchmark.run() to execute benchmarks. */
+RCSwitch_benchmark RCSwitch_benchmark::theBenchmark;
+
+static const unsigned int nRounds = 64;
+static const unsigned int nFramesPerRound = 16;
+static const unsigned long benchmarkCode = 0x5A5A5A;
+static const unsigned int nBenchmarkLength = 24;
+static const int nBenchmarkProtocols = 12;
+
+/* Keeps the compiler from dropping the encoded durations */
+static volatile uint32_t nSink = 0;
+
+/* The simulated transmit timer, the engine is stepped by the benchmark */
+static void ignoreDuration(unsigned int nMicroseconds) {
+  (void)nMicroseconds;
+}
+
+static const RCSwitch::TransmitTimer steppedTimer = { &ignoreDuration, &ignoreDuration };
+
+static uint32_t toNanoseconds(uint32_t nTicks, uint32_t nTicksPerMicrosecond) {
+  return (uint64_t)nTicks * 1000 / nTicksPerMicrosecond;
+}
+
+/*
+ * The duration of pulse 'nPulse' of a frame, looked up bit by bit like
+ * send() and transmit() do it.
+ */
+static unsigned int bitwiseDuration(const RCSwitch::Protocol& protocol, unsigned long code, unsigned int length, unsigned int nPulse) {
+  const unsigned int nBit = nPulse / 2;
+  const RCSwitch::HighLow& pulses = (nBit >= length) ? protocol.syncFactor
+    : (code & (1L << (length - 1 - nBit))) ? protocol.one : protocol.zero;
+  return protocol.pulseLength * ((nPulse & 1) ? pulses.low : pulses.high);
+}
+
+void RCSwitch_benchmark::benchmarkEncode(RCSwitch& tx, Result& result, TickCounter ticks, uint32_t nTicksPerMicrosecond) {
+  const unsigned int nPulses = 2 * nBenchmarkLength + 2;
+  uint32_t nBestBitwise = UINT32_MAX;
+  uint32_t nBestCompile = UINT32_MAX;
+  RCSwitch::Waveform waveform;
+
+  for (unsigned int nRound = 0; nRound < nRounds; nRound++) {
+    uint32_t nStart = ticks();
+    for (unsigned int nFrame = 0; nFrame < nFramesPerRound; nFrame++) {
+      uint32_t nSum = 0;
+      for (unsigned int nPulse = 0; nPulse < nPulses; nPulse++) {
+        nSum += bitwiseDuration(tx.protocol, benchmarkCode + nFrame, nBenchmarkLength, nPulse);
+      }
+      nSink = nSum;
+    }
+    const uint32_t nBitwise = ticks() - nStart;
+
+    nStart = ticks();
+    for (unsigned int nFrame = 0; nFrame < nFramesPerRound; nFrame++) {
+      tx.compileWaveform(benchmarkCode + nFrame, nBenchmarkLength, waveform);
+      nSink = waveform.durations[nFrame];
+    }
+    const uint32_t nCompile = ticks() - nStart;
+
+    if (nBitwise < nBestBitwise) nBestBitwise = nBitwise;
+    if (nCompile < nBestCompile) nBestCompile = nCompile;
+  }
+  result.nsEncodeBitwise = toNanoseconds(nBestBitwise, nTicksPerMicrosecond) / nFramesPerRound;
+  result.nsEncodeCompile = toNanoseconds(nBestCompile, nTicksPerMicrosecond) / nFramesPerRound;
+}
+
+/* helper function for benchmarkEdgeJitter(), the spread of the minimum times */
+static uint32_t spread(const uint32_t* nTicks, unsigned int nCount) {
+  uint32_t nMin = UINT32_MAX;
+  uint32_t nMax = 0;
+  for (unsigned int i = 0; i < nCount; i++) {
+    if (nTicks[i] < nMin) nMin = nTicks[i];
+    if (nTicks[i] > nMax) nMax = nTicks[i];
+  }
+  return (nCount == 0) ? 0 : nMax - nMin;
+}
+
+void RCSwitch_benchmark::benchmarkEdgeJitter(RCSwitch& tx, Result& result, TickCounter ticks, uint32_t nTicksPerMicrosecond) {
+  const unsigned int nPulses = 2 * nBenchmarkLength + 2;
+  // the best time of each edge over all rounds
+  uint32_t nEdgeTicks[RCSWITCH_MAX_CHANGES + 1];
+  RCSwitch::Waveform waveform;
+  tx.compileWaveform(benchmarkCode, nBenchmarkLength, waveform);
+
+  // send() computes the next duration and sets the level at each edge
+  for (unsigned int i = 0; i < nPulses; i++) {
+    nEdgeTicks[i] = UINT32_MAX;
+  }
+  for (unsigned int nRound = 0; nRound < nRounds; nRound++) {
+    for (unsigned int nPulse = 0; nPulse < nPulses; nPulse++) {
+      const uint32_t nStart = ticks();
+      digitalWrite(tx.nTransmitterPin, (nPulse & 1) ? LOW : HIGH);
+      nSink = bitwiseDuration(tx.protocol, benchmarkCode, nBenchmarkLength, nPulse);
+      const uint32_t nTicks = ticks() - nStart;
+      if (nTicks < nEdgeTicks[nPulse]) nEdgeTicks[nPulse] = nTicks;
+    }
+  }
+  result.nsEdgeJitterBitwise = toNanoseconds(spread(nEdgeTicks, nPulses), nTicksPerMicrosecond);
+
+  // handleTransmitTimer() sets the level and arms the timer from the waveform
+  const RCSwitch::TransmitTimer* pTimer = RCSwitch::pTransmitTimer;
+  RCSwitch::setTransmitTimer(&steppedTimer);
+  tx.setRepeatTransmit(1);
+  for (unsigned int i = 0; i < waveform.count; i++) {
+    nEdgeTicks[i] = UINT32_MAX;
+  }
+  for (unsigned int nRound = 0; nRound < nRounds; nRound++) {
+    tx.sendWaveformAsync(waveform);
+    // the first edge is set by sendWaveformAsync(), the last one ends the frame
+    for (unsigned int nEdge = 0; tx.isBusy(); nEdge++) {
+      const uint32_t nStart = ticks();
+      RCSwitch::handleTransmitTimer();
+      const uint32_t nTicks = ticks() - nStart;
+      if (nTicks < nEdgeTicks[nEdge]) nEdgeTicks[nEdge] = nTicks;
+    }
+  }
+  RCSwitch::setTransmitTimer(pTimer);
+  // the last call ends the transmission, it doesn't start a pulse
+  result.nsEdgeJitterWaveform = toNanoseconds(spread(nEdgeTicks, waveform.count - 1), nTicksPerMicrosecond);
+}
+
+/*
+ * The timings handleInterrupt() holds when the sync gap after a frame
+ * ends: the previous sync gap first, then the frame.
+ *
+ * @return the number of timings
+ */
+static unsigned int frameTimings(const RCSwitch::Waveform& waveform, unsigned int* timings, uint8_t& nStartLevel) {
+  unsigned int nGap = 0;
+  for (unsigned int i = 1; i < waveform.count; i++) {
+    if (waveform.durations[i] > waveform.durations[nGap]) nGap = i;
+  }
+  for (unsigned int i = 0; i < waveform.count; i++) {
+    timings[i] = waveform.durations[(nGap + i) % waveform.count];
+  }
+  const unsigned int nStart = (nGap + 1) % waveform.count;
+  nStartLevel = (nStart & 1) ? !waveform.firstLevel : waveform.firstLevel;
+  return waveform.count;
+}
+
+/**
+ * Time the legacy decoder on a 24 bit frame of each protocol. Public, so
+ * that other receivers can be compared on the same frames.
+ */
+void RCSwitch_benchmark::benchmarkDecode(Result& result, TickCounter ticks, uint32_t nTicksPerMicrosecond) {
+  RCSwitch tx;
+  RCSwitch::Waveform waveform;
+  unsigned int timings[RCSWITCH_MAX_CHANGES];
+  uint32_t nWorstTicks = 0;
+  uint32_t nTotalTicks = 0;
+
+  result.nDecodedProtocols = 0;
+  for (int nProtocol = 1; nProtocol <= nBenchmarkProtocols; nProtocol++) {
+    tx.setProtocol(nProtocol);
+    tx.compileWaveform(benchmarkCode, nBenchmarkLength, waveform);
+    uint8_t nStartLevel;
+    const unsigned int nCount = frameTimings(waveform, timings, nStartLevel);
+
+    uint32_t nBestTicks = UINT32_MAX;
+    bool bDecoded = false;
+    for (unsigned int nRound = 0; nRound < nRounds; nRound++) {
+      const uint32_t nStart = ticks();
+      bDecoded = RCSwitch::decodeTimings(timings, nCount, nStartLevel);
+      const uint32_t nTicks = ticks() - nStart;
+      if (nTicks < nBestTicks) nBestTicks = nTicks;
+    }
+    if (bDecoded && RCSwitch::nReceivedValue == benchmarkCode) {
+      result.nDecodedProtocols++;
+    }
+    RCSwitch::nReceivedValue = 0;
+
+    if (nBestTicks > nWorstTicks) nWorstTicks = nBestTicks;
+    nTotalTicks += nBestTicks;
+  }
+  result.nsDecodeWorst = toNanoseconds(nWorstTicks, nTicksPerMicrosecond);
+  result.nsDecodeMean = toNanoseconds(nTotalTicks, nTicksPerMicrosecond) / nBenchmarkProtocols;
+}
+
+void RCSwitch_benchmark::run(int nTransmitterPin, Result& result, TickCounter ticks, uint32_t nTicksPerMicrosecond) const {
+  RCSwitch tx;
+  tx.enableTransmit(nTransmitterPin);
+  tx.setProtocol(1);
+
+  benchmarkEncode(tx, result, ticks, nTicksPerMicrosecond);
+  benchmarkEdgeJitter(tx, result, ticks, nTicksPerMicrosecond);
+  benchmarkDecode(result, ticks, nTicksPerMicrosecond);
+}
+
+void RCSwitch_benchmark::print(const Result& result, Print& out) {
+  char buffer[256];
+  const int n = snprintf(buffer, sizeof(buffer),
+    "Encode per frame: bitwise %lu ns, compile %lu ns\r\n"
+    "Edge jitter: bitwise %lu ns, waveform %lu ns\r\n"
+    "Decode at the sync gap: %lu ns worst, %lu ns mean, %u of 12 protocols decoded\r\n",
+    (unsigned long)result.nsEncodeBitwise, (unsigned long)result.nsEncodeCompile,
+    (unsigned long)result.nsEdgeJitterBitwise, (unsigned long)result.nsEdgeJitterWaveform,
+    (unsigned long)result.nsDecodeWorst, (unsigned long)result.nsDecodeMean, result.nDecodedProtocols);
+  if (n > 0) {
+    out.write((const uint8_t*)buffer, (n < (int)sizeof(buffer)) ? n : sizeof(buffer) - 1);
+  }
+}
+
+#endif
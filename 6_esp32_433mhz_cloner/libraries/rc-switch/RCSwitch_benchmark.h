@@ -0,0 +1,87 @@
+/*
+  RCSwitch - Arduino libary for remote control outlet switches
+  Copyright (c) 2011 Suat Özgür.  All right reserved.
+
+  Project home: https://github.com/sui77/rc-switch/
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#ifndef _RCSwitch_benchmark_h
+#define _RCSwitch_benchmark_h
+
+#if !defined(ENABLE_RCSWITCH_BENCHMARK)
+#define ENABLE_RCSWITCH_BENCHMARK true
+#endif
+
+#if ENABLE_RCSWITCH_BENCHMARK && not defined( RCSwitchDisableReceiving )
+
+#include "RCSwitch.h"
+
+/**
+ * Benchmarks of the transmit engine and the interrupt driven decoder.
+ * Like RCSwitch_test, they run on the simulated transmit timer, on the
+ * device as well as on a host.
+ *
+ * Times are taken with a free running tick counter passed to run(), e.g.
+ * the CPU cycle counter on the device or a nanosecond clock on a host.
+ * Each time is the minimum over several rounds, which filters out
+ * interrupts and host scheduling.
+ *
+ * The transmitter pin passed to run() is toggled, so it must not have a
+ * transmitter attached.
+ */
+class RCSwitch_benchmark {
+  public:
+    typedef uint32_t (*TickCounter)();
+
+    struct Result {
+        /*
+         * Time to lay out the pulses of one 24 bit frame. send() does it
+         * bit by bit for every repeat. A stored signal is compiled once by
+         * compileWaveform() and replayed without encoding.
+         */
+        uint32_t nsEncodeBitwise;
+        uint32_t nsEncodeCompile;
+        /*
+         * Spread of the work done per edge, i.e. the jitter the engine adds
+         * to the edges: bit by bit like send(), and playing a waveform in
+         * handleTransmitTimer().
+         */
+        uint32_t nsEdgeJitterBitwise;
+        uint32_t nsEdgeJitterWaveform;
+        /*
+         * The work handleInterrupt() does at the sync gap that ends a
+         * frame, i.e. its worst case: decodeTimings() on a 24 bit frame of
+         * each protocol. The edges within a frame take a fraction of it.
+         */
+        uint32_t nsDecodeWorst;
+        uint32_t nsDecodeMean;
+        unsigned int nDecodedProtocols;
+    };
+
+    void run(int nTransmitterPin, Result& result, TickCounter ticks, uint32_t nTicksPerMicrosecond) const;
+    static void print(const Result& result, Print& out);
+    static void benchmarkDecode(Result& result, TickCounter ticks, uint32_t nTicksPerMicrosecond);
+
+    static RCSwitch_benchmark theBenchmark;
+
+  private:
+    static void benchmarkEncode(RCSwitch& tx, Result& result, TickCounter ticks, uint32_t nTicksPerMicrosecond);
+    static void benchmarkEdgeJitter(RCSwitch& tx, Result& result, TickCounter ticks, uint32_t nTicksPerMicrosecond);
+};
+
+#endif
+
+#endif
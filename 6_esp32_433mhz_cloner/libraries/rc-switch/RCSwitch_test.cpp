@@ -0,0 +1,416 @@
+/*
+  RCSwitch - Arduino libary for remote control outlet switches
+  Copyright (c) 2011 Suat Özgür.  All right reserved.
+
+  Project home: https://github.com/sui77/rc-switch/
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "RCSwitch_test.h"
+
+#if ENABLE_RCSWITCH_WAVEFORM_TEST && not defined( RCSwitchDisableReceiving )
+
+#include <assert.h>
+#include <string.h>
+
+/** Call RCSwitch_test::theTest.run() to execute tests. */
+RCSwitch_test RCSwitch_test::theTest;
+
+/*
+ * The simulated transmit timer doesn't wait, it records the durations
+ * the transmit engine arms it with.
+ */
+static uint16_t txDurations[4 * RCSWITCH_MAX_CHANGES];
+static unsigned int nTxDurationCount = 0;
+
+/* The time of the simulated receiver, it advances with the edges */
+static unsigned long nRxMicros = 0;
+
+static void recordDuration(unsigned int nMicroseconds) {
+  assert(nTxDurationCount < sizeof(txDurations) / sizeof(txDurations[0]));
+  txDurations[nTxDurationCount++] = nMicroseconds;
+}
+
+static const RCSwitch::TransmitTimer simulatedTimer = { &recordDuration, &recordDuration };
+
+static unsigned int nTransmitCompleteCount = 0;
+
+static void countTransmitComplete() {
+  nTransmitCompleteCount++;
+}
+
+/* A protocol none of the built-in ones matches */
+static const RCSwitch::Protocol unknownProtocol = { 150, { 1, 100 }, { 1, 8 }, { 8, 1 }, false };
+static const RCSwitch::Protocol unknownInvertedProtocol = { 150, { 1, 100 }, { 1, 8 }, { 8, 1 }, true };
+
+/* Play a waveform nRepeat times on the simulated timer */
+void RCSwitch_test::transmit(RCSwitch& tx, const RCSwitch::Waveform& waveform, int nRepeat) {
+  const RCSwitch::TransmitTimer* pTimer = RCSwitch::pTransmitTimer;
+  RCSwitch::setTransmitTimer(&simulatedTimer);
+  tx.setRepeatTransmit(nRepeat);
+
+  nTxDurationCount = 0;
+  assert(tx.sendWaveformAsync(waveform));
+  while (tx.isBusy()) {
+    RCSwitch::handleTransmitTimer();
+  }
+  RCSwitch::setTransmitTimer(pTimer);
+}
+
+/*
+ * Feed the recorded durations to the interrupt handler, an edge at the
+ * start and one at the end of each duration. Levels alternate, starting
+ * with nFirstLevel. The receiver was idle before, so the handler
+ * synchronizes on the first sync gap and decodes every second frame
+ * from the second one on.
+ */
+void RCSwitch_test::receive(uint8_t nFirstLevel) {
+  uint8_t level = nFirstLevel;
+  nRxMicros += 100000;
+  RCSwitch::handleEdge(nRxMicros, level);
+  for (unsigned int i = 0; i < nTxDurationCount; i++) {
+    nRxMicros += txDurations[i];
+    level = !level;
+    RCSwitch::handleEdge(nRxMicros, level);
+  }
+}
+
+bool RCSwitch_test::equal(const RCSwitch::Waveform& a, const RCSwitch::Waveform& b) {
+  if (a.count != b.count || a.firstLevel != b.firstLevel)
+    return false;
+  for (unsigned int i = 0; i < a.count; i++) {
+    if (a.durations[i] != b.durations[i])
+      return false;
+  }
+  return true;
+}
+
+void RCSwitch_test::testAsyncTransmit(RCSwitch& tx) const {
+  RCSwitch::Waveform waveform;
+  tx.setProtocol(1);
+  tx.compileWaveform(0x123, 12, waveform);
+  assert(waveform.count == 2 * 12 + 2);
+  tx.setTransmitCompleteCallback(&countTransmitComplete);
+  nTransmitCompleteCount = 0;
+
+  // the timer is armed with every duration, frame after frame
+  transmit(tx, waveform, 3);
+  assert(nTxDurationCount == 3 * waveform.count);
+  for (unsigned int i = 0; i < nTxDurationCount; i++) {
+    assert(txDurations[i] == waveform.durations[i % waveform.count]);
+  }
+  assert(nTransmitCompleteCount == 1);
+  assert(!tx.isBusy());
+
+  // a second transmission is refused until the first one is done
+  const RCSwitch::TransmitTimer* pTimer = RCSwitch::pTransmitTimer;
+  RCSwitch::setTransmitTimer(&simulatedTimer);
+  nTxDurationCount = 0;
+  assert(tx.sendWaveformAsync(waveform));
+  assert(tx.isBusy());
+  assert(!tx.sendWaveformAsync(waveform));
+  assert(!tx.sendAsync(0x123, 12));
+  while (tx.isBusy()) {
+    RCSwitch::handleTransmitTimer();
+  }
+  RCSwitch::setTransmitTimer(pTimer);
+  assert(nTxDurationCount == 3 * waveform.count);
+  assert(nTransmitCompleteCount == 2);
+
+  // nothing to send completes at once
+  transmit(tx, waveform, 0);
+  assert(nTxDurationCount == 0);
+  assert(nTransmitCompleteCount == 3);
+  RCSwitch::Waveform empty;
+  empty.count = 0;
+  empty.firstLevel = HIGH;
+  transmit(tx, empty, 3);
+  assert(nTxDurationCount == 0);
+  assert(nTransmitCompleteCount == 4);
+
+  // a code has at most 32 bits, a longer frame compiles to nothing
+  tx.compileWaveform(0xFFFFFFFF, 32, waveform);
+  assert(waveform.count == 2 * 32 + 2);
+  assert(waveform.durations[0] == 3 * 350);
+  tx.compileWaveform(0x123, 66, waveform);
+  assert(waveform.count == 0);
+  transmit(tx, waveform, 3);
+  assert(nTxDurationCount == 0);
+  assert(nTransmitCompleteCount == 5);
+
+  tx.setTransmitCompleteCallback(NULL);
+}
+
+void RCSwitch_test::testProtocolRoundTrip(RCSwitch& tx) const {
+  // Protocol 4 can't be received, its sync gap is below nSeparationLimit.
+  // Protocol 9 is taken for protocol 8, and some others for an earlier
+  // protocol with the same timings, hence only the value is checked.
+  static const int protocols[] = { 1, 2, 3, 5, 6, 7, 8, 10, 11, 12 };
+  for (unsigned int n = 0; n < sizeof(protocols) / sizeof(protocols[0]); n++) {
+    RCSwitch::Waveform waveform;
+    tx.setProtocol(protocols[n]);
+    tx.compileWaveform(0x5A5A5A, 24, waveform);
+    RCSwitch::nReceivedValue = 0;
+    transmit(tx, waveform, 3);
+    receive(waveform.firstLevel);
+    assert(RCSwitch::nReceivedValue == 0x5A5A5A);
+    assert(RCSwitch::nReceivedBitlength == 24);
+    // a decoded frame is not captured
+    assert(RCSwitch::nRawFrameCount == 0);
+  }
+  RCSwitch::nReceivedValue = 0;
+}
+
+void RCSwitch_test::testRawRoundTrip(RCSwitch& tx) const {
+  RCSwitch::Waveform waveform;
+  RCSwitch::RawFrame frame;
+
+  tx.setProtocol(unknownProtocol);
+  tx.compileWaveform(0xA5A5, 16, waveform);
+  transmit(tx, waveform, 6);
+  receive(waveform.firstLevel);
+  // the frames decoded after the first one are hits of the same raw frame
+  assert(RCSwitch::nRawFrameCount == 1);
+  assert(tx.getRawFrame(0, frame));
+  assert(frame.hits == 3);
+  assert(equal(frame.waveform, waveform));
+
+  // captured a second time, the waveform must not change
+  transmit(tx, frame.waveform, 2);
+  receive(frame.waveform.firstLevel);
+  assert(RCSwitch::nRawFrameCount == 1);
+  assert(tx.getRawFrame(0, frame));
+  assert(frame.hits == 4);
+  assert(equal(frame.waveform, waveform));
+
+  tx.setProtocol(unknownInvertedProtocol);
+  tx.compileWaveform(0xA5A5, 16, waveform);
+  transmit(tx, waveform, 2);
+  receive(waveform.firstLevel);
+  assert(tx.getRawFrame(0, frame));
+  assert(frame.waveform.firstLevel == LOW);
+  assert(equal(frame.waveform, waveform));
+}
+
+void RCSwitch_test::testStretch(RCSwitch& tx) const {
+  RCSwitch::Waveform waveform;
+  RCSwitch::RawFrame frame;
+
+  tx.setProtocol(unknownProtocol);
+  tx.compileWaveform(0x1234, 16, waveform);
+  RCSwitch::stretchWaveform(waveform, 110);
+  assert(waveform.durations[waveform.count - 1] == 16500);
+  transmit(tx, waveform, 2);
+  receive(waveform.firstLevel);
+  assert(tx.getRawFrame(0, frame));
+  assert(equal(frame.waveform, waveform));
+  assert(RCSwitch::normalizeWaveform(frame.waveform) == 165);
+  assert(equal(frame.waveform, waveform));
+}
+
+void RCSwitch_test::testNormalize(RCSwitch& tx) const {
+  RCSwitch::Waveform ideal;
+  RCSwitch::Waveform jittered;
+  RCSwitch::RawFrame frame;
+
+  tx.setProtocol(unknownProtocol);
+  tx.compileWaveform(0x4321, 16, ideal);
+  // the receiver adds some tens of microseconds to the edges
+  static const int jitter[] = { 20, -15, 30, -25, 20, -30 };
+  jittered = ideal;
+  for (unsigned int i = 0; i < jittered.count; i++) {
+    jittered.durations[i] += jitter[i % (sizeof(jitter) / sizeof(jitter[0]))];
+  }
+  transmit(tx, jittered, 2);
+  receive(jittered.firstLevel);
+  assert(tx.getRawFrame(0, frame));
+  assert(equal(frame.waveform, jittered));
+  assert(RCSwitch::normalizeWaveform(frame.waveform) == 150);
+  assert(equal(frame.waveform, ideal));
+
+  // protocol 3 has no data duration as short as its clock
+  tx.setProtocol(3);
+  tx.compileWaveform(0x4321, 16, ideal);
+  jittered = ideal;
+  assert(RCSwitch::normalizeWaveform(jittered) == 100);
+  assert(equal(jittered, ideal));
+
+  // a zero duration fits no clock, the waveform is left unchanged
+  jittered.durations[3] = 0;
+  RCSwitch::Waveform zero = jittered;
+  assert(RCSwitch::normalizeWaveform(jittered) == 0);
+  assert(equal(jittered, zero));
+}
+
+/* The code sendTriState() sends for a code word */
+unsigned long RCSwitch_test::triStateCode(const char* sCodeWord) {
+  unsigned long code = 0;
+  for (const char* p = sCodeWord; *p; p++) {
+    code = (code << 2) | (*p == '1' ? 3 : *p == 'F' ? 1 : 0);
+  }
+  return code;
+}
+
+/* Decode the received code of a code word back to its switch address */
+void RCSwitch_test::assertAddress(const char* sCodeWord, char type, char sFamily, int nGroup, int nDevice, bool bStatus) {
+  char sReceived[13];
+  RCSwitch::SwitchAddress address;
+  assert(RCSwitch::getTriState(triStateCode(sCodeWord), 24, sReceived));
+  assert(strcmp(sReceived, sCodeWord) == 0);
+  assert(RCSwitch::decodeCodeWord(sReceived, address));
+  assert(address.type == type);
+  assert(address.sFamily == sFamily);
+  assert(address.nGroup == nGroup);
+  assert(address.nDevice == nDevice);
+  assert(address.bStatus == bStatus);
+}
+
+void RCSwitch_test::testTriState(RCSwitch& tx) const {
+  char sCodeWord[17];
+  RCSwitch::SwitchAddress address;
+
+  assert(RCSwitch::getTriState(0x07, 8, sCodeWord));
+  assert(strcmp(sCodeWord, "00F1") == 0);
+  assert(RCSwitch::getTriState(0xFFFFFFFFUL, 32, sCodeWord));
+  assert(strcmp(sCodeWord, "1111111111111111") == 0);
+  // pair 10 in the middle and in the highest symbol
+  assert(!RCSwitch::getTriState(0x08, 8, sCodeWord));
+  assert(sCodeWord[0] == '\0');
+  assert(!RCSwitch::getTriState(0x800000, 24, sCodeWord));
+  // bits above the length are not looked at
+  assert(RCSwitch::getTriState(0x200001, 4, sCodeWord));
+  assert(strcmp(sCodeWord, "0F") == 0);
+  assert(!RCSwitch::getTriState(0x01, 3, sCodeWord));
+  assert(!RCSwitch::getTriState(0, 0, sCodeWord));
+
+  // every type round trips through its encoder
+  assertAddress(tx.getCodeWordA("11011", "10000", true), 'A', 0, 0x1B, 0x10, true);
+  assertAddress(tx.getCodeWordA("00001", "01011", false), 'A', 0, 0x01, 0x0B, false);
+  assertAddress(tx.getCodeWordB(2, 3, true), 'B', 0, 2, 3, true);
+  assertAddress(tx.getCodeWordB(4, 1, false), 'B', 0, 4, 1, false);
+  assertAddress(tx.getCodeWordC('k', 3, 2, true), 'C', 'k', 3, 2, true);
+  assertAddress(tx.getCodeWordC('a', 1, 4, false), 'C', 'a', 1, 4, false);
+  assertAddress(tx.getCodeWordD('C', 1, true), 'D', 0, 3, 1, true);
+  assertAddress(tx.getCodeWordD('a', 3, false), 'D', 0, 1, 3, false);
+
+  // fits type A and C, C has more fixed symbols
+  assertAddress(tx.getCodeWordA("00001", "01010", false), 'C', 'p', 3, 3, false);
+
+  // no switch address
+  assert(!RCSwitch::decodeCodeWord("0F0F", address));
+  assert(!RCSwitch::decodeCodeWord("0000000000FF", address));
+  assert(!RCSwitch::decodeCodeWord("1FFF1FF00011", address));
+  assert(!RCSwitch::decodeCodeWord("0F0F0F0F01F0", address));
+}
+
+/*
+ * Decode every frame of the corpus with the prefilter of decodeTimings()
+ * and by trying all protocols in order like the decoder did before. Both
+ * must give the same result.
+ */
+RCSwitch_test::CorpusResult RCSwitch_test::corpus(unsigned int nRounds) const {
+  static const unsigned long codes[] = { 0x5A5A5A, 0x123456, 0xFFFFF0, 0x0F0F0F };
+  static const int nProtocols = 12;
+  RCSwitch tx;
+  RCSwitch::Waveform waveform;
+  unsigned int timings[RCSWITCH_MAX_CHANGES];
+  uint32_t nRandom = 1;
+  unsigned long nTriedUnfiltered = 0;
+  CorpusResult result = { 0, 0, 0.0f, 0.0f };
+
+  const unsigned long nFrameCount = RCSwitch::nReceivedFrameCount;
+  const unsigned long nTriedCount = RCSwitch::nProtocolsTriedCount;
+  for (unsigned int nRound = 0; nRound < nRounds; nRound++) {
+    for (int nProtocol = 1; nProtocol <= nProtocols; nProtocol++) {
+      tx.setProtocol(nProtocol);
+      for (unsigned int n = 0; n < sizeof(codes) / sizeof(codes[0]); n++) {
+        tx.compileWaveform(codes[n], 24, waveform);
+        // the frame as handleInterrupt() holds it at the next sync gap
+        unsigned int nGap = 0;
+        for (unsigned int i = 1; i < waveform.count; i++) {
+          if (waveform.durations[i] > waveform.durations[nGap]) nGap = i;
+        }
+        for (unsigned int i = 0; i < waveform.count; i++) {
+          nRandom = nRandom * 1103515245 + 12345;
+          const int nPercent = (int)((nRandom >> 16) % 11) - 5;
+          const unsigned int duration = waveform.durations[(nGap + i) % waveform.count];
+          timings[i] = duration + (int)duration * nPercent / 100;
+        }
+        const uint8_t nStartLevel = ((nGap + 1) & 1) ? !waveform.firstLevel : waveform.firstLevel;
+
+        RCSwitch::nReceivedValue = 0;
+        RCSwitch::nReceivedProtocol = 0;
+        int nUnfiltered = 0;
+        for (int i = 1; i <= nProtocols && nUnfiltered == 0; i++) {
+          nTriedUnfiltered++;
+          if (RCSwitch::receiveProtocol(i, timings, waveform.count)) {
+            nUnfiltered = i;
+          }
+        }
+        const unsigned long nUnfilteredValue = RCSwitch::nReceivedValue;
+
+        RCSwitch::nReceivedValue = 0;
+        RCSwitch::nReceivedProtocol = 0;
+        const bool bDecoded = RCSwitch::decodeTimings(timings, waveform.count, nStartLevel);
+        assert(bDecoded == (nUnfiltered != 0));
+        assert(RCSwitch::nReceivedValue == nUnfilteredValue);
+        assert(!bDecoded || (int)RCSwitch::nReceivedProtocol == nUnfiltered);
+
+        result.frames++;
+        if (bDecoded && RCSwitch::nReceivedValue == codes[n]) {
+          result.decoded++;
+        }
+      }
+    }
+  }
+  RCSwitch::nReceivedValue = 0;
+
+  assert(RCSwitch::nReceivedFrameCount - nFrameCount == result.frames);
+  result.protocolsTried = (float)(RCSwitch::nProtocolsTriedCount - nTriedCount) / result.frames;
+  result.protocolsTriedUnfiltered = (float)nTriedUnfiltered / result.frames;
+  return result;
+}
+
+void RCSwitch_test::testCorpus() const {
+  const CorpusResult result = corpus();
+  assert(result.frames == 2400);
+  // protocols 8 and 9 don't decode with this jitter, prefiltered or not
+  assert(result.decoded == 2000);
+  assert(result.protocolsTried * 3 < result.protocolsTriedUnfiltered * 2);
+}
+
+void RCSwitch_test::run(int nTransmitterPin) const {
+  RCSwitch tx;
+  tx.enableTransmit(nTransmitterPin);
+
+  const int nRawCapturePin = RCSwitch::nRawCapturePin;
+  // the pin is not sampled, receive() passes the levels
+  RCSwitch::nRawCapturePin = nTransmitterPin;
+  tx.clearRawFrames();
+
+  testAsyncTransmit(tx);
+  testProtocolRoundTrip(tx);
+  testRawRoundTrip(tx);
+  testStretch(tx);
+  testNormalize(tx);
+  testTriState(tx);
+  testCorpus();
+
+  tx.clearRawFrames();
+  RCSwitch::nRawCapturePin = nRawCapturePin;
+}
+
+#endif
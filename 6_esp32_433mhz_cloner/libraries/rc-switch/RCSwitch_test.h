@@ -0,0 +1,83 @@
+/*
+  RCSwitch - Arduino libary for remote control outlet switches
+  Copyright (c) 2011 Suat Özgür.  All right reserved.
+
+  Project home: https://github.com/sui77/rc-switch/
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#ifndef _RCSwitch_test_h
+#define _RCSwitch_test_h
+
+#if !defined(ENABLE_RCSWITCH_WAVEFORM_TEST)
+#define ENABLE_RCSWITCH_WAVEFORM_TEST true
+#endif
+
+#if ENABLE_RCSWITCH_WAVEFORM_TEST && not defined( RCSwitchDisableReceiving )
+
+#include "RCSwitch.h"
+
+/**
+ * Round trip tests of the waveform engine. Waveforms are played by the
+ * transmit engine on a simulated timer, the recorded durations are fed
+ * to the interrupt handler as edges and decoded or captured.
+ * corpus() decodes a corpus of jittered frames with and without the
+ * protocol prefilter and reports the protocols tried per frame.
+ * The transmit engine is checked against the durations it arms the
+ * simulated timer with, including the completion callback.
+ * No radio and no real time are involved, the tests run on a host as well.
+ *
+ * The transmitter pin passed to run() is toggled, so it must not have a
+ * transmitter attached.
+ */
+class RCSwitch_test {
+  public:
+    /*
+     * Decode results of the test corpus: 24 bit frames of the protocols
+     * 1 to 12 with 4 codes each, the durations off by up to +/-5%.
+     */
+    struct CorpusResult {
+      unsigned long frames;
+      /* Frames decoded to the code they were sent with */
+      unsigned long decoded;
+      /* Protocols decoded bit by bit per frame, with and without the prefilter */
+      float protocolsTried;
+      float protocolsTriedUnfiltered;
+    };
+
+    void run(int nTransmitterPin) const;
+    CorpusResult corpus(unsigned int nRounds = 50) const;
+
+    static RCSwitch_test theTest;
+
+  private:
+    static void transmit(RCSwitch& tx, const RCSwitch::Waveform& waveform, int nRepeat);
+    static void receive(uint8_t nFirstLevel);
+    static bool equal(const RCSwitch::Waveform& a, const RCSwitch::Waveform& b);
+    static unsigned long triStateCode(const char* sCodeWord);
+    static void assertAddress(const char* sCodeWord, char type, char sFamily, int nGroup, int nDevice, bool bStatus);
+
+    void testAsyncTransmit(RCSwitch& tx) const;
+    void testProtocolRoundTrip(RCSwitch& tx) const;
+    void testRawRoundTrip(RCSwitch& tx) const;
+    void testStretch(RCSwitch& tx) const;
+    void testNormalize(RCSwitch& tx) const;
+    void testTriState(RCSwitch& tx) const;
+    void testCorpus() const;
+};
+
+#endif
+
+#endif